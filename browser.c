@@ -1057,22 +1057,22 @@ static int examine_mailboxes(struct Menu *menu, struct BrowserState *state)
 /**
  * select_file_search - Menu search callback for matching files - Implements Menu::menu_search()
  */
-static int select_file_search(struct Menu *menu, regex_t *rx, int line)
+static int select_file_search(struct Menu *menu, struct Regex *rx, int line)
 {
 #ifdef USE_NNTP
   if (OptNews)
-    return regexec(rx, ((struct FolderFile *) menu->data)[line].desc, 0, NULL, 0);
+    return mutt_regex_exec(rx, ((struct FolderFile *) menu->data)[line].desc, 0, NULL, 0);
 #endif
-  return regexec(rx, ((struct FolderFile *) menu->data)[line].name, 0, NULL, 0);
+  return mutt_regex_exec(rx, ((struct FolderFile *) menu->data)[line].name, 0, NULL, 0);
 }
 
 #ifdef USE_NOTMUCH
 /**
  * select_vfolder_search - Menu search callback for virtual folders - Implements Menu::menu_search()
  */
-static int select_vfolder_search(struct Menu *menu, regex_t *rx, int line)
+static int select_vfolder_search(struct Menu *menu, struct Regex *rx, int line)
 {
-  return regexec(rx, ((struct FolderFile *) menu->data)[line].desc, 0, NULL, 0);
+  return mutt_regex_exec(rx, ((struct FolderFile *) menu->data)[line].desc, 0, NULL, 0);
 }
 #endif
 
@@ -31,6 +31,7 @@
 #include "mutt.h"
 #include "color.h"
 #include "context.h"
+#include "curs_main.h"
 #include "globals.h"
 #include "keymap.h"
 #include "mailbox.h"
@@ -179,7 +180,7 @@ static void free_color_line(struct ColorLine *tmp, bool free_colors)
    * type for regular expressions.
    */
 
-  regfree(&tmp->regex);
+  mutt_regex_free(&tmp->regex);
   mutt_pattern_free(&tmp->color_pattern);
   FREE(&tmp->pattern);
   FREE(&tmp);
@@ -657,7 +658,7 @@ static int parse_uncolor(struct Buffer *buf, struct Buffer *s, unsigned long dat
     mutt_menu_set_redraw_full(MENU_MAIN);
     /* force re-caching of index colors */
     for (int i = 0; Context && i < Context->mailbox->msg_count; i++)
-      Context->mailbox->hdrs[i]->pair = 0;
+      mutt_reset_header_color(Context->mailbox->hdrs[i]);
   }
   return 0;
 }
@@ -762,13 +763,20 @@ static int add_pattern(struct ColorLineHead *top, const char *s, bool sensitive,
       else
         flags = REG_ICASE;
 
-      const int r = REGCOMP(&tmp->regex, s, flags);
+      struct Regex *rx = mutt_mem_calloc(1, sizeof(struct Regex));
+      rx->regex = mutt_mem_malloc(sizeof(regex_t));
+      const int r = REGCOMP(rx->regex, s, flags);
       if (r != 0)
       {
-        regerror(r, &tmp->regex, err->data, err->dsize);
+        regerror(r, rx->regex, err->data, err->dsize);
+        FREE(&rx->regex);
+        FREE(&rx);
         free_color_line(tmp, true);
         return -1;
       }
+      rx->pattern = mutt_str_strdup(s);
+      mutt_regex_prepare(rx, s, flags);
+      tmp->regex = rx;
     }
     tmp->pattern = mutt_str_strdup(s);
     tmp->match = match;
@@ -788,7 +796,7 @@ static int add_pattern(struct ColorLineHead *top, const char *s, bool sensitive,
   if (is_index)
   {
     for (int i = 0; Context && i < Context->mailbox->msg_count; i++)
-      Context->mailbox->hdrs[i]->pair = 0;
+      mutt_reset_header_color(Context->mailbox->hdrs[i]);
   }
 
   return 0;
@@ -38,6 +38,7 @@
 #include "context.h"
 #include "copy.h"
 #include "curs_lib.h"
+#include "curs_main.h"
 #include "filter.h"
 #include "format_flags.h"
 #include "globals.h"
@@ -212,7 +213,7 @@ int mutt_display_message(struct Email *cur)
 
     /* Remove color cache for this message, in case there
        are color patterns for both ~g and ~V */
-    cur->pair = 0;
+    mutt_reset_header_color(cur);
   }
 
   if (builtin)
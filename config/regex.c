@@ -33,7 +33,6 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "mutt/buffer.h"
-#include "mutt/mbyte.h"
 #include "mutt/memory.h"
 #include "mutt/regex3.h"
 #include "mutt/string2.h"
@@ -278,35 +277,7 @@ struct Regex *regex_create(const char *str, int flags, struct Buffer *err)
   if (!str)
     return NULL; /* LCOV_EXCL_LINE */
 
-  int rflags = 0;
-  struct Regex *reg = mutt_mem_calloc(1, sizeof(struct Regex));
-
-  reg->regex = mutt_mem_calloc(1, sizeof(regex_t));
-  reg->pattern = mutt_str_strdup(str);
-
-  /* Should we use smart case matching? */
-  if (((flags & DT_REGEX_MATCH_CASE) == 0) && mutt_mb_is_lower(str))
-    rflags |= REG_ICASE;
-
-  if ((flags & DT_REGEX_NOSUB))
-    rflags |= REG_NOSUB;
-
-  /* Is a prefix of '!' allowed? */
-  if (((flags & DT_REGEX_ALLOW_NOT) != 0) && (str[0] == '!'))
-  {
-    reg->not = true;
-    str++;
-  }
-
-  int rc = REGCOMP(reg->regex, str, rflags);
-  if ((rc != 0) && err)
-  {
-    regerror(rc, reg->regex, err->data, err->dsize);
-    regex_free(&reg);
-    return NULL;
-  }
-
-  return reg;
+  return mutt_regex_create(str, flags, err);
 }
 
 /**
@@ -318,9 +289,5 @@ void regex_free(struct Regex **r)
   if (!r || !*r)
     return; /* LCOV_EXCL_LINE */
 
-  FREE(&(*r)->pattern);
-  if ((*r)->regex)
-    regfree((*r)->regex);
-  FREE(&(*r)->regex);
-  FREE(r);
+  mutt_regex_free(r);
 }
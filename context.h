@@ -39,6 +39,9 @@ struct Context
   struct Email *last_tag;  /**< last tagged msg. used to link threads */
   struct MuttThread *tree;  /**< top of thread tree */
   struct Hash *thread_hash; /**< hash table for threading */
+  struct Hash *subj_index;  /**< emails by subject and date, for threading */
+  struct MuttThread **tree_cache; /**< threads whose trees have been drawn */
+  int tree_cache_next;            /**< next slot to use in tree_cache */
   int tagged;               /**< how many messages are tagged? */
   int new;                  /**< how many new messages? */
   int deleted;              /**< how many deleted messages */
@@ -0,0 +1,114 @@
+#!/bin/sh
+#
+# Copyright 2018 NeoMutt Team
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice,
+#    this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+#    this list of conditions and the following disclaimer in the documentation
+#    and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+# (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+# LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+# ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+
+usage()
+{
+    echo "Usage: $(basename "$0") -e <neomutts> -t <times> (-m <mailbox> | -g <count>)"
+    echo ""
+    echo "   -e List of neomutt executables to compare"
+    echo "   -t Number of times to repeat the test"
+    echo "   -m Path to a mailbox"
+    echo "   -g Generate an mbox containing this many small messages"
+    echo ""
+}
+
+while getopts e:m:t:g: OPT; do
+    case "$OPT" in
+        e)
+            NEOMUTTS="$OPTARG"
+            ;;
+        m)
+            MAILBOX="$OPTARG"
+            ;;
+        t)
+            TIMES="$OPTARG"
+            ;;
+        g)
+            GENERATE="$OPTARG"
+            ;;
+        *)
+            usage
+            exit 1
+    esac
+done
+
+if { [ -z "$MAILBOX" ] && [ -z "$GENERATE" ]; } || [ -z "$NEOMUTTS" ] || [ -z "$TIMES" ]; then
+    usage
+    exit 1
+fi
+
+CWD=$(dirname $(realpath $0))
+TMPDIR=$(mktemp -d)
+
+echo "Running in $TMPDIR"
+
+if [ -n "$GENERATE" ]; then
+    MAILBOX="$TMPDIR/generated.mbox"
+    echo "Generating $GENERATE messages"
+    awk -v count="$GENERATE" 'BEGIN {
+        for (i = 1; i <= count; i++) {
+            printf "From user%d@example.com Mon Jan  1 00:00:00 2018\n", i % 1000
+            printf "From: user%d@example.com\n", i % 1000
+            printf "Subject: message %d\n", i
+            printf "Message-ID: <%d@example.com>\n\n", i
+            printf "Body of message %d\n\n", i
+        }
+    }' > "$MAILBOX"
+fi
+
+exe()
+{
+    export my_mailbox="$MAILBOX"
+    t=$(time -p $1 -n -F "$CWD"/neomuttrc 2>&1 > /dev/null)
+    echo "$t" | xargs
+}
+
+extract()
+{
+    grep "^$1 " "$TMPDIR/result.txt" | awk "{print \$$2}" | xargs
+}
+
+avg()
+{
+    echo "3 k 0 $* $(printf "%*s" "$TIMES" "" | tr ' ' '+') $TIMES / p" | dc
+}
+
+width=${#TIMES}
+
+for i in $(seq "$TIMES"); do
+    for e in $NEOMUTTS; do
+        printf "%${width}d - $e\n" "$i"
+        echo "$e $(exe "$e")" >> "$TMPDIR"/result.txt
+    done
+done
+
+echo ""
+for e in $NEOMUTTS; do
+    real=$(avg "$(extract "$e" 3)")
+    user=$(avg "$(extract "$e" 5)")
+    sys=$(avg "$(extract "$e" 7)")
+    printf "%-30s" "$e"
+    echo "$real real $user user $sys sys"
+done
@@ -0,0 +1,136 @@
+#!/bin/sh
+#
+# Copyright 2018 NeoMutt Team
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice,
+#    this list of conditions and the following disclaimer.
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+#    this list of conditions and the following disclaimer in the documentation
+#    and/or other materials provided with the distribution.
+#
+# THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR ANY
+# DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+# (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+# LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+# ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+# SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+
+usage()
+{
+    echo "Usage: $(basename "$0") -e <neomutts> -m <mailbox> -t <times> [-r <rules>] [-p <pattern>]"
+    echo ""
+    echo "   -e List of neomutt executables to compare"
+    echo "   -m Path to a mailbox"
+    echo "   -t Number of times to repeat the test"
+    echo "   -r Config file of regex rules to load (default: rules.rc)"
+    echo "   -p Limit pattern to apply after the rules (default: ~b \"th(e|is) \")"
+    echo ""
+}
+
+CWD=$(dirname $(realpath $0))
+RULES="$CWD/rules.rc"
+PATTERN='~b "th(e|is) "'
+
+while getopts e:m:t:r:p: OPT; do
+    case "$OPT" in
+        e)
+            NEOMUTTS="$OPTARG"
+            ;;
+        m)
+            MAILBOX="$OPTARG"
+            ;;
+        t)
+            TIMES="$OPTARG"
+            ;;
+        r)
+            RULES="$OPTARG"
+            ;;
+        p)
+            PATTERN="$OPTARG"
+            ;;
+        *)
+            usage
+            exit 1
+    esac
+done
+
+if [ -z "$MAILBOX" ] || [ -z "$NEOMUTTS" ] || [ -z "$TIMES" ]; then
+    usage
+    exit 1
+fi
+
+TMPDIR=$(mktemp -d)
+
+echo "Running in $TMPDIR"
+
+# The colour rules only see the lines on screen, so each rule's regex is also
+# run as a limit, which matches it against every message
+limits()
+{
+    sed -nE 's/^color (index|body|header) [^ ]+ [^ ]+ (.*)$/\1 \2/p' "$RULES" |
+    while read -r obj regex; do
+        case "$obj" in
+            index)
+                regex=${regex#\"}
+                printf '<limit>%s<enter>' "${regex%\"}"
+                ;;
+            body)
+                printf '<limit>~b %s<enter>' "$regex"
+                ;;
+            header)
+                printf '<limit>~h %s<enter>' "$regex"
+                ;;
+        esac
+    done
+}
+
+LIMITS=$(limits)
+
+exe()
+{
+    # work on a copy, so that every run sees the same mailbox
+    rm -rf "$TMPDIR/mailbox"
+    cp -R "$MAILBOX" "$TMPDIR/mailbox"
+    export my_mailbox="$TMPDIR/mailbox"
+    export my_rules="$RULES"
+    export my_limits="$LIMITS"
+    export my_pattern="$PATTERN"
+    t=$(time -p $1 -n -F "$CWD"/neomuttrc 2>&1 > /dev/null)
+    echo "$t" | xargs
+}
+
+extract()
+{
+    grep "^$1 " "$TMPDIR/result.txt" | awk "{print \$$2}" | xargs
+}
+
+avg()
+{
+    echo "3 k 0 $* $(printf "%*s" "$TIMES" "" | tr ' ' '+') $TIMES / p" | dc
+}
+
+width=${#TIMES}
+
+for i in $(seq "$TIMES"); do
+    for e in $NEOMUTTS; do
+        printf "%${width}d - $e\n" "$i"
+        echo "$e $(exe "$e")" >> "$TMPDIR"/result.txt
+    done
+done
+
+echo ""
+for e in $NEOMUTTS; do
+    real=$(avg "$(extract "$e" 3)")
+    user=$(avg "$(extract "$e" 5)")
+    sys=$(avg "$(extract "$e" 7)")
+    printf "%-30s" "$e"
+    echo "$real real $user user $sys sys"
+done
@@ -640,6 +640,80 @@ static int main_change_folder(struct Menu *menu, int op, char *buf,
   return 0;
 }
 
+/**
+ * struct IndexRow - A formatted line of the index
+ *
+ * Formatting a line means expanding every expando of $index_format.  While
+ * the user is only moving around the index, nothing in the lines can change,
+ * so the lines that are still on screen are reused.
+ */
+struct IndexRow
+{
+  struct Email *email; ///< Email on the line
+  int flags;           ///< Format flags used, e.g. #MUTT_FORMAT_FORCESUBJ
+  int cols;            ///< Width of the index
+  size_t buflen;       ///< Length of the buffer it was formatted into
+  unsigned int gen;    ///< Value of IndexRowsGen when it was formatted
+  char *text;          ///< Formatted line
+};
+
+#define INDEX_ROWS 256 ///< Number of lines in the cache
+
+static struct IndexRow IndexRows[INDEX_ROWS];
+static unsigned int IndexRowsGen = 1;      ///< Lines from older generations are stale
+static struct Menu *IndexRowsMenu = NULL; ///< Index whose lines are cached
+
+/**
+ * index_rows_invalidate - Forget all the formatted lines of the index
+ */
+static void index_rows_invalidate(void)
+{
+  IndexRowsGen++;
+}
+
+/**
+ * index_rows_free - Free the formatted lines of the index
+ */
+static void index_rows_free(void)
+{
+  for (size_t i = 0; i < mutt_array_size(IndexRows); i++)
+    FREE(&IndexRows[i].text);
+  index_rows_invalidate();
+}
+
+/**
+ * index_op_keeps_rows - Does a function leave the index lines unchanged?
+ * @param op Function, e.g. OP_NEXT_PAGE
+ * @retval true The function only moves the cursor
+ */
+static bool index_op_keeps_rows(int op)
+{
+  switch (op)
+  {
+    case OP_BOTTOM_PAGE:
+    case OP_CURRENT_BOTTOM:
+    case OP_CURRENT_MIDDLE:
+    case OP_CURRENT_TOP:
+    case OP_FIRST_ENTRY:
+    case OP_HALF_DOWN:
+    case OP_HALF_UP:
+    case OP_LAST_ENTRY:
+    case OP_MAIN_NEXT_UNDELETED:
+    case OP_MAIN_PREV_UNDELETED:
+    case OP_MIDDLE_PAGE:
+    case OP_NEXT_ENTRY:
+    case OP_NEXT_LINE:
+    case OP_NEXT_PAGE:
+    case OP_PREV_ENTRY:
+    case OP_PREV_LINE:
+    case OP_PREV_PAGE:
+    case OP_TOP_PAGE:
+      return true;
+    default:
+      return false;
+  }
+}
+
 /**
  * index_make_entry - Format a menu item for the index list - Implements Menu::menu_make_entry()
  */
@@ -655,6 +729,9 @@ void index_make_entry(char *buf, size_t buflen, struct Menu *menu, int line)
   enum FormatFlag flag = MUTT_FORMAT_MAKEPRINT | MUTT_FORMAT_ARROWCURSOR | MUTT_FORMAT_INDEX;
   struct MuttThread *tmp = NULL;
 
+  if ((Sort & SORT_MASK) == SORT_THREADS)
+    mutt_draw_thread_tree(Context, e);
+
   if ((Sort & SORT_MASK) == SORT_THREADS && e->tree)
   {
     flag |= MUTT_FORMAT_TREE; /* display the thread tree */
@@ -709,7 +786,52 @@ void index_make_entry(char *buf, size_t buflen, struct Menu *menu, int line)
     }
   }
 
+  /* The pager's mini-index isn't cached, because the pager changes the
+   * emails without going through the index's event loop */
+  if (menu != IndexRowsMenu)
+  {
+    mutt_make_string_flags(buf, buflen, NONULL(IndexFormat), Context, e, flag);
+    return;
+  }
+
+  struct IndexRow *row = &IndexRows[line % INDEX_ROWS];
+  if (row->text && (row->gen == IndexRowsGen) && (row->email == e) &&
+      (row->flags == flag) && (row->cols == MuttIndexWindow->cols) &&
+      (row->buflen == buflen))
+  {
+    mutt_str_strfcpy(buf, row->text, buflen);
+    return;
+  }
+
   mutt_make_string_flags(buf, buflen, NONULL(IndexFormat), Context, e, flag);
+
+  row->email = e;
+  row->flags = flag;
+  row->cols = MuttIndexWindow->cols;
+  row->buflen = buflen;
+  row->gen = IndexRowsGen;
+  mutt_str_replace(&row->text, buf);
+}
+
+/**
+ * set_line_color - Select a colour for a line of the index
+ * @param ctx Mailbox
+ * @param e   Email
+ */
+static void set_line_color(struct Context *ctx, struct Email *e)
+{
+  struct ColorLine *color = NULL;
+  struct PatternCache cache = { 0 };
+
+  STAILQ_FOREACH(color, &ColorIndexList, entries)
+  {
+    if (mutt_pattern_exec(color->color_pattern, MUTT_MATCH_FULL_ADDRESS, ctx, e, &cache))
+    {
+      e->pair = color->pair;
+      return;
+    }
+  }
+  e->pair = ColorDefs[MT_COLOR_NORMAL];
 }
 
 /**
@@ -722,14 +844,12 @@ int index_color(int line)
 
   struct Email *e = Context->mailbox->hdrs[Context->mailbox->v2r[line]];
 
-  if (e && e->pair)
-    return e->pair;
-
-  mutt_set_header_color(Context, e);
-  if (e)
-    return e->pair;
+  if (!e)
+    return 0;
 
-  return 0;
+  if (!e->pair)
+    set_line_color(Context, e);
+  return e->pair;
 }
 
 /**
@@ -775,7 +895,7 @@ void mutt_draw_statusline(int cols, const char *buf, size_t buflen)
     {
       regmatch_t pmatch[cl->match + 1];
 
-      if (regexec(&cl->regex, buf + offset, cl->match + 1, pmatch, 0) != 0)
+      if (mutt_regex_exec(cl->regex, buf + offset, cl->match + 1, pmatch, 0) != 0)
         continue; /* regex doesn't match the status bar */
 
       int first = pmatch[cl->match].rm_so + offset;
@@ -968,6 +1088,7 @@ int mutt_index_menu(void)
   bool do_mailbox_notify = true;
   int close = 0; /* did we OP_QUIT or OP_EXIT out of this menu? */
   int attach_msg = OptAttachMsg;
+  bool keep_rows = false; /* did the last function only move the cursor? */
 
   struct Menu *menu = mutt_menu_new(MENU_MAIN);
   menu->menu_make_entry = index_make_entry;
@@ -982,6 +1103,10 @@ int mutt_index_menu(void)
   menu->menu_custom_redraw = index_custom_redraw;
   mutt_menu_push_current(menu);
 
+  struct Menu *old_rows_menu = IndexRowsMenu;
+  IndexRowsMenu = menu;
+  index_rows_free();
+
   if (!attach_msg)
   {
     /* force the mailbox check after we enter the folder */
@@ -999,6 +1124,11 @@ int mutt_index_menu(void)
 
   while (true)
   {
+    /* Any function, other than a movement, may change the index lines */
+    if (!keep_rows)
+      index_rows_invalidate();
+    keep_rows = false;
+
     /* Clear the tag prefix unless we just started it.  Don't clear
      * the prefix on a timeout (op==-2), but do clear on an abort (op==-1)
      */
@@ -1010,7 +1140,10 @@ int mutt_index_menu(void)
      * from any new menu launched, and change $sort/$sort_aux
      */
     if (OptNeedResort && Context && Context->mailbox->msg_count && menu->current >= 0)
+    {
       resort_index(menu);
+      index_rows_invalidate();
+    }
 
     menu->max = Context ? Context->mailbox->vcount : 0;
     oldcount = Context ? Context->mailbox->msg_count : 0;
@@ -1020,6 +1153,7 @@ int mutt_index_menu(void)
       mutt_draw_tree(Context);
       menu->redraw |= REDRAW_STATUS;
       OptRedrawTree = false;
+      index_rows_invalidate();
     }
 
     if (Context)
@@ -1039,6 +1173,8 @@ int mutt_index_menu(void)
                        0;
 
       check = mx_mbox_check(Context, &index_hint);
+      if (check != 0)
+        index_rows_invalidate();
       if (check < 0)
       {
         if (!Context->mailbox || Context->mailbox->path[0] == '\0')
@@ -1180,6 +1316,7 @@ int mutt_index_menu(void)
       }
 
       mutt_curs_set(1);
+      keep_rows = index_op_keeps_rows(op);
 
       /* special handling for the tag-prefix function */
       if (op == OP_TAG_PREFIX || op == OP_TAG_PREFIX_COND)
@@ -2001,6 +2138,7 @@ int mutt_index_menu(void)
             if (!Context->mailbox->quiet)
               mutt_progress_update(&progress, ++px, -1);
             mx_tags_commit(Context, Context->mailbox->hdrs[j], buf);
+            mutt_reset_header_color(Context->mailbox->hdrs[j]);
             if (op == OP_MAIN_MODIFY_TAGS_THEN_HIDE)
             {
               bool still_queried = false;
@@ -2026,6 +2164,7 @@ int mutt_index_menu(void)
             mutt_message(_("Failed to modify tags, aborting"));
             break;
           }
+          mutt_reset_header_color(CURHDR);
           if (op == OP_MAIN_MODIFY_TAGS_THEN_HIDE)
           {
             bool still_queried = false;
@@ -3503,33 +3642,43 @@ int mutt_index_menu(void)
       break;
   }
 
+  index_rows_free();
+  IndexRowsMenu = old_rows_menu;
+
   mutt_menu_pop_current(menu);
   mutt_menu_destroy(&menu);
   return close;
 }
 
+/**
+ * mutt_reset_header_color - Forget the colours of a message
+ * @param e Email
+ *
+ * The colours of the line, and of its fields, will be chosen again when the
+ * message is next displayed in the index.
+ */
+void mutt_reset_header_color(struct Email *e)
+{
+  e->pair = 0;
+  e->author_pair_valid = false;
+  e->subject_pair_valid = false;
+  e->flags_pair_valid = false;
+}
+
 /**
  * mutt_set_header_color - Select a colour for a message
  * @param ctx    Mailbox
  * @param curhdr Header of message
+ *
+ * The colours of its fields will be chosen again, too.
  */
 void mutt_set_header_color(struct Context *ctx, struct Email *curhdr)
 {
-  struct ColorLine *color = NULL;
-  struct PatternCache cache = { 0 };
-
   if (!curhdr)
     return;
 
-  STAILQ_FOREACH(color, &ColorIndexList, entries)
-  {
-    if (mutt_pattern_exec(color->color_pattern, MUTT_MATCH_FULL_ADDRESS, ctx, curhdr, &cache))
-    {
-      curhdr->pair = color->pair;
-      return;
-    }
-  }
-  curhdr->pair = ColorDefs[MT_COLOR_NORMAL];
+  mutt_reset_header_color(curhdr);
+  set_line_color(ctx, curhdr);
 }
 
 /**
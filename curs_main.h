@@ -44,6 +44,7 @@ int  index_color(int line);
 void index_make_entry(char *buf, size_t buflen, struct Menu *menu, int line);
 void mutt_draw_statusline(int cols, const char *buf, size_t buflen);
 int  mutt_index_menu(void);
+void mutt_reset_header_color(struct Email *e);
 void mutt_set_header_color(struct Context *ctx, struct Email *curhdr);
 void update_index(struct Menu *menu, struct Context *ctx, int check, int oldcount, int index_hint);
 
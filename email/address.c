@@ -33,6 +33,7 @@
 #include <string.h>
 #include "mutt/mutt.h"
 #include "address.h"
+#include "email_globals.h"
 #include "idna2.h"
 
 /**
@@ -74,9 +75,10 @@ static void free_address(struct Address **a)
 {
   if (!a || !*a)
     return;
-  FREE(&(*a)->personal);
-  FREE(&(*a)->mailbox);
-  FREE(a);
+  mutt_intern_free(&(*a)->personal);
+  mutt_intern_free(&(*a)->mailbox);
+  mutt_slab_free(*a, sizeof(struct Address));
+  *a = NULL;
 }
 
 /**
@@ -400,7 +402,7 @@ static void add_addrspec(struct Address **top, struct Address **last, const char
  */
 struct Address *mutt_addr_new(void)
 {
-  return mutt_mem_calloc(1, sizeof(struct Address));
+  return mutt_slab_alloc(EmailSlabPool, sizeof(struct Address));
 }
 
 /**
@@ -665,7 +667,7 @@ void mutt_addr_qualify(struct Address *addr, const char *host)
     {
       char *p = mutt_mem_malloc(mutt_str_strlen(addr->mailbox) + mutt_str_strlen(host) + 2);
       sprintf(p, "%s@%s", addr->mailbox, host);
-      FREE(&addr->mailbox);
+      mutt_intern_free(&addr->mailbox);
       addr->mailbox = p;
     }
   }
@@ -956,7 +958,7 @@ int mutt_addr_mbox_to_udomain(const char *mbox, char **user, char **domain)
  */
 void mutt_addr_set_intl(struct Address *a, char *intl_mailbox)
 {
-  FREE(&a->mailbox);
+  mutt_intern_free(&a->mailbox);
   a->mailbox = intl_mailbox;
   a->intl_checked = true;
   a->is_intl = true;
@@ -969,7 +971,7 @@ void mutt_addr_set_intl(struct Address *a, char *intl_mailbox)
  */
 void mutt_addr_set_local(struct Address *a, char *local_mailbox)
 {
-  FREE(&a->mailbox);
+  mutt_intern_free(&a->mailbox);
   a->mailbox = local_mailbox;
   a->intl_checked = true;
   a->is_intl = false;
@@ -1271,6 +1273,30 @@ int mutt_addrlist_to_local(struct Address *a)
   return 0;
 }
 
+/**
+ * mutt_addrlist_intern - Share the strings of an Address list
+ * @param a Address list to modify
+ *
+ * The names and mailboxes are replaced by shared copies (see @ref intern).
+ * This saves a lot of memory in mailboxes where the same people appear in the
+ * headers of many messages.
+ *
+ * @note The strings mustn't be modified in place afterwards.
+ */
+void mutt_addrlist_intern(struct Address *a)
+{
+  for (; a; a = a->next)
+  {
+    char *personal = mutt_intern_add(a->personal);
+    mutt_intern_free(&a->personal);
+    a->personal = personal;
+
+    char *mailbox = mutt_intern_add(a->mailbox);
+    mutt_intern_free(&a->mailbox);
+    a->mailbox = mailbox;
+  }
+}
+
 /**
  * mutt_addrlist_dedupe - Remove duplicate addresses
  * @param addr Address list to de-dupe
@@ -28,6 +28,8 @@
 
 /**
  * struct Address - An email address
+ *
+ * @note The strings may be shared, see mutt_addrlist_intern()
  */
 struct Address
 {
@@ -81,6 +83,7 @@ void            mutt_addr_set_local(struct Address *a, char *local_mailbox);
 bool            mutt_addr_valid_msgid(const char *msgid);
 size_t          mutt_addr_write(char *buf, size_t buflen, struct Address *addr, bool display);
 void            mutt_addr_write_single(char *buf, size_t buflen, struct Address *addr, bool display);
+void            mutt_addrlist_intern(struct Address *a);
 int             mutt_addrlist_to_intl(struct Address *a, char **err);
 int             mutt_addrlist_to_local(struct Address *a);
 
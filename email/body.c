@@ -32,6 +32,7 @@
 #include "mutt/mutt.h"
 #include "body.h"
 #include "email.h"
+#include "email_globals.h"
 #include "mime.h"
 #include "parameter.h"
 
@@ -41,7 +42,7 @@
  */
 struct Body *mutt_body_new(void)
 {
-  struct Body *p = mutt_mem_calloc(1, sizeof(struct Body));
+  struct Body *p = mutt_slab_alloc(EmailSlabPool, sizeof(struct Body));
 
   p->disposition = DISP_ATTACH;
   p->use_disp = true;
@@ -89,7 +90,7 @@ void mutt_body_free(struct Body **p)
     if (b->parts)
       mutt_body_free(&b->parts);
 
-    FREE(&b);
+    mutt_slab_free(b, sizeof(struct Body));
   }
 
   *p = 0;
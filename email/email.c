@@ -31,6 +31,7 @@
 #include "mutt/mutt.h"
 #include "email.h"
 #include "body.h"
+#include "email_globals.h"
 #include "envelope.h"
 #include "tags.h"
 
@@ -53,7 +54,8 @@ void mutt_email_free(struct Email **e)
   driver_tags_free(&(*e)->tags);
   if ((*e)->data && (*e)->free_data)
     (*e)->free_data(&(*e)->data);
-  FREE(e);
+  mutt_slab_free(*e, sizeof(struct Email));
+  *e = NULL;
 }
 
 /**
@@ -62,7 +64,7 @@ void mutt_email_free(struct Email **e)
  */
 struct Email *mutt_email_new(void)
 {
-  struct Email *e = mutt_mem_calloc(1, sizeof(struct Email));
+  struct Email *e = mutt_slab_alloc(EmailSlabPool, sizeof(struct Email));
 #ifdef MIXMASTER
   STAILQ_INIT(&e->chain);
 #endif
@@ -71,6 +71,11 @@ struct Email
   /* tells whether the attachment count is valid */
   bool attach_valid : 1;
 
+  /* tell whether the cached colours of the index fields are valid */
+  bool author_pair_valid : 1;
+  bool subject_pair_valid : 1;
+  bool flags_pair_valid : 1;
+
   /* the following are used to support collapsing threads  */
   bool collapsed : 1; /**< is this message part of a collapsed thread? */
   bool limited : 1;   /**< is this message in a limited view?  */
@@ -79,6 +84,9 @@ struct Email
   short recipient;    /**< user_is_recipient()'s return value, cached */
 
   int pair;           /**< color-pair to use when displaying in the index */
+  int author_pair;    /**< color-pair of the author in the index, if author_pair_valid */
+  int subject_pair;   /**< color-pair of the subject in the index, if subject_pair_valid */
+  int flags_pair;     /**< color-pair of the flags in the index, if flags_pair_valid */
 
   time_t date_sent;   /**< time when the message was sent (UTC) */
   time_t received;    /**< time when the message was placed in the mailbox */
@@ -42,3 +42,4 @@ struct RegexList NoSpamList = STAILQ_HEAD_INITIALIZER(NoSpamList);
 struct ReplaceList SpamList = STAILQ_HEAD_INITIALIZER(SpamList);
 struct ListHead Ignore = STAILQ_HEAD_INITIALIZER(Ignore);
 struct ListHead UnIgnore = STAILQ_HEAD_INITIALIZER(UnIgnore);
+struct SlabPool *EmailSlabPool = NULL; ///< Pool for new Emails, Envelopes, Bodys and Addresses, or NULL for malloc()
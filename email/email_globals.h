@@ -38,5 +38,6 @@ extern struct ListHead    Ignore;
 extern struct RegexList   NoSpamList;
 extern struct ReplaceList SpamList;
 extern struct ListHead    UnIgnore;
+extern struct SlabPool *  EmailSlabPool;
 
 #endif /* MUTT_EMAIL_EMAIL_GLOBALS_H */
@@ -32,6 +32,7 @@
 #include "mutt/mutt.h"
 #include "envelope.h"
 #include "address.h"
+#include "email_globals.h"
 
 /**
  * mutt_env_new - Create a new Envelope
@@ -39,7 +40,7 @@
  */
 struct Envelope *mutt_env_new(void)
 {
-  struct Envelope *e = mutt_mem_calloc(1, sizeof(struct Envelope));
+  struct Envelope *e = mutt_slab_alloc(EmailSlabPool, sizeof(struct Envelope));
   STAILQ_INIT(&e->references);
   STAILQ_INIT(&e->in_reply_to);
   STAILQ_INIT(&e->userhdrs);
@@ -84,7 +85,8 @@ void mutt_env_free(struct Envelope **p)
   mutt_list_free(&(*p)->references);
   mutt_list_free(&(*p)->in_reply_to);
   mutt_list_free(&(*p)->userhdrs);
-  FREE(p);
+  mutt_slab_free(*p, sizeof(struct Envelope));
+  *p = NULL;
 }
 
 /**
@@ -1080,6 +1080,17 @@ struct Envelope *mutt_rfc822_read_header(FILE *f, struct Email *e, bool user_hdr
     rfc2047_decode_addrlist(env->sender);
     rfc2047_decode_addrlist(env->x_original_to);
 
+    /* The same people appear in the headers of many messages */
+    mutt_addrlist_intern(env->from);
+    mutt_addrlist_intern(env->to);
+    mutt_addrlist_intern(env->cc);
+    mutt_addrlist_intern(env->bcc);
+    mutt_addrlist_intern(env->reply_to);
+    mutt_addrlist_intern(env->mail_followup_to);
+    mutt_addrlist_intern(env->return_path);
+    mutt_addrlist_intern(env->sender);
+    mutt_addrlist_intern(env->x_original_to);
+
     if (env->subject)
     {
       regmatch_t pmatch[1];
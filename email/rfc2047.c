@@ -754,9 +754,15 @@ void rfc2047_encode_addrlist(struct Address *addr, const char *tag)
   while (ptr)
   {
     if (ptr->personal)
+    {
+      mutt_intern_unshare(&ptr->personal);
       rfc2047_encode(&ptr->personal, AddressSpecials, col, SendCharset);
+    }
     else if (ptr->group && ptr->mailbox)
+    {
+      mutt_intern_unshare(&ptr->mailbox);
       rfc2047_encode(&ptr->mailbox, AddressSpecials, col, SendCharset);
+    }
     ptr = ptr->next;
   }
 }
@@ -771,10 +777,14 @@ void rfc2047_decode_addrlist(struct Address *a)
   {
     if (a->personal && ((strstr(a->personal, "=?")) || (AssumedCharset && *AssumedCharset)))
     {
+      mutt_intern_unshare(&a->personal);
       rfc2047_decode(&a->personal);
     }
     else if (a->group && a->mailbox && strstr(a->mailbox, "=?"))
+    {
+      mutt_intern_unshare(&a->mailbox);
       rfc2047_decode(&a->mailbox);
+    }
     a = a->next;
   }
 }
@@ -426,7 +426,7 @@ static void decode_uuencoded(struct State *s, long len, bool istext, iconv_t cd)
 static bool is_mmnoask(const char *buf)
 {
   char *p = NULL;
-  char tmp[LONG_STRING], *q = NULL;
+  char tmp[LONG_STRING], *q = NULL, *save = NULL;
 
   const char *val = mutt_str_getenv("MM_NOASK");
   if (!val)
@@ -438,7 +438,8 @@ static bool is_mmnoask(const char *buf)
   mutt_str_strfcpy(tmp, val, sizeof(tmp));
   p = tmp;
 
-  while ((p = strtok(p, ",")))
+  /* strtok_r() because searches may decode messages on several threads */
+  while ((p = strtok_r(p, ",", &save)))
   {
     q = strrchr(p, '/');
     if (q)
@@ -468,17 +469,19 @@ static bool is_mmnoask(const char *buf)
 }
 
 /**
- * is_autoview - Should email body be filtered by mailcap
- * @param b Body of the email
- * @retval 1 body part should be filtered by a mailcap entry prior to viewing inline
- * @retval 0 otherwise
+ * wants_autoview - Has the user asked for this type of body to be autoviewed
+ * @param b       Body of the email
+ * @param type    Buffer for the MIME type, e.g. "text/html"
+ * @param typelen Length of the buffer
+ * @retval true The type is on the auto_view list (or equivalent)
+ *
+ * This doesn't check for a matching mailcap entry, see is_autoview().
  */
-static bool is_autoview(struct Body *b)
+static bool wants_autoview(struct Body *b, char *type, size_t typelen)
 {
-  char type[SHORT_STRING];
   bool is_av = false;
 
-  snprintf(type, sizeof(type), "%s/%s", TYPE(b), b->subtype);
+  snprintf(type, typelen, "%s/%s", TYPE(b), b->subtype);
 
   if (ImplicitAutoview)
   {
@@ -488,7 +491,7 @@ static bool is_autoview(struct Body *b)
   else
   {
     /* determine if this type is on the user's auto_view list */
-    mutt_check_lookup_list(b, type, sizeof(type));
+    mutt_check_lookup_list(b, type, typelen);
     struct ListNode *np = NULL;
     STAILQ_FOREACH(np, &AutoViewList, entries)
     {
@@ -506,10 +509,23 @@ static bool is_autoview(struct Body *b)
       is_av = true;
   }
 
+  return is_av;
+}
+
+/**
+ * is_autoview - Should email body be filtered by mailcap
+ * @param b Body of the email
+ * @retval 1 body part should be filtered by a mailcap entry prior to viewing inline
+ * @retval 0 otherwise
+ */
+static bool is_autoview(struct Body *b)
+{
+  char type[SHORT_STRING];
+
   /* determine if there is a mailcap entry suitable for auto_view
    *
    * @warning type is altered by this call as a result of 'mime_lookup' support */
-  if (is_av)
+  if (wants_autoview(b, type, sizeof(type)))
     return rfc1524_mailcap_lookup(b, type, NULL, MUTT_AUTOVIEW);
 
   return false;
@@ -1714,6 +1730,64 @@ bool mutt_can_decode(struct Body *a)
   return false;
 }
 
+/**
+ * mutt_can_decode_concurrently - Can the Body be decoded away from the main thread
+ * @param b Body of email to test (MIME parts must already be parsed)
+ * @retval true mutt_body_handler() can process the Body on another thread
+ *
+ * This is true if decoding the Body only needs the handlers that work on the
+ * data alone.  Anything that may run an external program (autoview), call the
+ * crypto backends, or parse more MIME headers (encoded multiparts) must be
+ * handled by the main thread.
+ */
+bool mutt_can_decode_concurrently(struct Body *b)
+{
+  char type[SHORT_STRING];
+
+  for (; b; b = b->next)
+  {
+    if (wants_autoview(b, type, sizeof(type)))
+      return false;
+
+    switch (b->type)
+    {
+      case TYPE_TEXT:
+        if (((WithCrypto & APPLICATION_PGP) != 0) && mutt_is_application_pgp(b))
+          return false;
+        break;
+
+      case TYPE_MESSAGE:
+        if (mutt_str_strcasecmp("external-body", b->subtype) == 0)
+          return false;
+      /* fallthrough */
+      case TYPE_MULTIPART:
+        if ((b->encoding == ENC_BASE64) || (b->encoding == ENC_QUOTED_PRINTABLE) ||
+            (b->encoding == ENC_UUENCODED))
+        {
+          return false;
+        }
+        if ((b->type == TYPE_MULTIPART) &&
+            ((mutt_str_strcasecmp("encrypted", b->subtype) == 0) ||
+             (mutt_str_strcasecmp("multilingual", b->subtype) == 0)))
+        {
+          return false;
+        }
+        if (!mutt_can_decode_concurrently(b->parts))
+          return false;
+        break;
+
+      case TYPE_APPLICATION:
+        if (((WithCrypto & APPLICATION_PGP) != 0) && mutt_is_application_pgp(b))
+          return false;
+        if (((WithCrypto & APPLICATION_SMIME) != 0) && mutt_is_application_smime(b))
+          return false;
+        break;
+    }
+  }
+
+  return true;
+}
+
 /**
  * mutt_decode_attachment - Decode an email's attachment
  * @param b Body of the email
@@ -1726,9 +1800,9 @@ void mutt_decode_attachment(struct Body *b, struct State *s)
 
   if (istext && s->flags & MUTT_CHARCONV)
   {
-    char *charset = mutt_param_get(&b->parameter, "charset");
+    const char *charset = mutt_param_get(&b->parameter, "charset");
     if (!charset && AssumedCharset && *AssumedCharset)
-      charset = mutt_ch_get_default_charset();
+      charset = s->charset ? s->charset : mutt_ch_get_default_charset();
     if (charset && Charset)
       cd = mutt_ch_iconv_open(Charset, charset, MUTT_ICONV_HOOK_FROM);
   }
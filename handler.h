@@ -40,6 +40,7 @@ extern char *ShowMultipartAlternative;
 
 int  mutt_body_handler(struct Body *b, struct State *s);
 bool mutt_can_decode(struct Body *a);
+bool mutt_can_decode_concurrently(struct Body *b);
 void mutt_decode_attachment(struct Body *b, struct State *s);
 void mutt_decode_base64(struct State *s, size_t len, bool istext, iconv_t cd);
 
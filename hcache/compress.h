@@ -0,0 +1,88 @@
+/**
+ * @file
+ * API for the header cache compression
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MUTT_HCACHE_COMPRESS_H
+#define MUTT_HCACHE_COMPRESS_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+/**
+ * struct HcacheComprOps - Header Cache Compression API
+ */
+struct HcacheComprOps
+{
+  /**
+   * name - Compression method name
+   */
+  const char *name;
+  /**
+   * id - Identifier stored in every compressed record
+   *
+   * This value is written to disk, so it must never change.
+   */
+  unsigned int id;
+  /**
+   * min_level - Lowest compression level accepted by compress()
+   */
+  short min_level;
+  /**
+   * max_level - Highest compression level accepted by compress()
+   */
+  short max_level;
+  /**
+   * bound - Get the worst-case size of the compressed data
+   * @param slen Length of the data to compress
+   * @retval num Size of the buffer needed by compress()
+   */
+  size_t (*bound)(size_t slen);
+  /**
+   * compress - Compress a block of data
+   * @param src   Data to compress
+   * @param slen  Length of the data to compress
+   * @param dst   Buffer for the compressed data
+   * @param dlen  Length of the buffer, at least bound(slen)
+   * @param level Compression level, between min_level and max_level
+   * @retval num Length of the compressed data
+   * @retval 0   Error
+   */
+  size_t (*compress)(const void *src, size_t slen, void *dst, size_t dlen, short level);
+  /**
+   * decompress - Decompress a block of data
+   * @param src  Compressed data
+   * @param slen Length of the compressed data
+   * @param dst  Buffer for the uncompressed data
+   * @param dlen Exact length of the uncompressed data
+   * @retval true Success, the buffer has been filled
+   */
+  bool (*decompress)(const void *src, size_t slen, void *dst, size_t dlen);
+};
+
+#define HCACHE_COMPRESS_OPS(_name, _id, _min, _max)                            \
+  const struct HcacheComprOps hcache_compr_##_name##_ops = {                   \
+    .name       = #_name,                                                      \
+    .id         = _id,                                                         \
+    .min_level  = _min,                                                        \
+    .max_level  = _max,                                                        \
+    .bound      = compr_##_name##_bound,                                       \
+    .compress   = compr_##_name##_compress,                                    \
+    .decompress = compr_##_name##_decompress,                                  \
+  };
+
+#endif /* MUTT_HCACHE_COMPRESS_H */
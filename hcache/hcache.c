@@ -51,11 +51,14 @@
 #include <unistd.h>
 #include "mutt/mutt.h"
 #include "backend.h"
+#include "compress.h"
 #include "hcache.h"
 #include "hcache/hcversion.h"
 
 /* These Config Variables are only used in hcache/hcache.c */
 char *HeaderCacheBackend; ///< Config: (hcache) Header cache backend to use
+char *HeaderCacheCompressMethod; ///< Config: (hcache) Compression method for header cache records
+short HeaderCacheCompressLevel;  ///< Config: (hcache) Compression level for header cache records
 
 static unsigned int hcachever = 0x0;
 
@@ -68,7 +71,35 @@ HCACHE_BACKEND(qdbm)
 HCACHE_BACKEND(tokyocabinet)
 #undef HCACHE_BACKEND
 
+#define HCACHE_COMPRESS(name) extern const struct HcacheComprOps hcache_compr_##name##_ops;
+HCACHE_COMPRESS(lz4)
+HCACHE_COMPRESS(zlib)
+HCACHE_COMPRESS(zstd)
+#undef HCACHE_COMPRESS
+
 #define hcache_get_ops() hcache_get_backend_ops(HeaderCacheBackend)
+#define hcache_get_compr_ops() hcache_get_compr_ops_by_name(HeaderCacheCompressMethod)
+
+/**
+ * HCACHE_COMPRESSED - Mixed into the crc of compressed records
+ *
+ * Uncompressed records carry the plain crc, so they remain readable whatever
+ * the compression settings are.
+ */
+#define HCACHE_COMPRESSED 0x5a43c0deU
+
+/**
+ * struct ComprHeader - Header of a compressed record
+ *
+ * In a compressed record, this follows the validity datum and the crc.  The
+ * rest of the record, i.e. everything after the crc, is compressed.
+ */
+struct ComprHeader
+{
+  unsigned int id;   ///< Compression method, see HcacheComprOps::id
+  unsigned int ulen; ///< Length of the uncompressed data
+  unsigned int clen; ///< Length of the compressed data
+};
 
 /**
  * hcache_ops - Backend implementations
@@ -98,6 +129,22 @@ const struct HcacheOps *hcache_ops[] = {
   NULL,
 };
 
+/**
+ * hcache_compr_ops - Compression implementations
+ */
+const struct HcacheComprOps *hcache_compr_ops[] = {
+#ifdef HAVE_LZ4
+  &hcache_compr_lz4_ops,
+#endif
+#ifdef HAVE_ZLIB
+  &hcache_compr_zlib_ops,
+#endif
+#ifdef HAVE_ZSTD
+  &hcache_compr_zstd_ops,
+#endif
+  NULL,
+};
+
 /**
  * hcache_get_backend_ops - Get the API functions for an hcache backend
  * @param backend Name of the backend
@@ -119,6 +166,41 @@ static const struct HcacheOps *hcache_get_backend_ops(const char *backend)
   return *ops;
 }
 
+/**
+ * hcache_get_compr_ops_by_name - Get the API functions for a compression method
+ * @param name Name of the compression method
+ * @retval ptr  Set of function pointers
+ * @retval NULL Compression is disabled, or the method is unknown
+ */
+static const struct HcacheComprOps *hcache_get_compr_ops_by_name(const char *name)
+{
+  if (!name || !*name)
+    return NULL;
+
+  const struct HcacheComprOps **ops = hcache_compr_ops;
+  for (; *ops; ++ops)
+    if (strcmp(name, (*ops)->name) == 0)
+      break;
+
+  return *ops;
+}
+
+/**
+ * hcache_get_compr_ops_by_id - Get the compression method of a record
+ * @param id Identifier stored in the record
+ * @retval ptr  Set of function pointers
+ * @retval NULL The method isn't compiled in
+ */
+static const struct HcacheComprOps *hcache_get_compr_ops_by_id(unsigned int id)
+{
+  const struct HcacheComprOps **ops = hcache_compr_ops;
+  for (; *ops; ++ops)
+    if ((*ops)->id == id)
+      break;
+
+  return *ops;
+}
+
 /**
  * crc_matches - Is the CRC number correct?
  * @param d   Binary blob to read CRC from
@@ -249,6 +331,94 @@ static char *get_foldername(const char *folder)
   return p;
 }
 
+/**
+ * compress_record - Compress a serialised Email
+ * @param[in]  hc   Header cache handle
+ * @param[in]  cops Compression method
+ * @param[in]  data Record created by mutt_hcache_dump()
+ * @param[in]  dlen Length of the record
+ * @param[out] clen Length of the compressed record
+ * @retval ptr  Compressed record, to be freed by the caller
+ * @retval NULL Error, or compression didn't make the record smaller
+ */
+static void *compress_record(header_cache_t *hc, const struct HcacheComprOps *cops,
+                             const char *data, size_t dlen, size_t *clen)
+{
+  const size_t hlen = sizeof(union Validate) + sizeof(unsigned int);
+  if (dlen <= hlen)
+    return NULL;
+
+  struct ComprHeader ch = { 0 };
+  ch.id = cops->id;
+  ch.ulen = dlen - hlen;
+
+  size_t bound = cops->bound(ch.ulen);
+  if (bound == 0)
+    return NULL;
+
+  short level = HeaderCacheCompressLevel;
+  if (level < cops->min_level)
+    level = cops->min_level;
+  else if (level > cops->max_level)
+    level = cops->max_level;
+
+  char *c = mutt_mem_malloc(hlen + sizeof(ch) + bound);
+  size_t len = cops->compress(data + hlen, ch.ulen, c + hlen + sizeof(ch), bound, level);
+  if ((len == 0) || (len + sizeof(ch) >= ch.ulen))
+  {
+    FREE(&c);
+    return NULL;
+  }
+  ch.clen = len;
+
+  unsigned int crc = hc->crc ^ HCACHE_COMPRESSED;
+  memcpy(c, data, sizeof(union Validate));
+  memcpy(c + sizeof(union Validate), &crc, sizeof(crc));
+  memcpy(c + hlen, &ch, sizeof(ch));
+
+  *clen = hlen + sizeof(ch) + len;
+  return c;
+}
+
+/**
+ * decompress_record - Decompress a record from the database
+ * @param hc   Header cache handle
+ * @param data Compressed record
+ * @retval ptr  Uncompressed record, in a buffer owned by @a hc
+ * @retval NULL Error
+ *
+ * The uncompressed record is laid out exactly as mutt_hcache_dump() created
+ * it, so that mutt_hcache_restore() and the callers' validity checks work
+ * unchanged.
+ */
+static void *decompress_record(header_cache_t *hc, const char *data)
+{
+  const size_t hlen = sizeof(union Validate) + sizeof(unsigned int);
+  struct ComprHeader ch;
+  memcpy(&ch, data + hlen, sizeof(ch));
+
+  const struct HcacheComprOps *cops = hcache_get_compr_ops_by_id(ch.id);
+  if (!cops)
+  {
+    mutt_debug(2, "unknown compression method %u\n", ch.id);
+    return NULL;
+  }
+
+  if (hc->ubuflen < hlen + ch.ulen)
+  {
+    hc->ubuflen = hlen + ch.ulen;
+    mutt_mem_realloc(&hc->ubuf, hc->ubuflen);
+  }
+
+  char *u = hc->ubuf;
+  if (!cops->decompress(data + hlen + sizeof(ch), ch.clen, u + hlen, ch.ulen))
+    return NULL;
+
+  memcpy(u, data, sizeof(union Validate));
+  memcpy(u + sizeof(union Validate), &hc->crc, sizeof(hc->crc));
+  return u;
+}
+
 /**
  * mutt_hcache_open - Multiplexor for HcacheOps::open
  */
@@ -336,7 +506,11 @@ void mutt_hcache_close(header_cache_t *hc)
   if (!hc || !ops)
     return;
 
+  if (hc->batch)
+    mutt_hcache_commit(hc);
+
   ops->close(&hc->ctx);
+  FREE(&hc->ubuf);
   FREE(&hc->folder);
   FREE(&hc);
 }
@@ -346,19 +520,21 @@ void mutt_hcache_close(header_cache_t *hc)
  */
 void *mutt_hcache_fetch(header_cache_t *hc, const char *key, size_t keylen)
 {
-  void *data = mutt_hcache_fetch_raw(hc, key, keylen);
+  void *data = mutt_hcache_fetch_raw(hc, key, keylen, NULL);
   if (!data)
   {
     return NULL;
   }
 
-  if (!crc_matches(data, hc->crc))
-  {
-    mutt_hcache_free(hc, &data);
-    return NULL;
-  }
+  if (crc_matches(data, hc->crc))
+    return data;
 
-  return data;
+  void *udata = NULL;
+  if (crc_matches(data, hc->crc ^ HCACHE_COMPRESSED))
+    udata = decompress_record(hc, data);
+
+  mutt_hcache_free(hc, &data);
+  return udata;
 }
 
 /**
@@ -366,10 +542,12 @@ void *mutt_hcache_fetch(header_cache_t *hc, const char *key, size_t keylen)
  * @param hc     Header cache handle
  * @param key    A message identification string
  * @param keylen The length of the string pointed to by key
+ * @param dlen   Length of the data found, may be NULL
  */
-void *mutt_hcache_fetch_raw(header_cache_t *hc, const char *key, size_t keylen)
+void *mutt_hcache_fetch_raw(header_cache_t *hc, const char *key, size_t keylen, size_t *dlen)
 {
   char path[PATH_MAX];
+  size_t len = 0;
   const struct HcacheOps *ops = hcache_get_ops();
 
   if (!hc || !ops)
@@ -377,7 +555,10 @@ void *mutt_hcache_fetch_raw(header_cache_t *hc, const char *key, size_t keylen)
 
   keylen = snprintf(path, sizeof(path), "%s%s", hc->folder, key);
 
-  return ops->fetch(hc->ctx, path, keylen);
+  void *data = ops->fetch(hc->ctx, path, keylen, &len);
+  if (dlen)
+    *dlen = data ? len : 0;
+  return data;
 }
 
 /**
@@ -390,6 +571,13 @@ void mutt_hcache_free(header_cache_t *hc, void **data)
   if (!hc || !ops)
     return;
 
+  /* Decompressed records live in our own buffer */
+  if (data && *data && (*data == hc->ubuf))
+  {
+    *data = NULL;
+    return;
+  }
+
   ops->free(hc->ctx, data);
 }
 
@@ -407,6 +595,20 @@ int mutt_hcache_store(header_cache_t *hc, const char *key, size_t keylen,
     return -1;
 
   data = mutt_hcache_dump(hc, e, &dlen, uidvalidity);
+
+  const struct HcacheComprOps *cops = hcache_get_compr_ops();
+  if (cops)
+  {
+    size_t clen = 0;
+    char *cdata = compress_record(hc, cops, data, dlen, &clen);
+    if (cdata)
+    {
+      FREE(&data);
+      data = cdata;
+      dlen = clen;
+    }
+  }
+
   ret = mutt_hcache_store_raw(hc, key, keylen, data, dlen);
 
   FREE(&data);
@@ -454,6 +656,43 @@ int mutt_hcache_delete(header_cache_t *hc, const char *key, size_t keylen)
   return ops->delete (hc->ctx, path, keylen);
 }
 
+/**
+ * mutt_hcache_begin - Multiplexor for HcacheOps::begin
+ */
+int mutt_hcache_begin(header_cache_t *hc)
+{
+  const struct HcacheOps *ops = hcache_get_ops();
+
+  if (!hc || !ops)
+    return -1;
+
+  if (hc->batch)
+    return 0;
+
+  int rc = ops->begin(hc->ctx);
+  if (rc == 0)
+    hc->batch = true;
+
+  return rc;
+}
+
+/**
+ * mutt_hcache_commit - Multiplexor for HcacheOps::commit
+ */
+int mutt_hcache_commit(header_cache_t *hc)
+{
+  const struct HcacheOps *ops = hcache_get_ops();
+
+  if (!hc || !ops)
+    return -1;
+
+  if (!hc->batch)
+    return 0;
+
+  hc->batch = false;
+  return ops->commit(hc->ctx);
+}
+
 /**
  * mutt_hcache_backend_list - Get a list of backend names
  * @retval ptr Comma-space-separated list of names
@@ -487,3 +726,37 @@ bool mutt_hcache_is_valid_backend(const char *s)
 {
   return hcache_get_backend_ops(s);
 }
+
+/**
+ * mutt_hcache_compress_list - Get a list of compression method names
+ * @retval ptr Comma-space-separated list of names
+ *
+ * The caller should free the string.
+ */
+const char *mutt_hcache_compress_list(void)
+{
+  char tmp[STRING] = { 0 };
+  const struct HcacheComprOps **ops = hcache_compr_ops;
+  size_t len = 0;
+
+  for (; *ops; ++ops)
+  {
+    if (len != 0)
+    {
+      len += snprintf(tmp + len, STRING - len, ", ");
+    }
+    len += snprintf(tmp + len, STRING - len, "%s", (*ops)->name);
+  }
+
+  return mutt_str_strdup(tmp);
+}
+
+/**
+ * mutt_hcache_is_valid_compression - Is this a valid compression method name?
+ * @param s Name to check
+ * @retval true If valid
+ */
+bool mutt_hcache_is_valid_compression(const char *s)
+{
+  return hcache_get_compr_ops_by_name(s);
+}
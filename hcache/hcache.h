@@ -67,6 +67,9 @@ struct EmailCache
   char *folder;
   unsigned int crc;
   void *ctx;
+  bool batch; ///< A batch of updates has been started with mutt_hcache_begin()
+  void *ubuf;     ///< Buffer for decompressed records
+  size_t ubuflen; ///< Size of the decompression buffer
 };
 
 typedef struct EmailCache header_cache_t;
@@ -90,6 +93,8 @@ union Validate {
 
 /* These Config Variables are only used in hcache/hcache.c */
 extern char *HeaderCacheBackend;
+extern char *HeaderCacheCompressMethod;
+extern short HeaderCacheCompressLevel;
 
 /**
  * mutt_hcache_open - open the connection to the header cache
@@ -121,6 +126,10 @@ void mutt_hcache_close(header_cache_t *hc);
  *
  * @note The returned pointer must be freed by calling mutt_hcache_free. This
  *       must be done before closing the header cache with mutt_hcache_close.
+ *
+ * @note If the record was compressed, the returned data lives in a buffer
+ *       owned by @a hc, so it is only valid until the next call to
+ *       mutt_hcache_fetch.
  */
 void *mutt_hcache_fetch(header_cache_t *hc, const char *key, size_t keylen);
 
@@ -129,6 +138,7 @@ void *mutt_hcache_fetch(header_cache_t *hc, const char *key, size_t keylen);
  * @param hc     Pointer to the header_cache_t structure got by mutt_hcache_open
  * @param key    Message identification string
  * @param keylen Length of the string pointed to by key
+ * @param dlen   Length of the data found, may be NULL
  * @retval ptr  Success, the data if found
  * @retval NULL Otherwise
  *
@@ -137,7 +147,7 @@ void *mutt_hcache_fetch(header_cache_t *hc, const char *key, size_t keylen);
  * @note The returned pointer must be freed by calling mutt_hcache_free. This
  *       must be done before closing the header cache with mutt_hcache_close.
  */
-void *mutt_hcache_fetch_raw(header_cache_t *hc, const char *key, size_t keylen);
+void *mutt_hcache_fetch_raw(header_cache_t *hc, const char *key, size_t keylen, size_t *dlen);
 
 /**
  * mutt_hcache_free - free previously fetched data
@@ -192,6 +202,27 @@ int mutt_hcache_store_raw(header_cache_t *hc, const char *key, size_t keylen,
  */
 int mutt_hcache_delete(header_cache_t *hc, const char *key, size_t keylen);
 
+/**
+ * mutt_hcache_begin - start a batch of updates
+ * @param hc Pointer to the header_cache_t structure got by mutt_hcache_open
+ * @retval 0   Success
+ * @retval num Generic or backend-specific error code otherwise
+ *
+ * Until mutt_hcache_commit() is called, all the stores and deletes are
+ * grouped into a single backend transaction.  Starting a batch when one is
+ * already active does nothing.  mutt_hcache_close() commits any batch that is
+ * still pending.
+ */
+int mutt_hcache_begin(header_cache_t *hc);
+
+/**
+ * mutt_hcache_commit - finish a batch of updates
+ * @param hc Pointer to the header_cache_t structure got by mutt_hcache_open
+ * @retval 0   Success
+ * @retval num Generic or backend-specific error code otherwise
+ */
+int mutt_hcache_commit(header_cache_t *hc);
+
 /**
  * mutt_hcache_backend_list - get a list of backend identification strings
  * @retval ptr Comma separated string describing the compiled-in backends
@@ -208,4 +239,20 @@ const char *mutt_hcache_backend_list(void);
  */
 bool mutt_hcache_is_valid_backend(const char *s);
 
+/**
+ * mutt_hcache_compress_list - get a list of compression method names
+ * @retval ptr Comma separated string of the compiled-in compression methods
+ *
+ * @note The returned string must be free'd by the caller
+ */
+const char *mutt_hcache_compress_list(void);
+
+/**
+ * mutt_hcache_is_valid_compression - Is the string a valid compression method
+ * @param s String identifying a compression method
+ * @retval true  s is recognized as a valid compression method
+ * @retval false otherwise
+ */
+bool mutt_hcache_is_valid_compression(const char *s);
+
 #endif /* MUTT_HCACHE_HCACHE_H */
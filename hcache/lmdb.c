@@ -173,7 +173,7 @@ fail_env:
 /**
  * hcache_lmdb_fetch - Implements HcacheOps::fetch()
  */
-static void *hcache_lmdb_fetch(void *vctx, const char *key, size_t keylen)
+static void *hcache_lmdb_fetch(void *vctx, const char *key, size_t keylen, size_t *dlen)
 {
   MDB_val dkey;
   MDB_val data;
@@ -206,6 +206,7 @@ static void *hcache_lmdb_fetch(void *vctx, const char *key, size_t keylen)
     return NULL;
   }
 
+  *dlen = data.mv_size;
   return data.mv_data;
 }
 
@@ -285,6 +286,45 @@ static int hcache_lmdb_delete(void *vctx, const char *key, size_t keylen)
   return rc;
 }
 
+/**
+ * hcache_lmdb_begin - Implements HcacheOps::begin()
+ */
+static int hcache_lmdb_begin(void *vctx)
+{
+  if (!vctx)
+    return -1;
+
+  struct HcacheLmdbCtx *ctx = vctx;
+
+  int rc = mdb_get_w_txn(ctx);
+  if (rc != MDB_SUCCESS)
+    mutt_debug(2, "mdb_get_w_txn: %s\n", mdb_strerror(rc));
+
+  return rc;
+}
+
+/**
+ * hcache_lmdb_commit - Implements HcacheOps::commit()
+ */
+static int hcache_lmdb_commit(void *vctx)
+{
+  if (!vctx)
+    return -1;
+
+  struct HcacheLmdbCtx *ctx = vctx;
+
+  if (!ctx->txn || (ctx->txn_mode != TXN_WRITE))
+    return MDB_SUCCESS;
+
+  int rc = mdb_txn_commit(ctx->txn);
+  if (rc != MDB_SUCCESS)
+    mutt_debug(2, "mdb_txn_commit: %s\n", mdb_strerror(rc));
+
+  ctx->txn_mode = TXN_UNINITIALIZED;
+  ctx->txn = NULL;
+  return rc;
+}
+
 /**
  * hcache_lmdb_close - Implements HcacheOps::close()
  */
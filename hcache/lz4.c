@@ -0,0 +1,85 @@
+/**
+ * @file
+ * LZ4 compression of header cache records
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page hc_lz4 LZ4 compression
+ *
+ * Use LZ4 to compress the records of the header cache.
+ *
+ * LZ4 has no compression levels as such, so the level is used as the
+ * acceleration factor: higher values are faster, but compress less.
+ */
+
+#include "config.h"
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <lz4.h>
+#include "mutt/mutt.h"
+#include "compress.h"
+
+/**
+ * compr_lz4_bound - Implements HcacheComprOps::bound()
+ */
+static size_t compr_lz4_bound(size_t slen)
+{
+  if (slen > LZ4_MAX_INPUT_SIZE)
+    return 0;
+
+  return LZ4_compressBound(slen);
+}
+
+/**
+ * compr_lz4_compress - Implements HcacheComprOps::compress()
+ */
+static size_t compr_lz4_compress(const void *src, size_t slen, void *dst,
+                                 size_t dlen, short level)
+{
+  if ((slen > LZ4_MAX_INPUT_SIZE) || (dlen > INT_MAX))
+    return 0;
+
+  int len = LZ4_compress_fast(src, dst, slen, dlen, level);
+  if (len <= 0)
+  {
+    mutt_debug(2, "LZ4_compress_fast failed\n");
+    return 0;
+  }
+
+  return len;
+}
+
+/**
+ * compr_lz4_decompress - Implements HcacheComprOps::decompress()
+ */
+static bool compr_lz4_decompress(const void *src, size_t slen, void *dst, size_t dlen)
+{
+  if ((slen > INT_MAX) || (dlen > INT_MAX))
+    return false;
+
+  int len = LZ4_decompress_safe(src, dst, slen, dlen);
+  if (len < 0)
+  {
+    mutt_debug(2, "LZ4_decompress_safe failed: %d\n", len);
+    return false;
+  }
+
+  return (size_t) len == dlen;
+}
+
+HCACHE_COMPRESS_OPS(lz4, 2, 1, 12)
@@ -228,6 +228,7 @@ unsigned char *serial_dump_address(struct Address *a, unsigned char *d, int *off
  */
 void serial_restore_address(struct Address **a, const unsigned char *d, int *off, bool convert)
 {
+  struct Address **head = a;
   unsigned int counter = 0;
   unsigned int g = 0;
 
@@ -245,6 +246,7 @@ void serial_restore_address(struct Address **a, const unsigned char *d, int *off
   }
 
   *a = NULL;
+  mutt_addrlist_intern(*head);
 }
 
 /**
@@ -607,6 +609,9 @@ void *mutt_hcache_dump(header_cache_t *hc, const struct Email *e, int *off, unsi
   nh.num_hidden = 0;
   nh.recipient = 0;
   nh.pair = 0;
+  nh.author_pair_valid = false;
+  nh.subject_pair_valid = false;
+  nh.flags_pair_valid = false;
   nh.attach_valid = false;
   nh.path = NULL;
   nh.tree = NULL;
@@ -62,15 +62,18 @@ static void *hcache_tokyocabinet_open(const char *path)
 /**
  * hcache_tokyocabinet_fetch - Implements HcacheOps::fetch()
  */
-static void *hcache_tokyocabinet_fetch(void *ctx, const char *key, size_t keylen)
+static void *hcache_tokyocabinet_fetch(void *ctx, const char *key, size_t keylen,
+                                       size_t *dlen)
 {
-  int sp;
+  int sp = 0;
 
   if (!ctx)
     return NULL;
 
   TCBDB *db = ctx;
-  return tcbdbget(db, key, keylen, &sp);
+  void *data = tcbdbget(db, key, keylen, &sp);
+  *dlen = sp;
+  return data;
 }
 
 /**
@@ -116,6 +119,42 @@ static int hcache_tokyocabinet_delete(void *ctx, const char *key, size_t keylen)
   return 0;
 }
 
+/**
+ * hcache_tokyocabinet_begin - Implements HcacheOps::begin()
+ */
+static int hcache_tokyocabinet_begin(void *ctx)
+{
+  if (!ctx)
+    return -1;
+
+  TCBDB *db = ctx;
+  if (!tcbdbtranbegin(db))
+  {
+    int ecode = tcbdbecode(db);
+    mutt_debug(2, "tcbdbtranbegin failed: %s (ecode %d)\n", tcbdberrmsg(ecode), ecode);
+    return ecode ? ecode : -1;
+  }
+  return 0;
+}
+
+/**
+ * hcache_tokyocabinet_commit - Implements HcacheOps::commit()
+ */
+static int hcache_tokyocabinet_commit(void *ctx)
+{
+  if (!ctx)
+    return -1;
+
+  TCBDB *db = ctx;
+  if (!tcbdbtrancommit(db))
+  {
+    int ecode = tcbdbecode(db);
+    mutt_debug(2, "tcbdbtrancommit failed: %s (ecode %d)\n", tcbdberrmsg(ecode), ecode);
+    return ecode ? ecode : -1;
+  }
+  return 0;
+}
+
 /**
  * hcache_tokyocabinet_close - Implements HcacheOps::close()
  */
@@ -0,0 +1,76 @@
+/**
+ * @file
+ * Zlib compression of header cache records
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page hc_zlib Zlib compression
+ *
+ * Use zlib to compress the records of the header cache.
+ */
+
+#include "config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <zlib.h>
+#include "mutt/mutt.h"
+#include "compress.h"
+
+/**
+ * compr_zlib_bound - Implements HcacheComprOps::bound()
+ */
+static size_t compr_zlib_bound(size_t slen)
+{
+  return compressBound(slen);
+}
+
+/**
+ * compr_zlib_compress - Implements HcacheComprOps::compress()
+ */
+static size_t compr_zlib_compress(const void *src, size_t slen, void *dst,
+                                  size_t dlen, short level)
+{
+  uLongf len = dlen;
+
+  int rc = compress2(dst, &len, src, slen, level);
+  if (rc != Z_OK)
+  {
+    mutt_debug(2, "compress2: %s\n", zError(rc));
+    return 0;
+  }
+
+  return len;
+}
+
+/**
+ * compr_zlib_decompress - Implements HcacheComprOps::decompress()
+ */
+static bool compr_zlib_decompress(const void *src, size_t slen, void *dst, size_t dlen)
+{
+  uLongf len = dlen;
+
+  int rc = uncompress(dst, &len, src, slen);
+  if (rc != Z_OK)
+  {
+    mutt_debug(2, "uncompress: %s\n", zError(rc));
+    return false;
+  }
+
+  return len == dlen;
+}
+
+HCACHE_COMPRESS_OPS(zlib, 1, 1, 9)
@@ -0,0 +1,72 @@
+/**
+ * @file
+ * Zstandard compression of header cache records
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page hc_zstd Zstandard compression
+ *
+ * Use Zstandard to compress the records of the header cache.
+ */
+
+#include "config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <zstd.h>
+#include "mutt/mutt.h"
+#include "compress.h"
+
+/**
+ * compr_zstd_bound - Implements HcacheComprOps::bound()
+ */
+static size_t compr_zstd_bound(size_t slen)
+{
+  return ZSTD_compressBound(slen);
+}
+
+/**
+ * compr_zstd_compress - Implements HcacheComprOps::compress()
+ */
+static size_t compr_zstd_compress(const void *src, size_t slen, void *dst,
+                                  size_t dlen, short level)
+{
+  size_t len = ZSTD_compress(dst, dlen, src, slen, level);
+  if (ZSTD_isError(len))
+  {
+    mutt_debug(2, "ZSTD_compress: %s\n", ZSTD_getErrorName(len));
+    return 0;
+  }
+
+  return len;
+}
+
+/**
+ * compr_zstd_decompress - Implements HcacheComprOps::decompress()
+ */
+static bool compr_zstd_decompress(const void *src, size_t slen, void *dst, size_t dlen)
+{
+  size_t len = ZSTD_decompress(dst, dlen, src, slen);
+  if (ZSTD_isError(len))
+  {
+    mutt_debug(2, "ZSTD_decompress: %s\n", ZSTD_getErrorName(len));
+    return false;
+  }
+
+  return len == dlen;
+}
+
+HCACHE_COMPRESS_OPS(zstd, 3, 1, 22)
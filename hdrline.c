@@ -25,6 +25,7 @@
 #include "config.h"
 #include <locale.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -71,6 +72,47 @@ enum FlagChars
   FlagCharZEmpty
 };
 
+/* Flags for the results in ListCache */
+#define LIST_MAIL       (1 << 0) ///< The address is a mailing list
+#define LIST_SUBSCRIBED (1 << 1) ///< The address is a subscribed mailing list
+#define LIST_MAIL_KNOWN (1 << 2) ///< LIST_MAIL has been set, or not
+#define LIST_SUB_KNOWN  (1 << 3) ///< LIST_SUBSCRIBED has been set, or not
+
+#define LIST_CACHE_MAX 65536 ///< Most addresses to remember
+
+/* The same few addresses appear in many messages.  Matching each one against
+ * every 'lists' and 'subscribe' regex is expensive, so the results are kept,
+ * keyed by the mailbox.  All the regexes are case-insensitive. */
+static struct Hash *ListCache = NULL;
+
+/**
+ * list_cache_elem - Find the cached results for an address
+ * @param mailbox Email address
+ * @retval ptr Hash table element, the data holds LIST_* flags
+ */
+static struct HashElem *list_cache_elem(const char *mailbox)
+{
+  if (ListCache && (ListCache->count >= LIST_CACHE_MAX))
+    mutt_hash_destroy(&ListCache);
+  if (!ListCache)
+    ListCache = mutt_hash_create(1024, MUTT_HASH_STRCASECMP | MUTT_HASH_STRDUP_KEYS);
+
+  struct HashElem *he = mutt_hash_find_elem(ListCache, mailbox);
+  if (!he)
+    he = mutt_hash_insert(ListCache, mailbox, NULL);
+  return he;
+}
+
+/**
+ * mutt_clear_list_cache - Forget which addresses are mailing lists
+ *
+ * This must be called when the 'lists' or 'subscribe' lists change.
+ */
+void mutt_clear_list_cache(void)
+{
+  mutt_hash_destroy(&ListCache);
+}
+
 /**
  * mutt_is_mail_list - Is this the email address of a mailing list?
  * @param addr Address to test
@@ -78,9 +120,23 @@ enum FlagChars
  */
 bool mutt_is_mail_list(struct Address *addr)
 {
-  if (!mutt_regexlist_match(&UnMailLists, addr->mailbox))
-    return mutt_regexlist_match(&MailLists, addr->mailbox);
-  return false;
+  if (!addr->mailbox)
+    return false;
+
+  struct HashElem *he = list_cache_elem(addr->mailbox);
+  intptr_t flags = (intptr_t) he->data;
+  if (!(flags & LIST_MAIL_KNOWN))
+  {
+    flags |= LIST_MAIL_KNOWN;
+    if (!mutt_regexlist_match(&UnMailLists, addr->mailbox) &&
+        mutt_regexlist_match(&MailLists, addr->mailbox))
+    {
+      flags |= LIST_MAIL;
+    }
+    he->data = (void *) flags;
+  }
+
+  return flags & LIST_MAIL;
 }
 
 /**
@@ -90,12 +146,24 @@ bool mutt_is_mail_list(struct Address *addr)
  */
 bool mutt_is_subscribed_list(struct Address *addr)
 {
-  if (!mutt_regexlist_match(&UnMailLists, addr->mailbox) &&
-      !mutt_regexlist_match(&UnSubscribedLists, addr->mailbox))
+  if (!addr->mailbox)
+    return false;
+
+  struct HashElem *he = list_cache_elem(addr->mailbox);
+  intptr_t flags = (intptr_t) he->data;
+  if (!(flags & LIST_SUB_KNOWN))
   {
-    return mutt_regexlist_match(&SubscribedLists, addr->mailbox);
+    flags |= LIST_SUB_KNOWN;
+    if (!mutt_regexlist_match(&UnMailLists, addr->mailbox) &&
+        !mutt_regexlist_match(&UnSubscribedLists, addr->mailbox) &&
+        mutt_regexlist_match(&SubscribedLists, addr->mailbox))
+    {
+      flags |= LIST_SUBSCRIBED;
+    }
+    he->data = (void *) flags;
   }
-  return false;
+
+  return flags & LIST_SUBSCRIBED;
 }
 
 /**
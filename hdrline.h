@@ -46,6 +46,7 @@ struct HdrFormatInfo
   const char *pager_progress;
 };
 
+void mutt_clear_list_cache(void);
 bool mutt_is_mail_list(struct Address *addr);
 bool mutt_is_subscribed_list(struct Address *addr);
 void mutt_make_string_flags(char *buf, size_t buflen, const char *s, struct Context *ctx, struct Email *e, enum FormatFlag flags);
@@ -1634,9 +1634,9 @@ struct ImapStatus *imap_mboxcache_get(struct ImapAccountData *adata,
   header_cache_t *hc = imap_hcache_open(adata, mbox);
   if (hc)
   {
-    void *uidvalidity = mutt_hcache_fetch_raw(hc, "/UIDVALIDITY", 12);
-    void *uidnext = mutt_hcache_fetch_raw(hc, "/UIDNEXT", 8);
-    unsigned long long *modseq = mutt_hcache_fetch_raw(hc, "/MODSEQ", 7);
+    void *uidvalidity = mutt_hcache_fetch_raw(hc, "/UIDVALIDITY", 12, NULL);
+    void *uidnext = mutt_hcache_fetch_raw(hc, "/UIDNEXT", 8, NULL);
+    unsigned long long *modseq = mutt_hcache_fetch_raw(hc, "/MODSEQ", 7, NULL);
     if (uidvalidity)
     {
       if (!status)
@@ -2426,10 +2426,8 @@ static int imap_mbox_open(struct Context *ctx)
     ctx->mailbox->readonly = true;
   }
 
-  ctx->mailbox->hdrmax = count;
-  ctx->mailbox->hdrs = mutt_mem_calloc(count, sizeof(struct Email *));
-  ctx->mailbox->v2r = mutt_mem_calloc(count, sizeof(int));
   ctx->mailbox->msg_count = 0;
+  mx_reserve_memory(ctx->mailbox, count);
 
   if (count && (imap_read_headers(adata, 1, count, true) < 0))
   {
@@ -919,6 +919,7 @@ static int read_headers_condstore_qresync_updates(struct ImapAccountData *adata,
     imap_hcache_close(adata);
     imap_expunge_mailbox(adata);
     adata->hcache = imap_hcache_open(adata, NULL);
+    mutt_hcache_begin(adata->hcache);
     adata->reopen &= ~IMAP_EXPUNGE_PENDING;
   }
 
@@ -1117,8 +1118,7 @@ static int read_headers_fetch_new(struct ImapAccountData *adata, unsigned int ms
       fetch_msn_end = adata->max_msn;
       msn_begin = adata->max_msn + 1;
       msn_end = adata->new_mail_count;
-      while (msn_end > ctx->mailbox->hdrmax)
-        mx_alloc_memory(ctx->mailbox);
+      mx_reserve_memory(ctx->mailbox, msn_end);
       alloc_msn_index(adata, msn_end);
       adata->reopen &= ~IMAP_NEWMAIL_PENDING;
       adata->new_mail_count = 0;
@@ -1172,8 +1172,7 @@ int imap_read_headers(struct ImapAccountData *adata, unsigned int msn_begin,
   struct Context *ctx = adata->ctx;
 
   /* make sure context has room to hold the mailbox */
-  while (msn_end > ctx->mailbox->hdrmax)
-    mx_alloc_memory(ctx->mailbox);
+  mx_reserve_memory(ctx->mailbox, msn_end);
   alloc_msn_index(adata, msn_end);
   imap_alloc_uid_hash(adata, msn_end);
 
@@ -1183,11 +1182,13 @@ int imap_read_headers(struct ImapAccountData *adata, unsigned int msn_begin,
 
 #ifdef USE_HCACHE
   adata->hcache = imap_hcache_open(adata, NULL);
+  /* Group all the header stores into a single transaction */
+  mutt_hcache_begin(adata->hcache);
 
   if (adata->hcache && initial_download)
   {
-    uid_validity = mutt_hcache_fetch_raw(adata->hcache, "/UIDVALIDITY", 12);
-    puidnext = mutt_hcache_fetch_raw(adata->hcache, "/UIDNEXT", 8);
+    uid_validity = mutt_hcache_fetch_raw(adata->hcache, "/UIDVALIDITY", 12, NULL);
+    puidnext = mutt_hcache_fetch_raw(adata->hcache, "/UIDNEXT", 8, NULL);
     if (puidnext)
     {
       uidnext = *(unsigned int *) puidnext;
@@ -1210,7 +1211,7 @@ int imap_read_headers(struct ImapAccountData *adata, unsigned int msn_begin,
     if (uid_validity && uidnext && (*(unsigned int *) uid_validity == adata->uid_validity))
     {
       evalhc = true;
-      pmodseq = mutt_hcache_fetch_raw(adata->hcache, "/MODSEQ", 7);
+      pmodseq = mutt_hcache_fetch_raw(adata->hcache, "/MODSEQ", 7, NULL);
       if (pmodseq)
       {
         hc_modseq = *pmodseq;
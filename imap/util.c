@@ -457,7 +457,7 @@ char *imap_hcache_get_uid_seqset(struct ImapAccountData *adata)
   if (!adata->hcache)
     return NULL;
 
-  char *hc_seqset = mutt_hcache_fetch_raw(adata->hcache, "/UIDSEQSET", 10);
+  char *hc_seqset = mutt_hcache_fetch_raw(adata->hcache, "/UIDSEQSET", 10, NULL);
   char *seqset = mutt_str_strdup(hc_seqset);
   mutt_hcache_free(adata->hcache, (void **) &hc_seqset);
   mutt_debug(5, "Retrieved /UIDSEQSET %s\n", NONULL(seqset));
@@ -44,6 +44,7 @@
 #include "filter.h"
 #include "group.h"
 #include "hcache/hcache.h"
+#include "hdrline.h"
 #include "keymap.h"
 #include "menu.h"
 #include "mutt_curses.h"
@@ -1291,6 +1292,8 @@ static int parse_lists(struct Buffer *buf, struct Buffer *s, unsigned long data,
 {
   struct GroupContext *gc = NULL;
 
+  mutt_clear_list_cache();
+
   do
   {
     mutt_extract_token(buf, s, 0);
@@ -1967,6 +1970,8 @@ static int parse_subscribe(struct Buffer *buf, struct Buffer *s,
 {
   struct GroupContext *gc = NULL;
 
+  mutt_clear_list_cache();
+
   do
   {
     mutt_extract_token(buf, s, 0);
@@ -2268,6 +2273,8 @@ static int parse_unignore(struct Buffer *buf, struct Buffer *s,
 static int parse_unlists(struct Buffer *buf, struct Buffer *s,
                          unsigned long data, struct Buffer *err)
 {
+  mutt_clear_list_cache();
+
   do
   {
     mutt_extract_token(buf, s, 0);
@@ -2362,6 +2369,8 @@ static int parse_unsubjectrx_list(struct Buffer *buf, struct Buffer *s,
 static int parse_unsubscribe(struct Buffer *buf, struct Buffer *s,
                              unsigned long data, struct Buffer *err)
 {
+  mutt_clear_list_cache();
+
   do
   {
     mutt_extract_token(buf, s, 0);
@@ -2784,6 +2793,7 @@ void mutt_free_opts(void)
   mutt_regexlist_free(&UnAlternates);
   mutt_regexlist_free(&UnMailLists);
   mutt_regexlist_free(&UnSubscribedLists);
+  mutt_clear_list_cache();
 
   mutt_hash_destroy(&Groups);
   mutt_hash_destroy(&ReverseAliases);
@@ -3737,6 +3747,24 @@ int hcache_validator(const struct ConfigSet *cs, const struct ConfigDef *cdef,
   mutt_buffer_printf(err, _("Invalid value for option %s: %s"), cdef->name, str);
   return CSR_ERR_INVALID;
 }
+
+/**
+ * compress_method_validator - Validate the "header_cache_compress_method" config variable - Implements ::cs_validator()
+ */
+int compress_method_validator(const struct ConfigSet *cs, const struct ConfigDef *cdef,
+                              intptr_t value, struct Buffer *err)
+{
+  if (value == 0)
+    return CSR_SUCCESS;
+
+  const char *str = (const char *) value;
+
+  if (mutt_hcache_is_valid_compression(str))
+    return CSR_SUCCESS;
+
+  mutt_buffer_printf(err, _("Invalid value for option %s: %s"), cdef->name, str);
+  return CSR_ERR_INVALID;
+}
 #endif
 
 /**
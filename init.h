@@ -82,6 +82,7 @@
 #include "smtp.h"
 #include "sort.h"
 #include "status.h"
+#include "textindex.h"
 #ifdef MIXMASTER
 #include "remailer.h"
 #endif
@@ -116,6 +117,7 @@ bool IgnoreLinearWhiteSpace = false;
 
 int charset_validator  (const struct ConfigSet *cs, const struct ConfigDef *cdef, intptr_t value, struct Buffer *err);
 int hcache_validator   (const struct ConfigSet *cs, const struct ConfigDef *cdef, intptr_t value, struct Buffer *err);
+int compress_method_validator(const struct ConfigSet *cs, const struct ConfigDef *cdef, intptr_t value, struct Buffer *err);
 int multipart_validator(const struct ConfigSet *cs, const struct ConfigDef *cdef, intptr_t value, struct Buffer *err);
 int pager_validator    (const struct ConfigSet *cs, const struct ConfigDef *cdef, intptr_t value, struct Buffer *err);
 int reply_validator    (const struct ConfigSet *cs, const struct ConfigDef *cdef, intptr_t value, struct Buffer *err);
@@ -1212,6 +1214,14 @@ struct ConfigDef MuttVars[] = {
   ** .pp
   ** Header caching can greatly improve speed when opening POP, IMAP
   ** MH or Maildir folders, see ``$caching'' for details.
+  ** .pp
+  ** Mbox and MMDF folders are indexed, too.  If such a folder is unchanged,
+  ** or new mail has only been appended to it, its headers are read from the
+  ** cache and only the new messages are parsed.
+  ** .pp
+  ** When a folder sorted by threads is closed, its threads are cached, too.
+  ** When it's next opened, they're reused if the threading headers of its
+  ** messages haven't changed, so only new messages need to be threaded.
   */
   { "header_cache_backend", DT_STRING, R_NONE, &HeaderCacheBackend, 0, hcache_validator },
   /*
@@ -1231,6 +1241,30 @@ struct ConfigDef MuttVars[] = {
   ** cached folders.
   */
 #endif /* HAVE_QDBM */
+#ifdef USE_HCACHE_COMPRESSION
+  { "header_cache_compress_level", DT_NUMBER, R_NONE, &HeaderCacheCompressLevel, 1 },
+  /*
+  ** .pp
+  ** When NeoMutt is compiled with lz4, zlib or zstd, this option sets the
+  ** compression level used by $$header_cache_compress_method.  Higher values
+  ** give smaller records, but take longer to compress.  The value is clamped
+  ** to the range supported by the method: 1-9 for zlib, 1-22 for zstd.  For
+  ** lz4, this is an acceleration factor in the range 1-12, where higher
+  ** values are faster but compress less.
+  */
+  { "header_cache_compress_method", DT_STRING, R_NONE, &HeaderCacheCompressMethod, 0, compress_method_validator },
+  /*
+  ** .pp
+  ** When NeoMutt is compiled with lz4, zlib or zstd, this option selects the
+  ** method used to compress the records of the header cache.  Smaller
+  ** records mean less disk space and less memory pressure when opening
+  ** large folders.  When unset, records are stored uncompressed.
+  ** .pp
+  ** Changing the method doesn't invalidate the cache: existing records,
+  ** compressed or not, remain readable as long as their method is compiled
+  ** in.
+  */
+#endif /* USE_HCACHE_COMPRESSION */
 #if defined(HAVE_GDBM) || defined(HAVE_BDB)
   { "header_cache_pagesize", DT_STRING, R_NONE, &HeaderCachePagesize, IP "16384" },
   /*
@@ -1815,6 +1849,19 @@ struct ConfigDef MuttVars[] = {
   ** message every time the folder is opened (which can be very slow for NFS
   ** folders).
   */
+#endif
+#ifdef HAVE_PTHREAD
+  { "maildir_read_threads", DT_NUMBER, R_NONE, &MaildirReadThreads, 4 },
+  /*
+  ** .pp
+  ** When opening a Maildir or MH mailbox, the header of every message that
+  ** isn't in the header cache has to be read.  This variable sets the number
+  ** of threads that open the message files and read their headers ahead of
+  ** NeoMutt, so that it doesn't have to wait for the disk for each message.
+  ** The headers are still parsed one at a time, in the usual order.
+  ** .pp
+  ** A value of 0 disables the threads.
+  */
 #endif
   { "maildir_trash", DT_BOOL, R_NONE, &MaildirTrash, false },
   /*
@@ -3297,6 +3344,38 @@ struct ConfigDef MuttVars[] = {
   ** For the pager, this variable specifies the number of lines shown
   ** before search results. By default, search results will be top-aligned.
   */
+#ifdef USE_HCACHE
+  { "search_index",     DT_BOOL, R_NONE, &SearchIndex, false },
+  /*
+  ** .pp
+  ** When set, NeoMutt keeps an index of the words of the messages in local
+  ** mailboxes (mbox, MMDF, Maildir and MH), in the $$header_cache.  The
+  ** ``~b'', ``~B'' and ``~h'' patterns then only read the messages that
+  ** contain the literal text of the pattern.  Messages are added to the
+  ** index the first time they're searched, and indexed again if they change.
+  ** .pp
+  ** The index is only used for ``~b'' and ``~B'' if $$thorough_search is
+  ** set, and only for patterns containing a word of three or more letters or
+  ** digits.  The bodies of encrypted messages, or of ones that need an
+  ** external viewer, aren't indexed, so they're always searched.
+  */
+#endif
+#ifdef HAVE_PTHREAD
+  { "search_threads",   DT_NUMBER|DT_NOT_NEGATIVE,  R_NONE, &SearchThreads, 0 },
+  /*
+  ** .pp
+  ** The number of threads used to search the text of messages in local
+  ** mailboxes (mbox, MMDF, Maildir and MH) for the ``~b'', ``~B'' and
+  ** ``~h'' patterns, when limiting, tagging or searching.  Each thread
+  ** reads and decodes its own messages.
+  ** .pp
+  ** Messages that need the crypto backends or an external viewer to be
+  ** decoded are still searched by NeoMutt's main thread.
+  ** .pp
+  ** A value of 0 uses one thread per processor.  A value of 1 disables the
+  ** threads.
+  */
+#endif
   { "send_charset",     DT_STRING,  R_NONE, &SendCharset, IP "us-ascii:iso-8859-1:utf-8", charset_validator },
   /*
   ** .pp
@@ -122,6 +122,7 @@ void mailbox_free(struct Mailbox **mailbox)
     return;
 
   FREE(&(*mailbox)->desc);
+  mutt_slab_pool_free(&(*mailbox)->slabs);
   if ((*mailbox)->data && (*mailbox)->free_data)
     (*mailbox)->free_data(&(*mailbox)->data);
   FREE(mailbox);
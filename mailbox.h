@@ -114,8 +114,8 @@ struct Mailbox
 #endif
 
   struct Hash *id_hash;     /**< hash table by msg id */
-  struct Hash *subj_hash;   /**< hash table by subject */
   struct Hash *label_hash;  /**< hash table for x-labels */
+  struct SlabPool *slabs;   /**< Storage for the emails read by the backend */
 
   int flags; /**< e.g. #MB_NORMAL */
 };
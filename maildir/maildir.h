@@ -47,6 +47,7 @@ struct Email;
 /* These Config Variables are only used in maildir/mh.c */
 extern bool  CheckNew;
 extern bool  MaildirHeaderCacheVerify;
+extern short MaildirReadThreads;
 extern bool  MhPurge;
 extern char *MhSeqFlagged;
 extern char *MhSeqReplied;
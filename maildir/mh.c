@@ -67,10 +67,14 @@
 #ifdef USE_INOTIFY
 #include "monitor.h"
 #endif
+#ifdef HAVE_PTHREAD
+#include "prefetch.h"
+#endif
 
 /* These Config Variables are only used in maildir/mh.c */
 bool CheckNew; ///< Config: (maildir,mh) Check for new mail while the mailbox is open
 bool MaildirHeaderCacheVerify; ///< Config: (hcache) Check for maildir changes when opening mailbox
+short MaildirReadThreads; ///< Config: (maildir,mh) Number of threads reading message files
 bool MhPurge;       ///< Config: Really delete files in MH mailboxes
 char *MhSeqFlagged; ///< Config: MH sequence for flagged message
 char *MhSeqReplied; ///< Config: MH sequence to tag replied messages
@@ -825,13 +829,18 @@ static bool maildir_add_to_context(struct Context *ctx, struct Maildir *md)
 
   if (!ctx->mailbox->hdrs)
   {
-    /* Allocate some memory to get started */
-    ctx->mailbox->hdrmax = ctx->mailbox->msg_count;
+    ctx->mailbox->hdrmax = 0;
     ctx->mailbox->msg_count = 0;
     ctx->mailbox->vcount = 0;
-    mx_alloc_memory(ctx->mailbox);
   }
 
+  /* Make room for all the new emails at once */
+  int count = 0;
+  for (struct Maildir *p = md; p; p = p->next)
+    if (p->email)
+      count++;
+  mx_reserve_memory(ctx->mailbox, ctx->mailbox->msg_count + count);
+
   while (md)
   {
     mutt_debug(2, "Considering %s\n", NONULL(md->canon_fname));
@@ -842,9 +851,6 @@ static bool maildir_add_to_context(struct Context *ctx, struct Maildir *md)
                  md->email->flagged ? "f" : "", md->email->deleted ? "D" : "",
                  md->email->replied ? "r" : "", md->email->old ? "O" : "",
                  md->email->read ? "R" : "");
-      if (ctx->mailbox->msg_count == ctx->mailbox->hdrmax)
-        mx_alloc_memory(ctx->mailbox);
-
       ctx->mailbox->hdrs[ctx->mailbox->msg_count] = md->email;
       ctx->mailbox->hdrs[ctx->mailbox->msg_count]->index = ctx->mailbox->msg_count;
       ctx->mailbox->size += md->email->content->length + md->email->content->offset -
@@ -1095,6 +1101,77 @@ static struct Maildir *skip_duplicates(struct Maildir *p, struct Maildir **last)
   return p;
 }
 
+#ifdef HAVE_PTHREAD
+/**
+ * maildir_parse_pending - Parse the messages that weren't in the header cache
+ * @param mailbox  Mailbox
+ * @param pending  Messages to parse, in inode order
+ * @param count    Number of messages
+ * @param hc       Header cache handle
+ * @param progress Progress bar
+ * @param done     Number of messages already processed, for the progress bar
+ *
+ * A pool of threads opens the message files and reads their headers ahead of
+ * us, so that we don't have to wait for the disk for every message.  The
+ * messages are still parsed here, in order.
+ */
+static void maildir_parse_pending(struct Mailbox *mailbox, struct Maildir **pending,
+                                  size_t count, void *hc,
+                                  struct Progress *progress, int done)
+{
+  char fn[PATH_MAX];
+
+  struct MhPrefetch *pf = mh_prefetch_new(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    snprintf(fn, sizeof(fn), "%s/%s", mailbox->path, pending[i]->email->path);
+    mh_prefetch_add(pf, fn);
+  }
+
+  /* If no thread can be started, read the files ourselves */
+  if (!mh_prefetch_start(pf, MaildirReadThreads))
+    mh_prefetch_free(&pf);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    struct Maildir *p = pending[i];
+
+    if (!mailbox->quiet && progress)
+      mutt_progress_update(progress, done + i, -1);
+
+    snprintf(fn, sizeof(fn), "%s/%s", mailbox->path, p->email->path);
+
+    FILE *fp = pf ? mh_prefetch_get(pf, i) : fopen(fn, "r");
+    if (!fp)
+    {
+      mutt_email_free(&p->email);
+      continue;
+    }
+
+    maildir_parse_stream(mailbox->magic, fp, fn, p->email->old, p->email);
+    mutt_file_fclose(&fp);
+    p->header_parsed = 1;
+#ifdef USE_HCACHE
+    const char *key = NULL;
+    size_t keylen;
+    if (mailbox->magic == MUTT_MH)
+    {
+      key = p->email->path;
+      keylen = strlen(key);
+    }
+    else
+    {
+      key = p->email->path + 3;
+      keylen = maildir_hcache_keylen(key);
+    }
+    mutt_hcache_store(hc, key, keylen, p->email, 0);
+#endif
+  }
+
+  mh_prefetch_free(&pf);
+}
+#endif
+
 /**
  * maildir_delayed_parsing - This function does the second parsing pass
  * @param mailbox  Mailbox
@@ -1114,9 +1191,20 @@ static void maildir_delayed_parsing(struct Mailbox *mailbox, struct Maildir **md
   struct stat lastchanged;
   int ret;
 #endif
+#ifdef HAVE_PTHREAD
+  struct Maildir **pending = NULL;
+  size_t num_pending = 0;
+  size_t max_pending = 0;
+#else
+  const size_t num_pending = 0;
+#endif
 
 #ifdef USE_HCACHE
   header_cache_t *hc = mutt_hcache_open(HeaderCache, mailbox->path, NULL);
+  /* Write all the newly parsed headers in a single transaction */
+  mutt_hcache_begin(hc);
+#elif defined(HAVE_PTHREAD)
+  void *hc = NULL;
 #endif
 
   for (p = *md, count = 0; p; p = p->next, count++)
@@ -1128,7 +1216,7 @@ static void maildir_delayed_parsing(struct Mailbox *mailbox, struct Maildir **md
     }
 
     if (!mailbox->quiet && progress)
-      mutt_progress_update(progress, count, -1);
+      mutt_progress_update(progress, count - num_pending, -1);
 
     if (!sort)
     {
@@ -1183,6 +1271,19 @@ static void maildir_delayed_parsing(struct Mailbox *mailbox, struct Maildir **md
     {
 #endif
 
+#ifdef HAVE_PTHREAD
+      /* Leave the message to be parsed once the pool of threads has read it */
+      if (MaildirReadThreads > 0)
+      {
+        if (num_pending == max_pending)
+        {
+          max_pending = MAX(max_pending * 2, 256);
+          mutt_mem_realloc(&pending, max_pending * sizeof(struct Maildir *));
+        }
+        pending[num_pending++] = p;
+      }
+      else
+#endif
       if (maildir_parse_message(mailbox->magic, fn, p->email->old, p->email))
       {
         p->header_parsed = 1;
@@ -1208,7 +1309,15 @@ static void maildir_delayed_parsing(struct Mailbox *mailbox, struct Maildir **md
 #endif
     last = p;
   }
+
+#ifdef HAVE_PTHREAD
+  if (num_pending > 0)
+    maildir_parse_pending(mailbox, pending, num_pending, hc, progress, count - num_pending);
+  FREE(&pending);
+#endif
+
 #ifdef USE_HCACHE
+  mutt_hcache_commit(hc);
   mutt_hcache_close(hc);
 #endif
 
@@ -2912,7 +3021,10 @@ static int mh_mbox_sync(struct Context *ctx, int *index_hint)
 
 #ifdef USE_HCACHE
   if (ctx->mailbox->magic == MUTT_MAILDIR || ctx->mailbox->magic == MUTT_MH)
+  {
     hc = mutt_hcache_open(HeaderCache, ctx->mailbox->path, NULL);
+    mutt_hcache_begin(hc);
+  }
 #endif
 
   if (!ctx->mailbox->quiet)
@@ -0,0 +1,320 @@
+/**
+ * @file
+ * Read Maildir/MH message files ahead of the parser
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page maildir_prefetch Read Maildir/MH message files ahead of the parser
+ *
+ * When a Maildir or MH mailbox is opened without a (complete) header cache,
+ * every message file has to be opened and its header read.  On a cold cache,
+ * that's one disk round-trip per message.
+ *
+ * A small pool of threads opens the files, in the order they will be parsed,
+ * and reads their headers into the page cache.  The main thread then takes
+ * the open files, in order, and parses them as usual.  Only a limited number
+ * of files are read ahead, so the number of open descriptors stays bounded.
+ *
+ * The threads never touch any NeoMutt state: the header parser relies on
+ * global configuration and static buffers, so it stays on the main thread.
+ */
+
+#include "config.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "mutt/mutt.h"
+#include "prefetch.h"
+
+/* Number of files each thread may read ahead of the parser */
+#define PREFETCH_WINDOW 16
+
+/* Stop reading a header after this many bytes */
+#define PREFETCH_MAX_HEADER (256 * 1024)
+
+/**
+ * struct PrefetchJob - A message file to be read ahead
+ */
+struct PrefetchJob
+{
+  char *path; ///< Full path of the message file
+  int fd;     ///< Open file, or -1 on error
+  bool done;  ///< A thread has finished with this file
+};
+
+/**
+ * struct MhPrefetch - Pool of threads reading message files
+ */
+struct MhPrefetch
+{
+  struct PrefetchJob *jobs; ///< Files to read, in parsing order
+  size_t num_jobs;          ///< Number of files
+  size_t max_jobs;          ///< Size of the jobs array
+  size_t next;              ///< Next file to hand to a thread
+  size_t consumed;          ///< Number of files taken by the parser
+  size_t window;            ///< Maximum number of files read ahead
+  bool quit;                ///< Tell the threads to stop
+
+  pthread_mutex_t lock;  ///< Protects all the above
+  pthread_cond_t work;   ///< Signalled when a thread may read another file
+  pthread_cond_t ready;  ///< Signalled when a file has been read
+  pthread_t *threads;    ///< Worker threads
+  int num_threads;       ///< Number of running threads
+};
+
+/**
+ * prefetch_open - Open a message file and read its header
+ * @param path Path of the message file
+ * @retval >=0 File descriptor, positioned at the start of the file
+ * @retval  -1 Error
+ *
+ * The data is discarded, this just makes sure that the header is in the page
+ * cache when the parser needs it.
+ */
+static int prefetch_open(const char *path)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return -1;
+
+  char buf[4096];
+  off_t off = 0;
+  char last = '\0';
+
+  while (off < PREFETCH_MAX_HEADER)
+  {
+    ssize_t len = pread(fd, buf, sizeof(buf), off);
+    if (len < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    if (len == 0)
+      break;
+
+    /* Look for the blank line at the end of the header */
+    bool found = false;
+    for (ssize_t i = 0; i < len; i++)
+    {
+      if ((buf[i] == '\n') && (last == '\n'))
+      {
+        found = true;
+        break;
+      }
+      if (buf[i] != '\r')
+        last = buf[i];
+    }
+    if (found)
+      break;
+
+    off += len;
+  }
+
+  return fd;
+}
+
+/**
+ * prefetch_thread - Read message files until there are none left
+ * @param arg Prefetch pool
+ * @retval NULL Always
+ */
+static void *prefetch_thread(void *arg)
+{
+  struct MhPrefetch *pf = arg;
+
+  pthread_mutex_lock(&pf->lock);
+  while (true)
+  {
+    while (!pf->quit && (pf->next < pf->num_jobs) && (pf->next >= pf->consumed + pf->window))
+      pthread_cond_wait(&pf->work, &pf->lock);
+
+    if (pf->quit || (pf->next >= pf->num_jobs))
+      break;
+
+    struct PrefetchJob *job = &pf->jobs[pf->next++];
+    pthread_mutex_unlock(&pf->lock);
+
+    int fd = prefetch_open(job->path);
+
+    pthread_mutex_lock(&pf->lock);
+    job->fd = fd;
+    job->done = true;
+    pthread_cond_broadcast(&pf->ready);
+  }
+  pthread_mutex_unlock(&pf->lock);
+
+  return NULL;
+}
+
+/**
+ * mh_prefetch_new - Create a prefetch pool
+ * @param num_jobs Expected number of files
+ * @retval ptr New prefetch pool
+ */
+struct MhPrefetch *mh_prefetch_new(size_t num_jobs)
+{
+  struct MhPrefetch *pf = mutt_mem_calloc(1, sizeof(struct MhPrefetch));
+
+  pf->max_jobs = MAX(num_jobs, 1);
+  pf->jobs = mutt_mem_calloc(pf->max_jobs, sizeof(struct PrefetchJob));
+  pthread_mutex_init(&pf->lock, NULL);
+  pthread_cond_init(&pf->work, NULL);
+  pthread_cond_init(&pf->ready, NULL);
+
+  return pf;
+}
+
+/**
+ * mh_prefetch_add - Add a file to the prefetch pool
+ * @param pf   Prefetch pool
+ * @param path Path of the message file
+ *
+ * Files must be added, in parsing order, before mh_prefetch_start() is called.
+ */
+void mh_prefetch_add(struct MhPrefetch *pf, const char *path)
+{
+  if (!pf || !path || (pf->num_threads != 0))
+    return;
+
+  if (pf->num_jobs == pf->max_jobs)
+  {
+    pf->max_jobs *= 2;
+    mutt_mem_realloc(&pf->jobs, pf->max_jobs * sizeof(struct PrefetchJob));
+  }
+
+  struct PrefetchJob *job = &pf->jobs[pf->num_jobs++];
+  job->path = mutt_str_strdup(path);
+  job->fd = -1;
+  job->done = false;
+}
+
+/**
+ * mh_prefetch_start - Start reading the files
+ * @param pf      Prefetch pool
+ * @param threads Number of threads to use
+ * @retval true  At least one thread is running
+ * @retval false Error, the caller should read the files itself
+ */
+bool mh_prefetch_start(struct MhPrefetch *pf, int threads)
+{
+  if (!pf || (threads < 1) || (pf->num_threads != 0))
+    return false;
+
+  pf->window = (size_t) threads * PREFETCH_WINDOW;
+  pf->threads = mutt_mem_calloc(threads, sizeof(pthread_t));
+
+  /* The threads inherit our signal mask; keep all signals for the main thread */
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+
+  for (int i = 0; i < threads; i++)
+  {
+    if (pthread_create(&pf->threads[pf->num_threads], NULL, prefetch_thread, pf) != 0)
+      break;
+    pf->num_threads++;
+  }
+
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+  if (pf->num_threads == 0)
+  {
+    mutt_debug(1, "unable to start any prefetch thread\n");
+    FREE(&pf->threads);
+    return false;
+  }
+
+  mutt_debug(3, "reading %zu files with %d threads\n", pf->num_jobs, pf->num_threads);
+  return true;
+}
+
+/**
+ * mh_prefetch_get - Get an open message file
+ * @param pf  Prefetch pool
+ * @param idx Index of the file, in the order they were added
+ * @retval ptr  Open file, to be closed by the caller
+ * @retval NULL The file couldn't be opened
+ *
+ * The files must be taken in the order they were added.  This waits until
+ * a thread has read the file.
+ */
+FILE *mh_prefetch_get(struct MhPrefetch *pf, size_t idx)
+{
+  if (!pf || (idx >= pf->num_jobs) || (pf->num_threads == 0))
+    return NULL;
+
+  struct PrefetchJob *job = &pf->jobs[idx];
+
+  pthread_mutex_lock(&pf->lock);
+  while (!job->done)
+    pthread_cond_wait(&pf->ready, &pf->lock);
+
+  int fd = job->fd;
+  job->fd = -1;
+  pf->consumed = idx + 1;
+  pthread_cond_broadcast(&pf->work);
+  pthread_mutex_unlock(&pf->lock);
+
+  if (fd < 0)
+    return NULL;
+
+  FILE *fp = fdopen(fd, "r");
+  if (!fp)
+    close(fd);
+
+  return fp;
+}
+
+/**
+ * mh_prefetch_free - Stop the threads and free the prefetch pool
+ * @param pf Prefetch pool to free
+ */
+void mh_prefetch_free(struct MhPrefetch **pf)
+{
+  if (!pf || !*pf)
+    return;
+
+  struct MhPrefetch *p = *pf;
+
+  pthread_mutex_lock(&p->lock);
+  p->quit = true;
+  pthread_cond_broadcast(&p->work);
+  pthread_mutex_unlock(&p->lock);
+
+  for (int i = 0; i < p->num_threads; i++)
+    pthread_join(p->threads[i], NULL);
+
+  for (size_t i = 0; i < p->num_jobs; i++)
+  {
+    if (p->jobs[i].fd >= 0)
+      close(p->jobs[i].fd);
+    FREE(&p->jobs[i].path);
+  }
+
+  pthread_cond_destroy(&p->ready);
+  pthread_cond_destroy(&p->work);
+  pthread_mutex_destroy(&p->lock);
+  FREE(&p->threads);
+  FREE(&p->jobs);
+  FREE(pf);
+}
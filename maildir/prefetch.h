@@ -0,0 +1,34 @@
+/**
+ * @file
+ * Read Maildir/MH message files ahead of the parser
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MUTT_MAILDIR_PREFETCH_H
+#define MUTT_MAILDIR_PREFETCH_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+struct MhPrefetch;
+
+struct MhPrefetch *mh_prefetch_new(size_t num_jobs);
+void               mh_prefetch_add(struct MhPrefetch *pf, const char *path);
+bool               mh_prefetch_start(struct MhPrefetch *pf, int threads);
+FILE *             mh_prefetch_get(struct MhPrefetch *pf, size_t idx);
+void               mh_prefetch_free(struct MhPrefetch **pf);
+
+#endif /* MUTT_MAILDIR_PREFETCH_H */
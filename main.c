@@ -83,6 +83,9 @@
 #ifdef USE_NNTP
 #include "nntp/nntp.h"
 #endif
+#ifdef USE_HCACHE
+#include "textindex.h"
+#endif
 
 /* These Config Variables are only used in main.c */
 bool ResumeEditedDraftFiles; ///< Config: Resume editing previously saved draft files
@@ -1240,6 +1243,9 @@ main_exit:
   mutt_list_free(&queries);
   crypto_module_free();
   mutt_window_free();
+#ifdef USE_HCACHE
+  mutt_textindex_cleanup();
+#endif
   mutt_buffer_pool_free();
   mutt_envlist_free();
   mutt_free_opts();
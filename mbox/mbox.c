@@ -29,12 +29,16 @@
  */
 
 #include "config.h"
+#include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
@@ -43,6 +47,7 @@
 #include "email/lib.h"
 #include "mutt.h"
 #include "mbox.h"
+#include "reconcile.h"
 #include "context.h"
 #include "copy.h"
 #include "globals.h"
@@ -54,6 +59,9 @@
 #include "progress.h"
 #include "protos.h"
 #include "sort.h"
+#ifdef USE_HCACHE
+#include "hcache/hcache.h"
+#endif
 
 /**
  * struct MUpdate - Store of new offsets, used by mutt_sync_mailbox()
@@ -182,6 +190,366 @@ static void mbox_unlock_mailbox(struct Mailbox *mailbox)
   }
 }
 
+/**
+ * mbox_map_open - Map a mailbox file into memory
+ * @param mailbox Mailbox
+ * @param fp      Open mailbox file
+ * @param size    Size of the file
+ * @param map     Map to fill in
+ * @retval true  File was mapped
+ * @retval false File can't be mapped, the caller should use stdio
+ *
+ * Only regular files are mapped.  Pipes, special files and the temporary
+ * copies of compressed folders are read with stdio.
+ */
+static bool mbox_map_open(struct Mailbox *mailbox, FILE *fp, LOFF_T size,
+                          struct MboxMap *map)
+{
+  struct stat sb;
+
+  map->data = NULL;
+  map->size = 0;
+
+#ifdef USE_COMPRESSED
+  if (mailbox->compress_info)
+    return false;
+#endif
+
+  if ((size <= 0) || ((uintmax_t) size > SIZE_MAX))
+    return false;
+
+  if ((fstat(fileno(fp), &sb) != 0) || !S_ISREG(sb.st_mode) || (sb.st_size < size))
+    return false;
+
+  void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+  if (data == MAP_FAILED)
+  {
+    mutt_debug(1, "mmap() failed, using stdio: %s\n", strerror(errno));
+    return false;
+  }
+#ifdef MADV_SEQUENTIAL
+  madvise(data, size, MADV_SEQUENTIAL);
+#endif
+
+  map->data = data;
+  map->size = size;
+  return true;
+}
+
+/**
+ * mbox_map_close - Unmap a mailbox file
+ * @param map Map to release
+ */
+static void mbox_map_close(struct MboxMap *map)
+{
+  if (!map->data)
+    return;
+
+  munmap((void *) map->data, map->size);
+  map->data = NULL;
+  map->size = 0;
+}
+
+/**
+ * mbox_map_count_lines - Count the newlines in part of a mapped file
+ * @param map   Mapped file
+ * @param start Offset of the first byte
+ * @param end   Offset just past the last byte
+ * @retval num Number of newlines
+ */
+static long mbox_map_count_lines(const struct MboxMap *map, LOFF_T start, LOFF_T end)
+{
+  if (end > map->size)
+    end = map->size;
+  if (start >= end)
+    return 0;
+
+  const char *p = map->data + start;
+  const char *stop = map->data + end;
+  long lines = 0;
+
+  while ((p = memchr(p, '\n', stop - p)))
+  {
+    lines++;
+    p++;
+  }
+
+  return lines;
+}
+
+/**
+ * mbox_map_find_sep - Find the next line that starts with a separator
+ * @param[in]  map    Mapped file
+ * @param[in]  start  Offset of the start of a line
+ * @param[in]  sep    Separator, e.g. "From "
+ * @param[in]  seplen Length of the separator
+ * @param[out] lines  Number of lines skipped
+ * @retval num Offset of the separator line, or the size of the file if there isn't one
+ *
+ * The separator is only a candidate, the caller must still check it, e.g.
+ * with is_from().  An unterminated last line counts as a line.
+ */
+static LOFF_T mbox_map_find_sep(const struct MboxMap *map, LOFF_T start,
+                                const char *sep, size_t seplen, long *lines)
+{
+  const char *begin = map->data + start;
+  const char *end = map->data + map->size;
+  const char *found = NULL;
+
+  *lines = 0;
+  if (start >= map->size)
+    return map->size;
+
+  if (((size_t)(end - begin) >= seplen) && (memcmp(begin, sep, seplen) == 0))
+    return start;
+
+  /* Look for "\n" + sep, scanning from the first character of sep */
+  const char *p = begin;
+  while ((end - p) >= (ptrdiff_t) seplen)
+  {
+    p = memchr(p, sep[0], end - p - seplen + 1);
+    if (!p)
+      break;
+    if ((p > begin) && (p[-1] == '\n') && (memcmp(p, sep, seplen) == 0))
+    {
+      found = p;
+      break;
+    }
+    p++;
+  }
+
+  if (!found)
+  {
+    *lines = mbox_map_count_lines(map, start, map->size);
+    if (end[-1] != '\n')
+      (*lines)++;
+    return map->size;
+  }
+
+  *lines = mbox_map_count_lines(map, start, found - map->data);
+  return found - map->data;
+}
+
+#ifdef USE_HCACHE
+/* Number of bytes, at the start and end of the folder, covered by the digest */
+#define MBOX_INDEX_SAMPLE 4096
+
+/**
+ * struct MboxIndex - Summary of a folder stored in the header cache
+ *
+ * Each message is stored under its position in the file, "/0", "/1", etc.
+ * This record, stored under "/index", describes the file they came from.
+ */
+struct MboxIndex
+{
+  LOFF_T size;              /**< Size of the indexed part of the folder */
+  struct timespec mtime;    /**< Folder's modification time */
+  int msg_count;            /**< Number of messages indexed */
+  unsigned char digest[16]; /**< MD5 of the start and end of the indexed part */
+};
+
+/**
+ * mbox_index_digest - Fingerprint the indexed part of a folder
+ * @param[in]  fp     Open mailbox file
+ * @param[in]  size   Size of the indexed part
+ * @param[out] digest MD5 digest, 16 bytes
+ * @retval true Success
+ *
+ * Only the first and last #MBOX_INDEX_SAMPLE bytes are read.  If the folder
+ * has been rewritten, rather than appended to, the end will almost certainly
+ * have moved.
+ */
+static bool mbox_index_digest(FILE *fp, LOFF_T size, unsigned char *digest)
+{
+  char buf[2 * MBOX_INDEX_SAMPLE];
+  size_t head = (size < MBOX_INDEX_SAMPLE) ? size : MBOX_INDEX_SAMPLE;
+  size_t tail = (size < 2 * MBOX_INDEX_SAMPLE) ? size - head : MBOX_INDEX_SAMPLE;
+
+  if ((fseeko(fp, 0, SEEK_SET) != 0) || (fread(buf, 1, head, fp) != head))
+    return false;
+  if ((fseeko(fp, size - tail, SEEK_SET) != 0) || (fread(buf + head, 1, tail, fp) != tail))
+    return false;
+
+  mutt_md5_bytes(buf, head + tail, digest);
+  return true;
+}
+
+/**
+ * mbox_index_usable - Can a folder be indexed in the header cache?
+ * @param mailbox Mailbox
+ * @retval true The folder can be indexed
+ *
+ * A compressed folder is read from a new temporary file each time it's
+ * opened, so an index keyed on its path would never be found again.
+ */
+static bool mbox_index_usable(const struct Mailbox *mailbox)
+{
+  if (!HeaderCache)
+    return false;
+
+#ifdef USE_COMPRESSED
+  if (mailbox->compress_info)
+    return false;
+#endif
+
+  return true;
+}
+
+/**
+ * mbox_index_store - Save the parsed emails in the header cache
+ * @param ctx   Mailbox
+ * @param first Index of the first email to store
+ *
+ * Emails from @a first onwards are stored, skipping deleted ones, then the
+ * summary record is updated to describe the whole folder.
+ */
+static void mbox_index_store(struct Context *ctx, int first)
+{
+  struct MboxData *mdata = get_mboxdata(ctx->mailbox);
+  struct MboxIndex idx = { 0 };
+  struct stat sb;
+  char key[32];
+
+  if (!mdata || !mdata->fp || (first < 0) || !mbox_index_usable(ctx->mailbox) ||
+      (stat(ctx->mailbox->path, &sb) != 0))
+  {
+    return;
+  }
+
+  LOFF_T pos = ftello(mdata->fp);
+  idx.size = ctx->mailbox->size;
+  mutt_get_stat_timespec(&idx.mtime, &sb, MUTT_STAT_MTIME);
+  bool ok = mbox_index_digest(mdata->fp, idx.size, idx.digest);
+  if ((pos < 0) || (fseeko(mdata->fp, pos, SEEK_SET) != 0) || !ok)
+    return;
+
+  header_cache_t *hc = mutt_hcache_open(HeaderCache, ctx->mailbox->path, NULL);
+  if (!hc)
+    return;
+
+  mutt_hcache_begin(hc);
+
+  idx.msg_count = first;
+  for (int i = first; i < ctx->mailbox->msg_count; i++)
+  {
+    struct Email *e = ctx->mailbox->hdrs[i];
+    if (e->deleted)
+      continue;
+
+    /* the fingerprint is kept in the record's validity field */
+    if (!e->data && !mbox_fingerprint_file(mdata->fp, e))
+      mbox_set_fingerprint(e, 1);
+    struct MboxEmailData *edata = e->data;
+    snprintf(key, sizeof(key), "/%d", idx.msg_count++);
+    mutt_hcache_store(hc, key, strlen(key), e, edata->fingerprint);
+  }
+
+  mutt_hcache_store_raw(hc, "/index", 6, &idx, sizeof(idx));
+  mutt_debug(2, "indexed %d messages, " OFF_T_FMT " bytes\n", idx.msg_count, idx.size);
+
+  mutt_hcache_close(hc);
+}
+
+/**
+ * mbox_index_restore - Load a folder's emails from the header cache
+ * @param ctx Mailbox
+ * @retval num Number of emails restored
+ *
+ * The index is used if the folder is unchanged, or if it has only grown.  On
+ * success, the mailbox file is positioned at the end of the indexed data, so
+ * the parser only has to read any new messages.
+ */
+static int mbox_index_restore(struct Context *ctx)
+{
+  struct MboxData *mdata = get_mboxdata(ctx->mailbox);
+  struct Mailbox *mailbox = ctx->mailbox;
+  struct stat sb;
+  char key[32];
+  int count = 0;
+
+  if (!mdata || !mbox_index_usable(mailbox) || (fstat(fileno(mdata->fp), &sb) != 0))
+    return 0;
+
+  header_cache_t *hc = mutt_hcache_open(HeaderCache, mailbox->path, NULL);
+  if (!hc)
+    return 0;
+
+  struct MboxIndex idx;
+  void *data = mutt_hcache_fetch_raw(hc, "/index", 6, NULL);
+  if (!data)
+    goto done;
+  memcpy(&idx, data, sizeof(idx));
+  mutt_hcache_free(hc, &data);
+
+  if ((idx.msg_count <= 0) || (idx.size > sb.st_size))
+    goto done;
+  if ((idx.size == sb.st_size) &&
+      (mutt_stat_timespec_compare(&sb, MUTT_STAT_MTIME, &idx.mtime) != 0))
+  {
+    goto done;
+  }
+
+  unsigned char digest[16];
+  if (!mbox_index_digest(mdata->fp, idx.size, digest) ||
+      (memcmp(digest, idx.digest, sizeof(digest)) != 0))
+  {
+    mutt_debug(1, "%s has been rewritten, ignoring the index\n", mailbox->path);
+    goto done;
+  }
+
+  /* If the folder has grown, new mail must start exactly where it used to end */
+  if (idx.size < sb.st_size)
+  {
+    char buf[8] = { 0 };
+    if (!fgets(buf, sizeof(buf), mdata->fp) ||
+        ((mailbox->magic == MUTT_MBOX) && (mutt_str_strncmp("From ", buf, 5) != 0)) ||
+        ((mailbox->magic == MUTT_MMDF) && (mutt_str_strcmp(MMDF_SEP, buf) != 0)))
+    {
+      goto done;
+    }
+  }
+
+  for (; count < idx.msg_count; count++)
+  {
+    snprintf(key, sizeof(key), "/%d", count);
+    data = mutt_hcache_fetch(hc, key, strlen(key));
+    if (!data)
+      break;
+
+    if (mailbox->msg_count == mailbox->hdrmax)
+      mx_alloc_memory(mailbox);
+
+    struct Email *e = mutt_hcache_restore(data);
+    unsigned int fingerprint = *(unsigned int *) data;
+    mutt_hcache_free(hc, &data);
+    e->data = NULL;
+    e->free_data = NULL;
+    if (fingerprint != 0)
+      mbox_set_fingerprint(e, fingerprint);
+    e->index = mailbox->msg_count;
+    mailbox->hdrs[mailbox->msg_count++] = e;
+  }
+
+  if ((count < idx.msg_count) || (fseeko(mdata->fp, idx.size, SEEK_SET) != 0))
+  {
+    mutt_debug(1, "index of %s is incomplete, rereading it\n", mailbox->path);
+    while (mailbox->msg_count > 0)
+      mutt_email_free(&mailbox->hdrs[--mailbox->msg_count]);
+    count = 0;
+    goto done;
+  }
+
+  mutt_debug(2, "restored %d messages from the index\n", count);
+  mx_update_context(ctx, count);
+
+done:
+  mutt_hcache_close(hc);
+  if (count == 0)
+    rewind(mdata->fp);
+  return count;
+}
+#endif
+
 /**
  * mmdf_parse_mailbox - Read a mailbox in MMDF format
  * @param ctx Mailbox
@@ -204,6 +572,8 @@ static int mmdf_parse_mailbox(struct Context *ctx)
   struct Email *e = NULL;
   struct stat sb;
   struct Progress progress;
+  struct MboxMap map;
+  int rc = 0;
 
   if (stat(ctx->mailbox->path, &sb) == -1)
   {
@@ -216,6 +586,8 @@ static int mmdf_parse_mailbox(struct Context *ctx)
 
   buf[sizeof(buf) - 1] = '\0';
 
+  mbox_map_open(ctx->mailbox, mdata->fp, ctx->mailbox->size, &map);
+
   if (!ctx->mailbox->quiet)
   {
     char msgbuf[STRING];
@@ -235,7 +607,10 @@ static int mmdf_parse_mailbox(struct Context *ctx)
     {
       loc = ftello(mdata->fp);
       if (loc < 0)
-        return -1;
+      {
+        rc = -1;
+        goto done;
+      }
 
       count++;
       if (!ctx->mailbox->quiet)
@@ -264,7 +639,8 @@ static int mmdf_parse_mailbox(struct Context *ctx)
         {
           mutt_debug(1, "#1 fseek() failed\n");
           mutt_error(_("Mailbox is corrupt"));
-          return -1;
+          rc = -1;
+          goto done;
         }
       }
       else
@@ -274,7 +650,10 @@ static int mmdf_parse_mailbox(struct Context *ctx)
 
       loc = ftello(mdata->fp);
       if (loc < 0)
-        return -1;
+      {
+        rc = -1;
+        goto done;
+      }
 
       if (e->content->length > 0 && e->lines > 0)
       {
@@ -297,14 +676,44 @@ static int mmdf_parse_mailbox(struct Context *ctx)
       else
         e->content->length = -1;
 
-      if (e->content->length < 0)
+      if ((e->content->length < 0) && map.data)
+      {
+        long skipped = 0;
+        const size_t seplen = sizeof(MMDF_SEP) - 1;
+
+        loc = mbox_map_find_sep(&map, loc, MMDF_SEP, seplen, &skipped);
+        if (loc < map.size)
+        {
+          /* consume the closing separator */
+          lines = skipped;
+          tmploc = loc + seplen;
+        }
+        else
+        {
+          lines = skipped - 1;
+          tmploc = loc;
+        }
+
+        if (fseeko(mdata->fp, tmploc, SEEK_SET) != 0)
+        {
+          rc = -1;
+          goto done;
+        }
+
+        e->lines = lines;
+        e->content->length = loc - e->content->offset;
+      }
+      else if (e->content->length < 0)
       {
         lines = -1;
         do
         {
           loc = ftello(mdata->fp);
           if (loc < 0)
-            return -1;
+          {
+            rc = -1;
+            goto done;
+          }
           if (!fgets(buf, sizeof(buf) - 1, mdata->fp))
             break;
           lines++;
@@ -326,25 +735,35 @@ static int mmdf_parse_mailbox(struct Context *ctx)
     {
       mutt_debug(1, "corrupt mailbox\n");
       mutt_error(_("Mailbox is corrupt"));
-      return -1;
+      rc = -1;
+      goto done;
     }
   }
 
   if (ctx->mailbox->msg_count > oldmsgcount)
+  {
+#ifdef USE_HCACHE
+    if (SigInt != 1)
+      mbox_index_store(ctx, oldmsgcount);
+#endif
     mx_update_context(ctx, ctx->mailbox->msg_count - oldmsgcount);
+  }
 
   if (SigInt == 1)
   {
     SigInt = 0;
-    return -2; /* action aborted */
+    rc = -2; /* action aborted */
   }
 
-  return 0;
+done:
+  mbox_map_close(&map);
+  return rc;
 }
 
 /**
  * mbox_parse_mailbox - Read a mailbox from disk
- * @param ctx Mailbox
+ * @param ctx   Mailbox
+ * @param recon Old emails that may be reused, may be NULL
  * @retval  0 Success
  * @retval -1 Error
  * @retval -2 Aborted
@@ -355,7 +774,7 @@ static int mmdf_parse_mailbox(struct Context *ctx)
  * NOTE: it is assumed that the mailbox being read has been locked before this
  * routine gets called.  Strange things could happen if it's not!
  */
-static int mbox_parse_mailbox(struct Context *ctx)
+static int mbox_parse_mailbox(struct Context *ctx, struct MboxReconcile *recon)
 {
   struct MboxData *mdata = get_mboxdata(ctx->mailbox);
   if (!mdata)
@@ -390,6 +809,9 @@ static int mbox_parse_mailbox(struct Context *ctx)
     mutt_progress_init(&progress, msgbuf, MUTT_PROGRESS_MSG, ReadInc, 0);
   }
 
+  struct MboxMap map;
+  mbox_map_open(ctx->mailbox, mdata->fp, ctx->mailbox->size, &map);
+
   loc = ftello(mdata->fp);
   while ((fgets(buf, sizeof(buf), mdata->fp)) && (SigInt != 1))
   {
@@ -420,6 +842,22 @@ static int mbox_parse_mailbox(struct Context *ctx)
       if (ctx->mailbox->msg_count == ctx->mailbox->hdrmax)
         mx_alloc_memory(ctx->mailbox);
 
+      LOFF_T next = 0;
+      curhdr = mbox_reconcile_adopt(recon, &map, loc, ctx->mailbox->msg_count, &next);
+      if (curhdr)
+      {
+        /* the message hasn't changed, so skip straight to the next one */
+        ctx->mailbox->hdrs[ctx->mailbox->msg_count++] = curhdr;
+        lines = 0;
+        if (fseeko(mdata->fp, next, SEEK_SET) != 0)
+        {
+          mutt_debug(1, "#4 fseek() failed\n");
+          break;
+        }
+        loc = next;
+        continue;
+      }
+
       ctx->mailbox->hdrs[ctx->mailbox->msg_count] = mutt_email_new();
       curhdr = ctx->mailbox->hdrs[ctx->mailbox->msg_count];
       curhdr->received = t - mutt_date_local_tz(t);
@@ -428,6 +866,13 @@ static int mbox_parse_mailbox(struct Context *ctx)
 
       curhdr->env = mutt_rfc822_read_header(mdata->fp, curhdr, false, false);
 
+      if (map.data && (curhdr->content->offset > loc) &&
+          (curhdr->content->offset <= map.size))
+      {
+        mbox_set_fingerprint(curhdr, mbox_fingerprint(map.data + loc,
+                                                      curhdr->content->offset - loc));
+      }
+
       /* if we know how long this message is, either just skip over the body,
        * or if we don't know how many lines there are, count them now (this will
        * save time by not having to search for the next message marker).
@@ -483,12 +928,17 @@ static int mbox_parse_mailbox(struct Context *ctx)
             int cl = curhdr->content->length;
 
             /* count the number of lines in this message */
-            if ((loc < 0) || (fseeko(mdata->fp, loc, SEEK_SET) != 0))
-              mutt_debug(1, "#2 fseek() failed\n");
-            while (cl-- > 0)
+            if (map.data)
+              curhdr->lines = mbox_map_count_lines(&map, loc, loc + cl);
+            else
             {
-              if (fgetc(mdata->fp) == '\n')
-                curhdr->lines++;
+              if ((loc < 0) || (fseeko(mdata->fp, loc, SEEK_SET) != 0))
+                mutt_debug(1, "#2 fseek() failed\n");
+              while (cl-- > 0)
+              {
+                if (fgetc(mdata->fp) == '\n')
+                  curhdr->lines++;
+              }
             }
           }
 
@@ -515,6 +965,18 @@ static int mbox_parse_mailbox(struct Context *ctx)
       lines++;
 
     loc = ftello(mdata->fp);
+
+    /* skip straight to the next line that could be a message separator */
+    if (map.data && (loc >= 0))
+    {
+      long skipped = 0;
+      LOFF_T next = mbox_map_find_sep(&map, loc, "From ", 5, &skipped);
+      if ((next != loc) && (fseeko(mdata->fp, next, SEEK_SET) == 0))
+      {
+        lines += skipped;
+        loc = next;
+      }
+    }
   }
 
   /* Only set the content-length of the previous message if we have read more
@@ -535,9 +997,17 @@ static int mbox_parse_mailbox(struct Context *ctx)
     if (!e->lines)
       e->lines = lines ? lines - 1 : 0;
 
+#ifdef USE_HCACHE
+    /* Reused emails carry their unsynced flags and deletions, which aren't
+     * on disk yet.  The folder will be indexed again when it's synced. */
+    if ((SigInt != 1) && !recon)
+      mbox_index_store(ctx, ctx->mailbox->msg_count - count);
+#endif
     mx_update_context(ctx, count);
   }
 
+  mbox_map_close(&map);
+
   if (SigInt == 1)
   {
     SigInt = 0;
@@ -562,7 +1032,9 @@ static int reopen_mailbox(struct Context *ctx, int *index_hint)
 
   bool (*cmp_headers)(const struct Email *, const struct Email *) = NULL;
   struct Email **old_hdrs = NULL;
+  struct MboxReconcile *recon = NULL;
   int old_msgcount;
+  LOFF_T old_size = ctx->mailbox->size;
   bool msg_mod = false;
   bool index_hint_set;
   int i, j;
@@ -590,23 +1062,14 @@ static int reopen_mailbox(struct Context *ctx, int *index_hint)
 
   /* simulate a close */
   mutt_hash_destroy(&ctx->mailbox->id_hash);
-  mutt_hash_destroy(&ctx->mailbox->subj_hash);
   mutt_hash_destroy(&ctx->mailbox->label_hash);
   mutt_clear_threads(ctx);
   FREE(&ctx->mailbox->v2r);
-  if (ctx->mailbox->readonly)
-  {
-    for (i = 0; i < ctx->mailbox->msg_count; i++)
-      mutt_email_free(&(ctx->mailbox->hdrs[i])); /* nothing to do! */
-    FREE(&ctx->mailbox->hdrs);
-  }
-  else
-  {
-    /* save the old headers */
-    old_msgcount = ctx->mailbox->msg_count;
-    old_hdrs = ctx->mailbox->hdrs;
-    ctx->mailbox->hdrs = NULL;
-  }
+
+  /* save the old headers, unchanged messages can be reused */
+  old_msgcount = ctx->mailbox->msg_count;
+  old_hdrs = ctx->mailbox->hdrs;
+  ctx->mailbox->hdrs = NULL;
 
   ctx->mailbox->hdrmax = 0; /* force allocation of new headers */
   ctx->mailbox->msg_count = 0;
@@ -619,7 +1082,6 @@ static int reopen_mailbox(struct Context *ctx, int *index_hint)
   ctx->mailbox->msg_flagged = 0;
   ctx->mailbox->changed = false;
   ctx->mailbox->id_hash = NULL;
-  ctx->mailbox->subj_hash = NULL;
   mutt_make_label_hash(ctx->mailbox);
 
   switch (ctx->mailbox->magic)
@@ -631,9 +1093,14 @@ static int reopen_mailbox(struct Context *ctx, int *index_hint)
       mdata->fp = mutt_file_fopen(ctx->mailbox->path, "r");
       if (!mdata->fp)
         rc = -1;
+      else if (ctx->mailbox->magic == MUTT_MBOX)
+      {
+        if (old_msgcount > 0)
+          recon = mbox_reconcile_new(old_hdrs, old_msgcount, old_size);
+        rc = mbox_parse_mailbox(ctx, recon);
+      }
       else
-        rc = ((ctx->mailbox->magic == MUTT_MBOX) ? mbox_parse_mailbox :
-                                                   mmdf_parse_mailbox)(ctx);
+        rc = mmdf_parse_mailbox(ctx);
       break;
 
     default:
@@ -647,6 +1114,7 @@ static int reopen_mailbox(struct Context *ctx, int *index_hint)
     for (j = 0; j < old_msgcount; j++)
       mutt_email_free(&(old_hdrs[j]));
     FREE(&old_hdrs);
+    mbox_reconcile_free(&recon);
 
     ctx->mailbox->quiet = false;
     return -1;
@@ -658,12 +1126,31 @@ static int reopen_mailbox(struct Context *ctx, int *index_hint)
 
   index_hint_set = (index_hint == NULL);
 
+  /* unchanged messages were reused, so they still have their flags */
+  for (i = 0; recon && (i < ctx->mailbox->msg_count); i++)
+  {
+    j = mbox_reconcile_old_index(recon, i);
+    if (j < 0)
+      continue;
+
+    if (!index_hint_set && *index_hint == j)
+    {
+      *index_hint = i;
+      index_hint_set = true;
+    }
+    if (ctx->mailbox->hdrs[i]->tagged)
+      ctx->tagged++;
+  }
+
   if (!ctx->mailbox->readonly)
   {
     for (i = 0; i < ctx->mailbox->msg_count; i++)
     {
       bool found = false;
 
+      if (mbox_reconcile_old_index(recon, i) >= 0)
+        continue;
+
       /* some messages have been deleted, and new  messages have been
        * appended at the end; the heuristic is that old messages have then
        * "advanced" towards the beginning of the folder, so we begin the
@@ -718,18 +1205,20 @@ static int reopen_mailbox(struct Context *ctx, int *index_hint)
         mutt_email_free(&(old_hdrs[j]));
       }
     }
+  }
 
-    /* free the remaining old headers */
-    for (j = 0; j < old_msgcount; j++)
+  /* free the remaining old headers */
+  for (j = 0; j < old_msgcount; j++)
+  {
+    if (old_hdrs[j])
     {
-      if (old_hdrs[j])
-      {
-        mutt_email_free(&(old_hdrs[j]));
+      mutt_email_free(&(old_hdrs[j]));
+      if (!ctx->mailbox->readonly)
         msg_mod = true;
-      }
     }
-    FREE(&old_hdrs);
   }
+  FREE(&old_hdrs);
+  mbox_reconcile_free(&recon);
 
   ctx->mailbox->quiet = false;
 
@@ -914,9 +1403,13 @@ static int mbox_mbox_open(struct Context *ctx)
     return -1;
   }
 
+#ifdef USE_HCACHE
+  mbox_index_restore(ctx);
+#endif
+
   int rc;
   if (mailbox->magic == MUTT_MBOX)
-    rc = mbox_parse_mailbox(ctx);
+    rc = mbox_parse_mailbox(ctx, NULL);
   else if (mailbox->magic == MUTT_MMDF)
     rc = mmdf_parse_mailbox(ctx);
   else
@@ -1030,7 +1523,7 @@ static int mbox_mbox_check(struct Context *ctx, int *index_hint)
           if (fseeko(mdata->fp, ctx->mailbox->size, SEEK_SET) != 0)
             mutt_debug(1, "#2 fseek() failed\n");
           if (ctx->mailbox->magic == MUTT_MBOX)
-            mbox_parse_mailbox(ctx);
+            mbox_parse_mailbox(ctx, NULL);
           else
             mmdf_parse_mailbox(ctx);
 
@@ -1408,6 +1901,18 @@ static int mbox_mbox_sync(struct Context *ctx, int *index_hint)
   unlink(tempfile); /* remove partial copy of the mailbox */
   mutt_sig_unblock();
 
+  /* the rewritten messages have new headers */
+  for (i = first; i < ctx->mailbox->msg_count; i++)
+  {
+    if (!ctx->mailbox->hdrs[i]->deleted)
+      mbox_fingerprint_file(mdata->fp, ctx->mailbox->hdrs[i]);
+  }
+
+#ifdef USE_HCACHE
+  /* the messages before `first' haven't moved, so their index is still valid */
+  mbox_index_store(ctx, first);
+#endif
+
   if (CheckMboxSize)
   {
     tmp = mutt_find_mailbox(ctx->mailbox->path);
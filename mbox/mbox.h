@@ -25,9 +25,10 @@
  *
  * Mbox local mailbox type
  *
- * | File        | Description        |
- * | :---------- | :----------------- |
- * | mbox/mbox.c | @subpage mbox_mbox |
+ * | File             | Description             |
+ * | :--------------- | :---------------------- |
+ * | mbox/mbox.c      | @subpage mbox_mbox      |
+ * | mbox/reconcile.c | @subpage mbox_reconcile |
  */
 
 #ifndef MUTT_MBOX_MBOX_H
@@ -0,0 +1,301 @@
+/**
+ * @file
+ * Reuse the emails of an mbox folder that has been changed
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page mbox_reconcile Reuse the emails of a changed mbox folder
+ *
+ * Reuse the emails of an mbox folder that has been changed by another program
+ *
+ * An old email is reused if its header block, including the Status and
+ * X-Status headers, has the same MD5 fingerprint, and the message is still
+ * followed by a separator at the same distance, i.e. the body has the same
+ * length and the same number of lines.  The body isn't checksummed, that
+ * would mean keeping a digest of every message.  Apart from the line count,
+ * nothing cached in an Email depends on the body's contents, and its MIME parts
+ * and attachment count are dropped and recomputed.
+ */
+
+#include "config.h"
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "mutt/mutt.h"
+#include "email/lib.h"
+#include "reconcile.h"
+
+/**
+ * free_emaildata - Free data attached to an Email
+ * @param data Email data
+ */
+static void free_emaildata(void **data)
+{
+  FREE(data);
+}
+
+/**
+ * mbox_set_fingerprint - Attach a fingerprint to an Email
+ * @param e           Email
+ * @param fingerprint Hash of the message's header block
+ */
+void mbox_set_fingerprint(struct Email *e, unsigned int fingerprint)
+{
+  if (!e->data)
+  {
+    e->data = mutt_mem_calloc(1, sizeof(struct MboxEmailData));
+    e->free_data = free_emaildata;
+  }
+
+  struct MboxEmailData *edata = e->data;
+  edata->fingerprint = fingerprint;
+}
+
+/**
+ * mbox_fingerprint - Hash a message's header block
+ * @param hdr Start of the message, i.e. its "From " line
+ * @param len Length of the header block, including the blank line
+ * @retval num Fingerprint, never 0
+ *
+ * The header block includes the Status and X-Status headers, so any change to
+ * the flags written by another program will change the fingerprint.
+ */
+unsigned int mbox_fingerprint(const char *hdr, size_t len)
+{
+  unsigned char digest[16];
+  unsigned int fingerprint;
+
+  mutt_md5_bytes(hdr, len, digest);
+  memcpy(&fingerprint, digest, sizeof(fingerprint));
+  return fingerprint ? fingerprint : 1;
+}
+
+/**
+ * mbox_fingerprint_file - Hash a message's header block, reading it from a file
+ * @param fp Mailbox file
+ * @param e  Email
+ * @retval true Success, the fingerprint is attached to the Email
+ */
+bool mbox_fingerprint_file(FILE *fp, struct Email *e)
+{
+  char buf[LONG_STRING * 4];
+  unsigned char digest[16];
+  unsigned int fingerprint;
+  struct Md5Ctx md5ctx;
+
+  LOFF_T pos = e->offset;
+  LOFF_T end = e->content->offset;
+  if ((pos < 0) || (end <= pos))
+    return false;
+
+  mutt_md5_init_ctx(&md5ctx);
+  while (pos < end)
+  {
+    size_t want = ((end - pos) < (LOFF_T) sizeof(buf)) ? (end - pos) : sizeof(buf);
+    ssize_t got = pread(fileno(fp), buf, want, pos);
+    if (got <= 0)
+      return false;
+    mutt_md5_process_bytes(buf, got, &md5ctx);
+    pos += got;
+  }
+  mutt_md5_finish_ctx(&md5ctx, digest);
+
+  memcpy(&fingerprint, digest, sizeof(fingerprint));
+  mbox_set_fingerprint(e, fingerprint ? fingerprint : 1);
+  return true;
+}
+
+/**
+ * struct MboxReconcile - Old emails that may be reused when reparsing a folder
+ *
+ * When a folder is changed by another program, most of its messages are
+ * usually untouched, though they may have moved.  While reparsing, each
+ * message whose header block has the same fingerprint as an old one, and
+ * which is followed by a separator in the same place, is taken over from the
+ * old list rather than being parsed again.
+ */
+struct MboxReconcile
+{
+  struct Email **old_hdrs; /**< Old emails, in file order */
+  LOFF_T *old_end;         /**< Where each old email ended */
+  int old_count;           /**< Number of old emails */
+  struct Hash *hash;       /**< Fingerprint -> old Email */
+  int *old_index;          /**< For each new email, the index of the old one, or -1 */
+  int old_index_max;       /**< Size of old_index */
+  int reused;              /**< Number of old emails reused */
+};
+
+/**
+ * mbox_reconcile_new - Prepare to reuse the old emails of a folder
+ * @param old_hdrs  Old emails, in file order
+ * @param old_count Number of old emails
+ * @param old_size  Size of the folder when it was last read
+ * @retval ptr New MboxReconcile
+ */
+struct MboxReconcile *mbox_reconcile_new(struct Email **old_hdrs, int old_count, LOFF_T old_size)
+{
+  struct MboxReconcile *recon = mutt_mem_calloc(1, sizeof(struct MboxReconcile));
+  recon->old_hdrs = old_hdrs;
+  recon->old_count = old_count;
+  recon->hash = mutt_hash_int_create(old_count * 2 + 1, MUTT_HASH_ALLOW_DUPS);
+
+  /* old_hdrs[] is emptied as the emails are adopted, in the new order,
+   * so work out where each one ended while they're all still there */
+  recon->old_end = mutt_mem_calloc(old_count + 1, sizeof(LOFF_T));
+  for (int i = 0; i < old_count; i++)
+    recon->old_end[i] = (i + 1 < old_count) ? old_hdrs[i + 1]->offset : old_size;
+
+  for (int i = 0; i < old_count; i++)
+  {
+    struct MboxEmailData *edata = old_hdrs[i]->data;
+    if (edata)
+      mutt_hash_int_insert(recon->hash, edata->fingerprint, old_hdrs[i]);
+  }
+
+  return recon;
+}
+
+/**
+ * mbox_reconcile_free - Free a MboxReconcile
+ * @param ptr MboxReconcile to free
+ *
+ * The old emails themselves are left alone.
+ */
+void mbox_reconcile_free(struct MboxReconcile **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  struct MboxReconcile *recon = *ptr;
+  mutt_debug(2, "reused %d of %d messages\n", recon->reused, recon->old_count);
+  mutt_hash_destroy(&recon->hash);
+  FREE(&recon->old_index);
+  FREE(&recon->old_end);
+  FREE(ptr);
+}
+
+/**
+ * mbox_reconcile_old_index - Which old email did a new one come from?
+ * @param recon MboxReconcile
+ * @param i     Index of the new email
+ * @retval num Index of the old email
+ * @retval -1  The email was parsed afresh
+ */
+int mbox_reconcile_old_index(const struct MboxReconcile *recon, int i)
+{
+  if (!recon || (i >= recon->old_index_max))
+    return -1;
+  return recon->old_index[i];
+}
+
+/**
+ * mbox_reconcile_adopt - Try to reuse an old email for a message
+ * @param[in]  recon MboxReconcile
+ * @param[in]  map   Mapped mailbox file
+ * @param[in]  loc   Offset of the message's "From " line
+ * @param[in]  idx   Index the email will have
+ * @param[out] next  Offset of the following message
+ * @retval ptr Old email, moved to its new position
+ * @retval NULL No old email matches, the message must be parsed
+ */
+struct Email *mbox_reconcile_adopt(struct MboxReconcile *recon,
+                                   const struct MboxMap *map, LOFF_T loc, int idx, LOFF_T *next)
+{
+  if (!recon || !map->data || (loc >= map->size))
+    return NULL;
+
+  const char *start = map->data + loc;
+  const char *blank = memmem(start, map->size - loc, "\n\n", 2);
+  if (!blank)
+    return NULL;
+
+  size_t hdrlen = blank + 2 - start;
+  unsigned int fingerprint = mbox_fingerprint(start, hdrlen);
+
+  struct Email *e = mutt_hash_int_find(recon->hash, fingerprint);
+  if (!e)
+    return NULL;
+
+  int j = e->index;
+  if ((j < 0) || (j >= recon->old_count) || (recon->old_hdrs[j] != e) ||
+      ((LOFF_T) hdrlen != (e->content->offset - e->offset)))
+  {
+    return NULL;
+  }
+
+  /* The message must still be followed by a separator, or the end of the file */
+  LOFF_T pos = loc + (recon->old_end[j] - e->offset);
+  if ((pos > map->size) ||
+      ((pos < map->size) && ((map->data[pos - 1] != '\n') ||
+                             ((map->size - pos) < 5) ||
+                             (memcmp(map->data + pos, "From ", 5) != 0))))
+  {
+    return NULL;
+  }
+
+  /* The body must still have as many lines, allowing for the blank line
+   * before the next separator */
+  long lines = 0;
+  const char *body = start + hdrlen;
+  const char *body_end = map->data + pos;
+  while ((body < body_end) && (body = memchr(body, '\n', body_end - body)))
+  {
+    lines++;
+    body++;
+  }
+  if ((e->lines != lines) && (e->lines != lines - 1))
+    return NULL;
+
+  mutt_hash_int_delete(recon->hash, fingerprint, e);
+  recon->old_hdrs[j] = NULL;
+
+  if (idx >= recon->old_index_max)
+  {
+    int old_max = recon->old_index_max;
+    recon->old_index_max = idx + 64;
+    mutt_mem_realloc(&recon->old_index, recon->old_index_max * sizeof(int));
+    for (int i = old_max; i < recon->old_index_max; i++)
+      recon->old_index[i] = -1;
+  }
+  recon->old_index[idx] = j;
+  recon->reused++;
+
+  /* move the email to its new home */
+  LOFF_T delta = loc - e->offset;
+  e->offset += delta;
+  e->content->offset += delta;
+  e->content->hdr_offset += delta;
+  mutt_body_free(&e->content->parts);
+  e->attach_valid = false;
+
+  e->index = idx;
+  e->collapsed = false;
+  e->limited = false;
+  e->num_hidden = 0;
+  e->searched = false;
+  e->matched = false;
+  e->pair = 0;
+  e->author_pair_valid = false;
+  e->subject_pair_valid = false;
+  e->flags_pair_valid = false;
+  FREE(&e->tree);
+
+  *next = pos;
+  return e;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file
+ * Reuse the emails of an mbox folder that has been changed
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MUTT_MBOX_RECONCILE_H
+#define MUTT_MBOX_RECONCILE_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "mutt/mutt.h"
+
+struct Email;
+struct MboxReconcile;
+
+/**
+ * struct MboxMap - A read-only view of a mailbox file
+ *
+ * The parsers use this to skip over message bodies without copying them
+ * through stdio a line at a time.
+ */
+struct MboxMap
+{
+  const char *data; /**< Start of the mapping */
+  LOFF_T size;      /**< Length of the mapping */
+};
+
+/**
+ * struct MboxEmailData - Mbox-specific Email data
+ */
+struct MboxEmailData
+{
+  unsigned int fingerprint; /**< Hash of the message's header block */
+};
+
+void          mbox_set_fingerprint(struct Email *e, unsigned int fingerprint);
+unsigned int  mbox_fingerprint(const char *hdr, size_t len);
+bool          mbox_fingerprint_file(FILE *fp, struct Email *e);
+
+struct MboxReconcile *mbox_reconcile_new(struct Email **old_hdrs, int old_count, LOFF_T old_size);
+void                  mbox_reconcile_free(struct MboxReconcile **ptr);
+int                   mbox_reconcile_old_index(const struct MboxReconcile *recon, int i);
+struct Email *        mbox_reconcile_adopt(struct MboxReconcile *recon, const struct MboxMap *map,
+                                           LOFF_T loc, int idx, LOFF_T *next);
+
+#endif /* MUTT_MBOX_RECONCILE_H */
@@ -66,6 +66,25 @@ static struct Menu **MenuStack = NULL;
 #define MUTT_SEARCH_UP 1
 #define MUTT_SEARCH_DOWN 2
 
+/**
+ * match_color - Find the first colour whose pattern matches an email
+ * @param color List of colours
+ * @param e     Email
+ * @retval num Colour pair in an integer, or 0 if none matches
+ */
+static int match_color(struct ColorLineHead *color, struct Email *e)
+{
+  struct ColorLine *np = NULL;
+
+  STAILQ_FOREACH(np, color, entries)
+  {
+    if (mutt_pattern_exec(np->color_pattern, MUTT_MATCH_FULL_ADDRESS, Context, e, NULL))
+      return np->pair;
+  }
+
+  return 0;
+}
+
 /**
  * get_color - Choose a colour for a line of the index
  * @param index Index number
@@ -74,10 +93,12 @@ static struct Menu **MenuStack = NULL;
  *
  * Text is coloured by inserting special characters into the string, e.g.
  * #MT_COLOR_INDEX_AUTHOR
+ *
+ * The colours of the author, subject and flags are kept in the Email until
+ * mutt_reset_header_color() is called.
  */
 static int get_color(int index, unsigned char *s)
 {
-  struct ColorLineHead *color = NULL;
   struct ColorLine *np = NULL;
   struct Email *e = Context->mailbox->hdrs[Context->mailbox->v2r[index]];
   int type = *s;
@@ -85,14 +106,26 @@ static int get_color(int index, unsigned char *s)
   switch (type)
   {
     case MT_COLOR_INDEX_AUTHOR:
-      color = &ColorIndexAuthorList;
-      break;
+      if (!e->author_pair_valid)
+      {
+        e->author_pair = match_color(&ColorIndexAuthorList, e);
+        e->author_pair_valid = true;
+      }
+      return e->author_pair;
     case MT_COLOR_INDEX_FLAGS:
-      color = &ColorIndexFlagsList;
-      break;
+      if (!e->flags_pair_valid)
+      {
+        e->flags_pair = match_color(&ColorIndexFlagsList, e);
+        e->flags_pair_valid = true;
+      }
+      return e->flags_pair;
     case MT_COLOR_INDEX_SUBJECT:
-      color = &ColorIndexSubjectList;
-      break;
+      if (!e->subject_pair_valid)
+      {
+        e->subject_pair = match_color(&ColorIndexSubjectList, e);
+        e->subject_pair_valid = true;
+      }
+      return e->subject_pair;
     case MT_COLOR_INDEX_TAG:
       STAILQ_FOREACH(np, &ColorIndexTagList, entries)
       {
@@ -109,14 +142,6 @@ static int get_color(int index, unsigned char *s)
     default:
       return ColorDefs[type];
   }
-
-  STAILQ_FOREACH(np, color, entries)
-  {
-    if (mutt_pattern_exec(np->color_pattern, MUTT_MATCH_FULL_ADDRESS, Context, e, NULL))
-      return np->pair;
-  }
-
-  return 0;
 }
 
 /**
@@ -943,12 +968,12 @@ static int default_color(int line)
 /**
  * generic_search - Search a menu for a item matching a regex - Implements Menu::menu_search()
  */
-static int generic_search(struct Menu *menu, regex_t *rx, int line)
+static int generic_search(struct Menu *menu, struct Regex *rx, int line)
 {
   char buf[LONG_STRING];
 
   menu_make_entry(buf, sizeof(buf), menu, line);
-  return regexec(rx, buf, 0, NULL, 0);
+  return mutt_regex_exec(rx, buf, 0, NULL, 0);
 }
 
 /**
@@ -1137,7 +1162,6 @@ static int menu_search(struct Menu *menu, int op)
 {
   int r = 0, wrap = 0;
   int search_dir;
-  regex_t re;
   char buf[SHORT_STRING];
   char *search_buf =
       menu->menu >= 0 && menu->menu < MENU_MAX ? SearchBuffers[menu->menu] : NULL;
@@ -1166,16 +1190,16 @@ static int menu_search(struct Menu *menu, int op)
   if (op == OP_SEARCH_OPPOSITE)
     search_dir = -search_dir;
 
-  if (search_buf)
-  {
-    int flags = mutt_mb_is_lower(search_buf) ? REG_ICASE : 0;
-    r = REGCOMP(&re, search_buf, REG_NOSUB | flags);
-  }
-
-  if (r != 0)
+  struct Buffer err;
+  mutt_buffer_init(&err);
+  err.data = buf;
+  err.dsize = sizeof(buf);
+  buf[0] = '\0';
+  struct Regex *rx = mutt_regex_create(search_buf, DT_REGEX_NOSUB, &err);
+  if (!rx)
   {
-    regerror(r, &re, buf, sizeof(buf));
-    mutt_error("%s", buf);
+    if (buf[0])
+      mutt_error("%s", buf);
     return -1;
   }
 
@@ -1185,9 +1209,9 @@ search_next:
     mutt_message(_("Search wrapped to top"));
   while (r >= 0 && r < menu->max)
   {
-    if (menu->menu_search(menu, &re, r) == 0)
+    if (menu->menu_search(menu, rx, r) == 0)
     {
-      regfree(&re);
+      mutt_regex_free(&rx);
       return r;
     }
 
@@ -1199,7 +1223,7 @@ search_next:
     r = search_dir == 1 ? 0 : menu->max - 1;
     goto search_next;
   }
-  regfree(&re);
+  mutt_regex_free(&rx);
   mutt_error(_("Not found"));
   return -1;
 }
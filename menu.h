@@ -35,6 +35,7 @@ extern bool  MenuScroll;  /**< scroll menu instead of implicit next-page */
 
 struct ConfigSet;
 struct HashElem;
+struct Regex;
 
 #define REDRAW_INDEX          (1 << 0)
 #define REDRAW_MOTION         (1 << 1)
@@ -102,7 +103,7 @@ struct Menu
    * @retval  0 Success
    * @retval >0 Error, e.g. REG_NOMATCH
    */
-  int  (*menu_search)       (struct Menu *menu, regex_t *rx, int line);
+  int  (*menu_search)       (struct Menu *menu, struct Regex *rx, int line);
   /**
    * menu_tag - Tag some menu items
    * @param menu Menu to tag
@@ -256,6 +256,27 @@ static const char *lookup_charset(enum LookupType type, const char *cs)
   return NULL;
 }
 
+/**
+ * default_charset - Get the default character set
+ * @param buf    Buffer for the name of the character set
+ * @param buflen Length of the buffer
+ * @retval ptr The buffer
+ */
+static char *default_charset(char *buf, size_t buflen)
+{
+  const char *c = AssumedCharset;
+  const char *c1 = NULL;
+
+  if (c && *c)
+  {
+    c1 = strchr(c, ':');
+    mutt_str_strfcpy(buf, c, c1 ? MIN((size_t)(c1 - c + 1), buflen) : buflen);
+    return buf;
+  }
+  mutt_str_strfcpy(buf, "us-ascii", buflen);
+  return buf;
+}
+
 /**
  * mutt_ch_convert_nonmime_string - Try to convert a string using a list of character sets
  * @param[in,out] ps String to be converted
@@ -295,7 +316,9 @@ int mutt_ch_convert_nonmime_string(char **ps)
       return 0;
     }
   }
-  mutt_ch_convert_string(ps, (const char *) mutt_ch_get_default_charset(),
+  /* not the static buffer, this may be called by the search threads */
+  char fcharset[SHORT_STRING];
+  mutt_ch_convert_string(ps, default_charset(fcharset, sizeof(fcharset)),
                          Charset, MUTT_ICONV_HOOK_FROM);
   return -1;
 }
@@ -398,16 +421,7 @@ bool mutt_ch_chscmp(const char *cs1, const char *cs2)
 char *mutt_ch_get_default_charset(void)
 {
   static char fcharset[SHORT_STRING];
-  const char *c = AssumedCharset;
-  const char *c1 = NULL;
-
-  if (c && *c)
-  {
-    c1 = strchr(c, ':');
-    mutt_str_strfcpy(fcharset, c, c1 ? (c1 - c + 1) : sizeof(fcharset));
-    return fcharset;
-  }
-  return strcpy(fcharset, "us-ascii");
+  return default_charset(fcharset, sizeof(fcharset));
 }
 
 /**
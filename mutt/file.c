@@ -39,8 +39,12 @@
 #include <string.h>
 #include <sys/file.h>
 #include <sys/stat.h>
+#include <sys/types.h>
 #include <unistd.h>
 #include <utime.h>
+#if defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H)
+#include <sys/sendfile.h>
+#endif
 #include "file.h"
 #include "logging.h"
 #include "memory.h"
@@ -57,6 +61,9 @@ static const char safe_chars[] =
 
 #define MAX_LOCK_ATTEMPTS 5
 
+/* Copies smaller than this aren't worth the extra system calls */
+#define COPY_RANGE_MIN 16384
+
 /* This is defined in POSIX:2008 which isn't a build requirement */
 #ifndef O_NOFOLLOW
 #define O_NOFOLLOW 0
@@ -226,6 +233,98 @@ void mutt_file_unlink(const char *s)
   }
 }
 
+/**
+ * copy_range - Let the kernel copy bytes between two regular files
+ * @param in   Source file
+ * @param out  Destination file
+ * @param size Maximum number of bytes to copy
+ * @retval num Number of bytes copied
+ *
+ * Both streams are flushed and the data is moved between the underlying file
+ * descriptors with copy_file_range() or sendfile(), so it never passes through
+ * stdio's buffers.  Afterwards both streams are positioned just after the
+ * copied data, so the caller can finish (or redo) the job using stdio.
+ *
+ * A return of 0 means that nothing was copied, e.g. because one of the files
+ * is a pipe, or the system doesn't support either call.
+ */
+static size_t copy_range(FILE *in, FILE *out, size_t size)
+{
+#if defined(HAVE_COPY_FILE_RANGE) || (defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H))
+  if (size < COPY_RANGE_MIN)
+    return 0;
+
+  const int fd_in = fileno(in);
+  const int fd_out = fileno(out);
+  if ((fd_in < 0) || (fd_out < 0))
+    return 0;
+
+  struct stat st;
+  if ((fstat(fd_in, &st) != 0) || !S_ISREG(st.st_mode))
+    return 0;
+  if ((fstat(fd_out, &st) != 0) || !S_ISREG(st.st_mode))
+    return 0;
+
+  if ((fflush(in) != 0) || (fflush(out) != 0))
+    return 0;
+
+  off_t off_in = ftello(in);
+  off_t off_out = ftello(out);
+  if ((off_in < 0) || (off_out < 0))
+    return 0;
+
+  /* Neither call will write to a file opened for appending.  Every write
+   * would land at the end anyway, so drop the flag for the duration. */
+  const int flags = fcntl(fd_out, F_GETFL);
+  if (flags < 0)
+    return 0;
+  if (flags & O_APPEND)
+  {
+    off_out = lseek(fd_out, 0, SEEK_END);
+    if ((off_out < 0) || (fcntl(fd_out, F_SETFL, flags & ~O_APPEND) != 0))
+      return 0;
+  }
+
+  size_t copied = 0;
+#ifdef HAVE_COPY_FILE_RANGE
+  while (copied < size)
+  {
+    ssize_t rc = copy_file_range(fd_in, &off_in, fd_out, &off_out, size - copied, 0);
+    if (rc <= 0)
+      break;
+    copied += rc;
+  }
+#endif
+#if defined(HAVE_SENDFILE) && defined(HAVE_SYS_SENDFILE_H)
+  /* copy_file_range() can't cross filesystems on older kernels */
+  if ((copied == 0) && (lseek(fd_out, off_out, SEEK_SET) == off_out))
+  {
+    while (copied < size)
+    {
+      ssize_t rc = sendfile(fd_out, fd_in, &off_in, size - copied);
+      if (rc <= 0)
+        break;
+      copied += rc;
+    }
+    off_out = lseek(fd_out, 0, SEEK_CUR);
+  }
+#endif
+
+  if (flags & O_APPEND)
+    fcntl(fd_out, F_SETFL, flags);
+
+  if (copied > 0)
+  {
+    mutt_debug(5, "copied %zu bytes in the kernel\n", copied);
+    if ((fseeko(in, off_in, SEEK_SET) != 0) || (fseeko(out, off_out, SEEK_SET) != 0))
+      return 0;
+  }
+  return copied;
+#else
+  return 0;
+#endif
+}
+
 /**
  * mutt_file_copy_bytes - Copy some content from one file to another
  * @param in   Source file
@@ -233,9 +332,14 @@ void mutt_file_unlink(const char *s)
  * @param size Maximum number of bytes to copy
  * @retval  0 Success
  * @retval -1 Error, see errno
+ *
+ * If both files are regular files, the bulk of the data is copied by the
+ * kernel, see copy_range().
  */
 int mutt_file_copy_bytes(FILE *in, FILE *out, size_t size)
 {
+  size -= copy_range(in, out, size);
+
   while (size > 0)
   {
     char buf[2048];
@@ -266,6 +370,14 @@ int mutt_file_copy_stream(FILE *fin, FILE *fout)
   size_t l;
   char buf[LONG_STRING];
 
+  struct stat st;
+  if ((fstat(fileno(fin), &st) == 0) && S_ISREG(st.st_mode))
+  {
+    const off_t pos = ftello(fin);
+    if ((pos >= 0) && (st.st_size > pos))
+      copy_range(fin, fout, st.st_size - pos);
+  }
+
   while ((l = fread(buf, 1, sizeof(buf), fin)) > 0)
   {
     if (fwrite(buf, 1, l, fout) != l)
@@ -25,34 +25,69 @@
  * @page hash Hash table data structure
  *
  * Hash table data structure.
+ *
+ * Each bucket holds a chain of HashElems.  When the table holds more elements
+ * than it has buckets, the number of buckets is doubled, so the chains stay
+ * short however many elements are added.
+ *
+ * The HashElems are allocated in slabs, rather than one at a time.  They
+ * never move, because callers keep pointers to them.
  */
 
 #include "config.h"
 #include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include "hash.h"
 #include "memory.h"
 #include "string2.h"
 
-#define SOMEPRIME 149711
+#define HASH_MIN_BUCKETS 8       /**< Smallest number of buckets in a table */
+#define HASH_MIN_SLAB    16      /**< Fewest HashElems allocated at once */
+#define HASH_MAX_SLAB    4096    /**< Most HashElems allocated at once */
+
+/**
+ * struct HashSlab - A block of HashElems
+ */
+struct HashSlab
+{
+  struct HashSlab *next;   /**< Next (older) slab */
+  struct HashElem elems[]; /**< Storage for the HashElems */
+};
+
+/**
+ * mix_hash - Scramble the bits of a hash
+ * @param h Hash to scramble
+ * @retval num Scrambled hash
+ *
+ * This is the final step of MurmurHash3.  Every bit of the input affects the
+ * low bits of the output, which are the ones that pick the bucket.
+ */
+static size_t mix_hash(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return (size_t) h;
+}
 
 /**
  * gen_string_hash - Generate a hash from a string
  * @param key String key
- * @param n   Number of elements in the Hash table
- * @retval num Cryptographic hash of the string
+ * @retval num Hash of the string (FNV-1a)
  */
-static size_t gen_string_hash(union HashKey key, size_t n)
+static size_t gen_string_hash(union HashKey key)
 {
-  size_t h = 0;
-  unsigned char *s = (unsigned char *) key.strkey;
+  uint64_t h = 0xcbf29ce484222325ULL;
+  const unsigned char *s = (const unsigned char *) key.strkey;
 
   while (*s)
-    h += ((h << 7) + *s++);
-  h = (h * SOMEPRIME) % n;
+    h = (h ^ *s++) * 0x100000001b3ULL;
 
-  return h;
+  return mix_hash(h);
 }
 
 /**
@@ -71,19 +106,17 @@ static int cmp_string_key(union HashKey a, union HashKey b)
 /**
  * gen_case_string_hash - Generate a hash from a string (ignore the case)
  * @param key String key
- * @param n   Number of elements in the Hash table
- * @retval num Cryptographic hash of the string
+ * @retval num Hash of the lowercased string (FNV-1a)
  */
-static size_t gen_case_string_hash(union HashKey key, size_t n)
+static size_t gen_case_string_hash(union HashKey key)
 {
-  size_t h = 0;
-  unsigned char *s = (unsigned char *) key.strkey;
+  uint64_t h = 0xcbf29ce484222325ULL;
+  const unsigned char *s = (const unsigned char *) key.strkey;
 
   while (*s)
-    h += ((h << 7) + tolower(*s++));
-  h = (h * SOMEPRIME) % n;
+    h = (h ^ (unsigned char) tolower(*s++)) * 0x100000001b3ULL;
 
-  return h;
+  return mix_hash(h);
 }
 
 /**
@@ -102,12 +135,11 @@ static int cmp_case_string_key(union HashKey a, union HashKey b)
 /**
  * gen_int_hash - Generate a hash from an integer
  * @param key Integer key
- * @param n   Number of elements in the Hash table
- * @retval num Cryptographic hash of the integer
+ * @retval num Hash of the integer
  */
-static size_t gen_int_hash(union HashKey key, size_t n)
+static size_t gen_int_hash(union HashKey key)
 {
-  return key.intkey % n;
+  return mix_hash(key.intkey);
 }
 
 /**
@@ -132,62 +164,133 @@ static int cmp_int_key(union HashKey a, union HashKey b)
  * @param nelem Number of elements it should contain
  * @retval ptr New Hash table
  *
- * The Hash table can contain more elements than nelem, but they will be
- * chained together.
+ * The Hash table will grow if it needs to hold more than nelem elements.
  */
 static struct Hash *new_hash(size_t nelem)
 {
   struct Hash *table = mutt_mem_calloc(1, sizeof(struct Hash));
-  if (nelem == 0)
-    nelem = 2;
-  table->nelem = nelem;
-  table->table = mutt_mem_calloc(nelem, sizeof(struct HashElem *));
+  table->nelem = HASH_MIN_BUCKETS;
+  while (table->nelem < nelem)
+    table->nelem *= 2;
+  table->table = mutt_mem_calloc(table->nelem, sizeof(struct HashElem *));
   return table;
 }
 
+/**
+ * grow_hash - Double the number of buckets in a Hash table
+ * @param table Hash table to grow
+ *
+ * Each chain is split in two.  The HashElems keep their relative order, so
+ * the newest of several duplicates is still found first.
+ */
+static void grow_hash(struct Hash *table)
+{
+  const size_t old = table->nelem;
+  struct HashElem **buckets = mutt_mem_calloc(old * 2, sizeof(struct HashElem *));
+
+  for (size_t i = 0; i < old; i++)
+  {
+    struct HashElem **lo = &buckets[i];
+    struct HashElem **hi = &buckets[i + old];
+
+    for (struct HashElem *ptr = table->table[i]; ptr; ptr = ptr->next)
+    {
+      if (ptr->hash & old)
+      {
+        *hi = ptr;
+        hi = &ptr->next;
+      }
+      else
+      {
+        *lo = ptr;
+        lo = &ptr->next;
+      }
+    }
+    *lo = NULL;
+    *hi = NULL;
+  }
+
+  FREE(&table->table);
+  table->table = buckets;
+  table->nelem = old * 2;
+}
+
+/**
+ * new_elem - Get an unused HashElem
+ * @param table Hash table that will hold the HashElem
+ * @retval ptr Unused HashElem
+ */
+static struct HashElem *new_elem(struct Hash *table)
+{
+  if (!table->spare)
+  {
+    /* Size the slab to the table, so that big tables need few allocations */
+    const size_t n = MIN(MAX(table->count, HASH_MIN_SLAB), HASH_MAX_SLAB);
+    struct HashSlab *slab =
+        mutt_mem_malloc(sizeof(struct HashSlab) + n * sizeof(struct HashElem));
+    slab->next = table->slabs;
+    table->slabs = slab;
+
+    for (size_t i = n; i > 0; i--)
+    {
+      slab->elems[i - 1].next = table->spare;
+      table->spare = &slab->elems[i - 1];
+    }
+  }
+
+  struct HashElem *ptr = table->spare;
+  table->spare = ptr->next;
+  return ptr;
+}
+
+/**
+ * free_elem - Return a HashElem to the table's spares
+ * @param table Hash table that held the HashElem
+ * @param ptr   HashElem that is no longer used
+ */
+static void free_elem(struct Hash *table, struct HashElem *ptr)
+{
+  ptr->next = table->spare;
+  table->spare = ptr;
+}
+
 /**
  * union_hash_insert - Insert into a hash table using a union as a key
  * @param table Hash table to update
  * @param key   Key to hash on
  * @param type  Data type
  * @param data  Data to associate with key
- * @retval ptr Newly inserted HashElem
+ * @retval ptr  Newly inserted HashElem
+ * @retval NULL The key is already present (and duplicates aren't allowed)
  */
 static struct HashElem *union_hash_insert(struct Hash *table, union HashKey key,
                                           int type, void *data)
 {
-  struct HashElem *ptr = mutt_mem_malloc(sizeof(struct HashElem));
-  unsigned int h = table->gen_hash(key, table->nelem);
-  ptr->key = key;
-  ptr->data = data;
-  ptr->type = type;
+  const size_t hash = table->gen_hash(key);
 
-  if (table->allow_dups)
+  if (!table->allow_dups)
   {
-    ptr->next = table->table[h];
-    table->table[h] = ptr;
-  }
-  else
-  {
-    struct HashElem *tmp = NULL, *last = NULL;
-
-    for (tmp = table->table[h], last = NULL; tmp; last = tmp, tmp = tmp->next)
+    for (struct HashElem *tmp = table->table[hash & (table->nelem - 1)]; tmp;
+         tmp = tmp->next)
     {
-      const int r = table->cmp_key(tmp->key, key);
-      if (r == 0)
-      {
-        FREE(&ptr);
+      if ((tmp->hash == hash) && (table->cmp_key(tmp->key, key) == 0))
         return NULL;
-      }
-      if (r > 0)
-        break;
     }
-    if (last)
-      last->next = ptr;
-    else
-      table->table[h] = ptr;
-    ptr->next = tmp;
   }
+
+  if (table->count >= table->nelem)
+    grow_hash(table);
+
+  struct HashElem *ptr = new_elem(table);
+  const size_t h = hash & (table->nelem - 1);
+  ptr->key = key;
+  ptr->data = data;
+  ptr->type = type;
+  ptr->hash = hash;
+  ptr->next = table->table[h];
+  table->table[h] = ptr;
+  table->count++;
+
   return ptr;
 }
 
@@ -199,17 +302,14 @@ static struct HashElem *union_hash_insert(struct Hash *table, union HashKey key,
  */
 static struct HashElem *union_hash_find_elem(const struct Hash *table, union HashKey key)
 {
-  int hash;
-  struct HashElem *ptr = NULL;
-
   if (!table)
     return NULL;
 
-  hash = table->gen_hash(key, table->nelem);
-  ptr = table->table[hash];
+  const size_t hash = table->gen_hash(key);
+  struct HashElem *ptr = table->table[hash & (table->nelem - 1)];
   for (; ptr; ptr = ptr->next)
   {
-    if (table->cmp_key(key, ptr->key) == 0)
+    if ((ptr->hash == hash) && (table->cmp_key(key, ptr->key) == 0))
       return ptr;
   }
   return NULL;
@@ -238,26 +338,27 @@ static void *union_hash_find(const struct Hash *table, union HashKey key)
  */
 static void union_hash_delete(struct Hash *table, union HashKey key, const void *data)
 {
-  int hash;
   struct HashElem *ptr, **last;
 
   if (!table)
     return;
 
-  hash = table->gen_hash(key, table->nelem);
-  ptr = table->table[hash];
-  last = &table->table[hash];
+  const size_t hash = table->gen_hash(key);
+  last = &table->table[hash & (table->nelem - 1)];
+  ptr = *last;
 
   while (ptr)
   {
-    if ((data == ptr->data || !data) && table->cmp_key(ptr->key, key) == 0)
+    if ((data == ptr->data || !data) && (ptr->hash == hash) &&
+        table->cmp_key(ptr->key, key) == 0)
     {
       *last = ptr->next;
+      table->count--;
       if (table->destroy)
         table->destroy(ptr->type, ptr->data, table->dest_data);
       if (table->strdup_keys)
         FREE(&ptr->key.strkey);
-      FREE(&ptr);
+      free_elem(table, ptr);
 
       ptr = *last;
     }
@@ -336,7 +437,10 @@ struct HashElem *mutt_hash_typed_insert(struct Hash *table, const char *strkey,
 {
   union HashKey key;
   key.strkey = table->strdup_keys ? mutt_str_strdup(strkey) : strkey;
-  return union_hash_insert(table, key, type, data);
+  struct HashElem *he = union_hash_insert(table, key, type, data);
+  if (!he && table->strdup_keys)
+    FREE(&key.strkey);
+  return he;
 }
 
 /**
@@ -410,19 +514,18 @@ void *mutt_hash_int_find(const struct Hash *table, unsigned int intkey)
  * @param strkey String key to search for
  * @retval ptr HashElem matching the key
  *
- * Unlike mutt_hash_find_elem(), this will return the first matching entry.
+ * Unlike mutt_hash_find_elem(), this will return the first entry of the key's
+ * bucket.  The caller must check the keys of the chain it walks.
  */
 struct HashElem *mutt_hash_find_bucket(const struct Hash *table, const char *strkey)
 {
   union HashKey key;
-  int hash;
 
   if (!table)
     return NULL;
 
   key.strkey = strkey;
-  hash = table->gen_hash(key, table->nelem);
-  return table->table[hash];
+  return table->table[table->gen_hash(key) & (table->nelem - 1)];
 }
 
 /**
@@ -474,9 +577,14 @@ void mutt_hash_destroy(struct Hash **ptr)
         pptr->destroy(tmp->type, tmp->data, pptr->dest_data);
       if (pptr->strdup_keys)
         FREE(&tmp->key.strkey);
-      FREE(&tmp);
     }
   }
+  while (pptr->slabs)
+  {
+    struct HashSlab *slab = pptr->slabs;
+    pptr->slabs = slab->next;
+    FREE(&slab);
+  }
   FREE(&pptr->table);
   FREE(ptr);
 }
@@ -45,6 +45,7 @@ struct HashElem
   union HashKey key;
   void *data;
   struct HashElem *next;
+  size_t hash;           /**< Full hash of the key (before it's reduced to a bucket) */
 };
 
 /**
@@ -55,19 +56,29 @@ struct HashElem
  */
 typedef void (*hash_destructor_t)(int type, void *obj, intptr_t data);
 
+struct HashSlab;
+
 /**
  * struct Hash - A Hash Table
+ *
+ * The number of buckets is a power of two and doubles whenever the table holds
+ * more elements than buckets.  The HashElems are carved out of slabs owned by
+ * the table, so they never move: a HashElem pointer stays valid until the
+ * element is deleted.
  */
 struct Hash
 {
-  size_t nelem;
+  size_t nelem;                  /**< Number of buckets (a power of two) */
+  size_t count;                  /**< Number of elements in the table */
   bool strdup_keys : 1; /**< if set, the key->strkey is strdup'ed */
   bool allow_dups  : 1; /**< if set, duplicate keys are allowed */
   struct HashElem **table;
-  size_t (*gen_hash)(union HashKey, size_t);
+  size_t (*gen_hash)(union HashKey);
   int (*cmp_key)(union HashKey, union HashKey);
   hash_destructor_t destroy;
   intptr_t dest_data;
+  struct HashSlab *slabs;        /**< Blocks of memory holding the HashElems */
+  struct HashElem *spare;        /**< Unused HashElems, linked by 'next' */
 };
 
 /* flags for mutt_hash_create() */
@@ -0,0 +1,203 @@
+/**
+ * @file
+ * Share copies of frequently repeated strings
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page intern Share copies of frequently repeated strings
+ *
+ * In a large mailbox, the same few names and email addresses appear in the
+ * headers of thousands of messages.  Interning a string returns a shared,
+ * reference-counted copy of it, so each distinct value is stored only once.
+ *
+ * An interned string must be treated as read-only.  It must be released with
+ * mutt_intern_free(), which will also free an ordinary string.  Code that
+ * needs to modify a string, that may be shared, must call
+ * mutt_intern_unshare() first.
+ *
+ * | Function                | Description
+ * | :---------------------- | :-------------------------------------------
+ * | mutt_intern_add()       | Get a shared copy of a string
+ * | mutt_intern_free()      | Release a string, shared or not
+ * | mutt_intern_is_shared() | Is this string a shared copy?
+ * | mutt_intern_unshare()   | Make sure a string isn't shared
+ */
+
+#include "config.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#include "intern.h"
+#include "hash.h"
+#include "memory.h"
+#include "string2.h"
+
+/* The shared strings are the keys of this table.  The data is the number of
+ * references to each. */
+static struct Hash *InternTable = NULL;
+#ifdef HAVE_PTHREAD
+/* Strings may be freed by the search threads */
+static pthread_mutex_t InternLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**
+ * find_shared - Find the table entry for a shared string
+ * @param str String to look for
+ * @retval ptr Table entry, if str is a shared copy
+ * @retval NULL Otherwise, including if str is an equal, but private, string
+ *
+ * @note The caller must hold the lock
+ */
+static struct HashElem *find_shared(const char *str)
+{
+  if (!str || !InternTable)
+    return NULL;
+
+  struct HashElem *he = mutt_hash_find_elem(InternTable, str);
+  if (!he || (he->key.strkey != str))
+    return NULL;
+
+  return he;
+}
+
+/**
+ * release - Drop a reference to a shared string
+ * @param he Table entry of the string
+ *
+ * Once the last string has been released, the table is freed, too.
+ *
+ * @note The caller must hold the lock
+ */
+static void release(struct HashElem *he)
+{
+  intptr_t refs = (intptr_t) he->data - 1;
+  if (refs > 0)
+  {
+    he->data = (void *) refs;
+    return;
+  }
+
+  mutt_hash_delete(InternTable, he->key.strkey, NULL);
+  if (InternTable->count == 0)
+    mutt_hash_destroy(&InternTable);
+}
+
+/**
+ * mutt_intern_add - Get a shared copy of a string
+ * @param str String to copy
+ * @retval ptr Shared copy of the string
+ * @retval NULL str was NULL
+ *
+ * The result must be released with mutt_intern_free().
+ */
+char *mutt_intern_add(const char *str)
+{
+  if (!str)
+    return NULL;
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&InternLock);
+#endif
+  if (!InternTable)
+    InternTable = mutt_hash_create(1024, MUTT_HASH_STRDUP_KEYS);
+
+  struct HashElem *he = mutt_hash_find_elem(InternTable, str);
+  if (he)
+    he->data = (void *) ((intptr_t) he->data + 1);
+  else
+    he = mutt_hash_insert(InternTable, str, (void *) (intptr_t) 1);
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock(&InternLock);
+#endif
+
+  return (char *) he->key.strkey;
+}
+
+/**
+ * mutt_intern_free - Release a string, shared or not
+ * @param ptr String to free
+ *
+ * If the string is a shared copy, one reference to it is dropped.  Otherwise,
+ * it's freed.
+ */
+void mutt_intern_free(char **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&InternLock);
+#endif
+  struct HashElem *he = find_shared(*ptr);
+  if (he)
+  {
+    release(he);
+    *ptr = NULL;
+  }
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock(&InternLock);
+#endif
+
+  FREE(ptr);
+}
+
+/**
+ * mutt_intern_is_shared - Is this string a shared copy?
+ * @param str String to test
+ * @retval true str was returned by mutt_intern_add()
+ */
+bool mutt_intern_is_shared(const char *str)
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&InternLock);
+#endif
+  const bool shared = find_shared(str);
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock(&InternLock);
+#endif
+
+  return shared;
+}
+
+/**
+ * mutt_intern_unshare - Make sure a string isn't shared
+ * @param ptr String to check
+ *
+ * If the string is a shared copy, it's replaced by a private copy, which the
+ * caller may then modify or free.
+ */
+void mutt_intern_unshare(char **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&InternLock);
+#endif
+  struct HashElem *he = find_shared(*ptr);
+  if (he)
+  {
+    *ptr = mutt_str_strdup(*ptr);
+    release(he);
+  }
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock(&InternLock);
+#endif
+}
@@ -36,6 +36,7 @@
  * | mutt/file.c      | @subpage file      |
  * | mutt/hash.c      | @subpage hash      |
  * | mutt/history.c   | @subpage history   |
+ * | mutt/intern.c    | @subpage intern    |
  * | mutt/list.c      | @subpage list      |
  * | mutt/logging.c   | @subpage logging   |
  * | mutt/mapping.c   | @subpage mapping   |
@@ -46,7 +47,9 @@
  * | mutt/regex.c     | @subpage regex     |
  * | mutt/sha1.c      | @subpage sha1      |
  * | mutt/signal.c    | @subpage signal    |
+ * | mutt/slab.c      | @subpage slab      |
  * | mutt/string.c    | @subpage string    |
+ * | mutt/words.c     | @subpage words     |
  *
  * @note The library is self-contained -- some files may depend on others in
  *       the library, but none depends on source from outside.
@@ -64,6 +67,7 @@
 #include "file.h"
 #include "hash.h"
 #include "history.h"
+#include "intern.h"
 #include "list.h"
 #include "logging.h"
 #include "mapping.h"
@@ -76,6 +80,8 @@
 #include "regex3.h"
 #include "sha1.h"
 #include "signal2.h"
+#include "slab.h"
 #include "string2.h"
+#include "words.h"
 
 #endif /* MUTT_LIB_MUTT_H */
@@ -24,6 +24,18 @@
  * @page regex Manage regular expressions
  *
  * Manage regular expressions.
+ *
+ * When a regex is compiled, the longest run of plain text that every match
+ * must contain is pulled out of it (see mutt_regex_literal_new()).  Strings
+ * that don't contain that text are rejected with a substring search, which is
+ * much cheaper than running the regex engine.
+ *
+ * If NeoMutt is built with PCRE2, each regex is also compiled (with JIT) by
+ * PCRE2, as long as it means the same in both syntaxes.  mutt_regex_exec()
+ * then uses PCRE2 instead of regexec() to tell whether a string matches.
+ * PCRE2 picks the first match it finds and POSIX the longest, so the
+ * position of a match always comes from regexec().  The POSIX version is
+ * always compiled: it checks the syntax and is used for everything else.
  */
 
 #include "config.h"
@@ -40,6 +52,277 @@
 #include "message.h"
 #include "regex3.h"
 #include "string2.h"
+#ifdef USE_PCRE2
+#include <langinfo.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#include "charset.h"
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+#endif
+
+/**
+ * skip_bracket - Skip over a bracket expression
+ * @param p Opening '['
+ * @retval ptr First character after the closing ']'
+ *
+ * A ']' at the start is part of the set, as are classes like [:alpha:]
+ */
+static const char *skip_bracket(const char *p)
+{
+  p++;
+  if (*p == '^')
+    p++;
+  if (*p == ']')
+    p++;
+  while (*p && (*p != ']'))
+  {
+    if ((*p == '[') && ((p[1] == ':') || (p[1] == '.') || (p[1] == '=')))
+    {
+      const char end = p[1];
+      for (p += 2; *p && !((p[0] == end) && (p[1] == ']')); p++)
+        ;
+      if (*p)
+        p++;
+    }
+    if (*p)
+      p++;
+  }
+  if (*p)
+    p++;
+
+  return p;
+}
+
+/**
+ * skip_group - Skip over a parenthesised group
+ * @param p Opening '('
+ * @retval ptr First character after the matching ')'
+ */
+static const char *skip_group(const char *p)
+{
+  int depth = 0;
+  while (*p)
+  {
+    if (*p == '[')
+    {
+      p = skip_bracket(p);
+      continue;
+    }
+    if ((*p == '\\') && p[1])
+      p++;
+    else if (*p == '(')
+      depth++;
+    else if ((*p == ')') && (--depth == 0))
+      return p + 1;
+    p++;
+  }
+
+  return p;
+}
+
+/**
+ * skip_char - Skip over one (possibly multibyte) character
+ * @param p Character
+ * @retval ptr Next character
+ *
+ * A UTF-8 character is kept whole.  In other charsets this may swallow
+ * several characters, which only makes the literal shorter.
+ */
+static const char *skip_char(const char *p)
+{
+  if ((unsigned char) *p++ >= 0x80)
+    while (((unsigned char) *p & 0xC0) == 0x80)
+      p++;
+  return p;
+}
+
+#ifdef USE_PCRE2
+/**
+ * pcre_compatible - Does PCRE2 read a regex the same way as regcomp()?
+ * @param str   Extended regular expression
+ * @param flags Flags used to compile the regex, e.g. REG_NEWLINE
+ * @retval true PCRE2 can be used instead of regexec()
+ *
+ * PCRE2 reads most of the POSIX extended syntax the same way, except:
+ * - escapes of letters, e.g. "\\d", and GNU's word anchors "\\<" and "\\>"
+ * - back-references, which the C library treats in its own way
+ * - backslashes in a bracket, which are literal to POSIX
+ * - a quantifier followed by '?' or '+', which PCRE2 reads as lazy/possessive
+ * - intervals like "{,3}" and verbs like "(*UTF)"
+ * - "[^...]" with REG_NEWLINE, which POSIX won't match with a newline
+ *
+ * These stay with regexec().  "\\w", "\\s", "\\b" (and their opposites) are
+ * the same in both.
+ */
+static bool pcre_compatible(const char *str, int flags)
+{
+  for (const char *p = str; *p; p++)
+  {
+    if (*p == '\\')
+    {
+      p++;
+      if (!*p || !strchr(".[]()*+?{}|^$\\wWsSbB", *p))
+        return false;
+    }
+    else if (*p == '[')
+    {
+      if ((flags & REG_NEWLINE) && (p[1] == '^'))
+        return false;
+      const char *end = skip_bracket(p);
+      if (memchr(p, '\\', end - p))
+        return false;
+      p = end - 1;
+    }
+    else if (strchr("*+?}", *p) && p[1] && strchr("?+", p[1]))
+      return false;
+    else if (((*p == '{') && (p[1] == ',')) || ((*p == '(') && (p[1] == '*')))
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * pcre_new - Compile a regex with PCRE2
+ * @param str   Extended regular expression
+ * @param flags Flags used to compile the regex, e.g. REG_ICASE
+ * @retval ptr  Compiled expression, see mutt_regex_exec()
+ * @retval NULL The expression must be matched by regexec()
+ *
+ * PCRE2 is only used in UTF-8 locales, where its Unicode support agrees with
+ * the C library's.  The expression is JIT-compiled, if the platform allows.
+ */
+static void *pcre_new(const char *str, int flags)
+{
+  if (!mutt_ch_is_utf8(nl_langinfo(CODESET)) || !pcre_compatible(str, flags))
+    return NULL;
+
+  uint32_t opts = PCRE2_UTF | PCRE2_UCP;
+#ifdef PCRE2_MATCH_INVALID_UTF
+  opts |= PCRE2_MATCH_INVALID_UTF;
+#endif
+  if (flags & REG_ICASE)
+    opts |= PCRE2_CASELESS;
+  if (flags & REG_NEWLINE)
+    opts |= PCRE2_MULTILINE | PCRE2_ALT_CIRCUMFLEX;
+  else
+    opts |= PCRE2_DOTALL | PCRE2_DOLLAR_ENDONLY;
+
+  int err = 0;
+  PCRE2_SIZE offset = 0;
+  pcre2_code *code =
+      pcre2_compile((PCRE2_SPTR) str, PCRE2_ZERO_TERMINATED, opts, &err, &offset, NULL);
+  if (!code)
+  {
+    mutt_debug(3, "PCRE2 can't compile '%s' (error %d at %zu)\n", str, err, offset);
+    return NULL;
+  }
+
+  pcre2_jit_compile(code, PCRE2_JIT_COMPLETE);
+  return code;
+}
+
+#ifdef HAVE_PTHREAD
+static pthread_key_t MatchDataKey;                       ///< Each thread's pcre2_match_data
+static pthread_once_t MatchDataOnce = PTHREAD_ONCE_INIT; ///< Creates MatchDataKey
+
+/**
+ * match_data_free - Free a thread's match data - Implements pthread_key_create()
+ */
+static void match_data_free(void *md)
+{
+  pcre2_match_data_free(md);
+}
+
+/**
+ * match_data_key - Create the key for the threads' match data
+ */
+static void match_data_key(void)
+{
+  pthread_key_create(&MatchDataKey, match_data_free);
+}
+#else
+static pcre2_match_data *MatchData = NULL; ///< Match data for every match
+#endif
+
+/**
+ * get_match_data - Get the match data of the current thread
+ * @retval ptr  Match data, with room for one match
+ * @retval NULL Out of memory
+ *
+ * Only whether a string matches is needed, so one pair of offsets is enough
+ * for any expression.  The match data is kept for the next match.
+ */
+static pcre2_match_data *get_match_data(void)
+{
+#ifdef HAVE_PTHREAD
+  pthread_once(&MatchDataOnce, match_data_key);
+  pcre2_match_data *md = pthread_getspecific(MatchDataKey);
+  if (!md)
+  {
+    md = pcre2_match_data_create(1, NULL);
+    pthread_setspecific(MatchDataKey, md);
+  }
+  return md;
+#else
+  if (!MatchData)
+    MatchData = pcre2_match_data_create(1, NULL);
+  return MatchData;
+#endif
+}
+
+/**
+ * pcre_exec - Check whether a string matches, using PCRE2
+ * @param code   Compiled expression, from pcre_new()
+ * @param str    String to match
+ * @param eflags Flags for regexec(), e.g. REG_NOTBOL
+ * @retval 0           String matches
+ * @retval REG_NOMATCH String doesn't match
+ * @retval -1          PCRE2 failed, e.g. it ran out of stack; use regexec()
+ */
+static int pcre_exec(void *code, const char *str, int eflags)
+{
+  pcre2_match_data *md = get_match_data();
+  if (!md)
+    return -1;
+
+  uint32_t opts = 0;
+  if (eflags & REG_NOTBOL)
+    opts |= PCRE2_NOTBOL;
+  if (eflags & REG_NOTEOL)
+    opts |= PCRE2_NOTEOL;
+
+  int rc = pcre2_match(code, (PCRE2_SPTR) str, PCRE2_ZERO_TERMINATED, 0, opts, md, NULL);
+  if (rc >= 0)
+    return 0;
+  if (rc == PCRE2_ERROR_NOMATCH)
+    return REG_NOMATCH;
+
+  mutt_debug(3, "PCRE2 match failed (error %d)\n", rc);
+  return -1;
+}
+#endif
+
+/**
+ * mutt_regex_prepare - Set up the fast paths of a compiled Regex
+ * @param r     Regex, already compiled by regcomp()
+ * @param str   Regular expression, without any '!' prefix
+ * @param flags Flags used to compile the regex, e.g. REG_ICASE
+ *
+ * This is only needed by callers that fill in a Regex themselves.
+ */
+void mutt_regex_prepare(struct Regex *r, const char *str, int flags)
+{
+  if (!r || !str)
+    return;
+
+  r->literal = mutt_regex_literal_new(str, flags);
+#ifdef USE_PCRE2
+  r->pcre = pcre_new(str, flags);
+#endif
+}
 
 /**
  * mutt_regex_compile - Create an Regex from a string
@@ -55,6 +338,8 @@ struct Regex *mutt_regex_compile(const char *str, int flags)
   r->regex = mutt_mem_calloc(1, sizeof(regex_t));
   if (REGCOMP(r->regex, NONULL(str), flags) != 0)
     mutt_regex_free(&r);
+  else
+    mutt_regex_prepare(r, NONULL(str), flags);
 
   return r;
 }
@@ -82,6 +367,9 @@ struct Regex *mutt_regex_create(const char *str, int flags, struct Buffer *err)
   if (((flags & DT_REGEX_MATCH_CASE) == 0) && mutt_mb_is_lower(str))
     rflags |= REG_ICASE;
 
+  if ((flags & DT_REGEX_NOSUB))
+    rflags |= REG_NOSUB;
+
   /* Is a prefix of '!' allowed? */
   if (((flags & DT_REGEX_ALLOW_NOT) != 0) && (str[0] == '!'))
   {
@@ -96,6 +384,8 @@ struct Regex *mutt_regex_create(const char *str, int flags, struct Buffer *err)
     mutt_regex_free(&reg);
     return NULL;
   }
+  if (rc == 0)
+    mutt_regex_prepare(reg, str, rflags);
 
   return reg;
 }
@@ -113,9 +403,206 @@ void mutt_regex_free(struct Regex **r)
   if ((*r)->regex)
     regfree((*r)->regex);
   FREE(&(*r)->regex);
+  mutt_regex_literal_free(&(*r)->literal);
+#ifdef USE_PCRE2
+  pcre2_code_free((*r)->pcre);
+#endif
   FREE(r);
 }
 
+/**
+ * mutt_regex_exec - Match a string against a Regex
+ * @param r      Regex to use
+ * @param str    String to match
+ * @param nmatch Number of entries in pmatch
+ * @param pmatch Array for the positions of the match (optional)
+ * @param eflags Flags for regexec(), e.g. REG_NOTBOL
+ * @retval 0           String matches
+ * @retval REG_NOMATCH String doesn't match
+ *
+ * This is a drop-in replacement for regexec() which checks the Regex's
+ * literal text first.  Like regexec(), it ignores the Regex's 'not' flag.
+ */
+int mutt_regex_exec(const struct Regex *r, const char *str, size_t nmatch,
+                    regmatch_t pmatch[], int eflags)
+{
+  if (!r || !r->regex || !str)
+    return REG_NOMATCH;
+
+  if (mutt_regex_literal_excludes(r->literal, str))
+    return REG_NOMATCH;
+
+#ifdef USE_PCRE2
+  /* Only regexec() gives the leftmost-longest position of a match */
+  if (r->pcre && (nmatch == 0))
+  {
+    int rc = pcre_exec(r->pcre, str, eflags);
+    if (rc != -1)
+      return rc;
+  }
+#endif
+
+  return regexec(r->regex, str, nmatch, pmatch, eflags);
+}
+
+/**
+ * mutt_regex_literal_new - Find the text that every match of a regex contains
+ * @param str   Extended regular expression, as used by REGCOMP()
+ * @param flags Flags used to compile the regex, e.g. REG_ICASE
+ * @retval ptr  Literal text
+ * @retval NULL No text is certain, e.g. the regex has alternatives
+ *
+ * The regex is split into runs of plain characters; escapes, brackets,
+ * groups, anchors, and characters made optional by a quantifier all end a
+ * run.  The longest run is kept, e.g. every match of "fo+bar.*ba?z" contains
+ * "bar".  A case-insensitive literal is stored in lower case and may only
+ * contain ASCII, whose case folding is the same as the regex engine's.
+ *
+ * The caller must free the result with mutt_regex_literal_free().
+ */
+struct RegexLiteral *mutt_regex_literal_new(const char *str, int flags)
+{
+  if (!str)
+    return NULL;
+
+  const bool icase = (flags & REG_ICASE);
+  const size_t slen = strlen(str);
+  char *run = mutt_mem_malloc(slen + 1);
+  char *best = mutt_mem_malloc(slen + 1);
+  size_t run_len = 0, best_len = 0;
+
+  const char *p = str;
+  while (true)
+  {
+    const char *atom = p;
+    const char *next = NULL;
+    bool literal = false;
+
+    if (*p == '|')
+    {
+      /* Alternatives at the top level: nothing is certain */
+      best_len = 0;
+      break;
+    }
+    else if (*p == '[')
+      next = skip_bracket(p);
+    else if (*p == '(')
+      next = skip_group(p);
+    else if (*p == '\\')
+    {
+      if (p[1] && strchr(".[]()*+?{}|^$\\", p[1]))
+      {
+        atom = p + 1;
+        literal = true;
+        next = p + 2;
+      }
+      else
+        next = p[1] ? skip_char(p + 1) : p + 1;
+    }
+    else if (*p && !strchr(".^$)*+?{", *p))
+    {
+      next = skip_char(p);
+      literal = !icase || ((unsigned char) *p < 0x80);
+    }
+    else if (*p)
+      next = p + 1;
+
+    /* Quantifiers apply to the atom before them */
+    const char *atom_end = next;
+    bool end_run = !literal;
+    if (next)
+    {
+      while (*next && strchr("*+?{", *next))
+      {
+        if (*next != '+')
+          literal = false;
+        end_run = true;
+        if (*next == '{')
+          while (*next && (*next != '}'))
+            next++;
+        if (*next)
+          next++;
+      }
+    }
+
+    if (literal)
+    {
+      for (const char *c = atom; c < atom_end; c++)
+        run[run_len++] = icase ? tolower((unsigned char) *c) : *c;
+    }
+
+    if (end_run || !next)
+    {
+      if (run_len > best_len)
+      {
+        memcpy(best, run, run_len);
+        best_len = run_len;
+      }
+      run_len = 0;
+    }
+
+    if (!next)
+      break;
+    p = next;
+  }
+
+  FREE(&run);
+  if (best_len == 0)
+  {
+    FREE(&best);
+    return NULL;
+  }
+
+  best[best_len] = '\0';
+  struct RegexLiteral *lit = mutt_mem_calloc(1, sizeof(struct RegexLiteral));
+  lit->text = best;
+  lit->len = best_len;
+  lit->icase = icase;
+  lit->first[0] = best[0];
+  if (icase && (toupper((unsigned char) best[0]) != best[0]))
+    lit->first[1] = toupper((unsigned char) best[0]);
+
+  return lit;
+}
+
+/**
+ * mutt_regex_literal_excludes - Can a string be rejected without the regex?
+ * @param lit Literal text of a regex (may be NULL)
+ * @param str String to test
+ * @retval true  String doesn't contain the literal, so the regex can't match
+ * @retval false String might match; the regex must be run
+ */
+bool mutt_regex_literal_excludes(const struct RegexLiteral *lit, const char *str)
+{
+  if (!lit || !str)
+    return false;
+
+  if (!lit->icase)
+    return !strstr(str, lit->text);
+
+  /* Look for either case of the first character, then compare the rest */
+  for (const char *p = strpbrk(str, lit->first); p; p = strpbrk(p + 1, lit->first))
+  {
+    if (mutt_str_strncasecmp(p + 1, lit->text + 1, lit->len - 1) == 0)
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * mutt_regex_literal_free - Free a RegexLiteral
+ * @param lit RegexLiteral to free
+ */
+void mutt_regex_literal_free(struct RegexLiteral **lit)
+{
+  if (!lit || !*lit)
+    return;
+
+  FREE(&(*lit)->text);
+  FREE(lit);
+}
+
 /**
  * mutt_regexlist_add - Compile a regex string and add it to a list
  * @param rl    RegexList to add to
@@ -193,7 +680,7 @@ bool mutt_regexlist_match(struct RegexList *rl, const char *str)
   {
     if (!np->regex || !np->regex->regex)
       continue;
-    if (regexec(np->regex->regex, str, 0, NULL, 0) == 0)
+    if (mutt_regex_exec(np->regex, str, 0, NULL, 0) == 0)
     {
       mutt_debug(5, "%s matches %s\n", str, np->regex->pattern);
       return true;
@@ -378,7 +865,7 @@ char *mutt_replacelist_apply(struct ReplaceList *rl, char *buf, size_t buflen, c
       nmatch = np->nmatch;
     }
 
-    if (regexec(np->regex->regex, src, np->nmatch, pmatch, 0) == 0)
+    if (mutt_regex_exec(np->regex, src, np->nmatch, pmatch, 0) == 0)
     {
       tlen = 0;
       switcher ^= 1;
@@ -490,7 +977,7 @@ bool mutt_replacelist_match(struct ReplaceList *rl, char *buf, size_t buflen, co
     }
 
     /* Does this pattern match? */
-    if (regexec(np->regex->regex, str, (size_t) np->nmatch, pmatch, 0) == 0)
+    if (mutt_regex_exec(np->regex, str, (size_t) np->nmatch, pmatch, 0) == 0)
     {
       mutt_debug(5, "%s matches %s\n", str, np->regex->pattern);
       mutt_debug(5, "%d subs\n", (int) np->regex->regex->re_nsub);
@@ -51,14 +51,30 @@ struct Buffer;
  */
 #define REGCOMP(X, Y, Z) regcomp(X, Y, REG_WORDS | REG_EXTENDED | (Z))
 
+/**
+ * struct RegexLiteral - Text that every match of a regex contains
+ *
+ * If a string doesn't contain the text, it can't match the regex, so a cheap
+ * substring search can save a call to regexec().
+ */
+struct RegexLiteral
+{
+  char *text;    /**< Literal text, in lower case if icase is set */
+  size_t len;    /**< Length of text */
+  char first[3]; /**< First character of text, in both cases */
+  bool icase;    /**< Ignore (ASCII) case when searching */
+};
+
 /**
  * struct Regex - Cached regular expression
  */
 struct Regex
 {
-  char *pattern;  /**< printable version */
-  regex_t *regex; /**< compiled expression */
-  bool not;       /**< do not match */
+  char *pattern;                /**< printable version */
+  regex_t *regex;               /**< compiled expression */
+  bool not;                     /**< do not match */
+  struct RegexLiteral *literal; /**< text every match contains */
+  void *pcre;                   /**< PCRE2 version of the expression (optional) */
 };
 
 /**
@@ -86,7 +102,13 @@ STAILQ_HEAD(ReplaceList, ReplaceListNode);
 
 struct Regex *mutt_regex_compile(const char *str, int flags);
 struct Regex *mutt_regex_create(const char *str, int flags, struct Buffer *err);
+int           mutt_regex_exec(const struct Regex *r, const char *str, size_t nmatch, regmatch_t pmatch[], int eflags);
 void          mutt_regex_free(struct Regex **r);
+void          mutt_regex_prepare(struct Regex *r, const char *str, int flags);
+
+bool                 mutt_regex_literal_excludes(const struct RegexLiteral *lit, const char *str);
+void                 mutt_regex_literal_free(struct RegexLiteral **lit);
+struct RegexLiteral *mutt_regex_literal_new(const char *str, int flags);
 
 int                   mutt_regexlist_add(struct RegexList *rl, const char *str, int flags, struct Buffer *err);
 void                  mutt_regexlist_free(struct RegexList *rl);
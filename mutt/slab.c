@@ -0,0 +1,243 @@
+/**
+ * @file
+ * Allocate the objects of a mailbox from one region
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page slab Allocate the objects of a mailbox from one region
+ *
+ * A mailbox holds an Email, an Envelope, a Body and several Addresses for
+ * every message.  Allocating them one at a time costs a malloc() each, plus
+ * the allocator's overhead, and freeing them costs a free() each.
+ *
+ * A SlabPool reserves a large region of address space and hands out objects
+ * from it in turn.  Only the pages that are used take up memory.  Freed
+ * objects are kept for reuse.  When the pool is closed and its last object
+ * has been freed, the region is unmapped in one step.
+ *
+ * Objects can be freed without knowing their pool: an object that's outside
+ * every pool came from malloc().  This is also where the objects go if the
+ * region can't be reserved, or is full.
+ *
+ * | Function              | Description
+ * | :-------------------- | :---------------------------------------
+ * | mutt_slab_alloc()     | Allocate a zeroed object
+ * | mutt_slab_free()      | Free an object
+ * | mutt_slab_pool_free() | Close a pool
+ * | mutt_slab_pool_new()  | Create a pool
+ */
+
+#include "config.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#include "slab.h"
+#include "memory.h"
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+/* Address space reserved for each pool, enough for millions of messages */
+#define SLAB_RESERVE ((size_t) 8 << 30)
+
+/* Objects are aligned like this */
+#define SLAB_ALIGN sizeof(union { void *ptr; long long ll; double d; })
+
+/* Pools that have objects in use */
+static struct SlabPool *Pools = NULL;
+
+#ifdef HAVE_PTHREAD
+/* Objects may be allocated and freed by the search and Maildir threads */
+static pthread_mutex_t SlabLock = PTHREAD_MUTEX_INITIALIZER;
+#define SLAB_LOCK() pthread_mutex_lock(&SlabLock)
+#define SLAB_UNLOCK() pthread_mutex_unlock(&SlabLock)
+#else
+#define SLAB_LOCK()
+#define SLAB_UNLOCK()
+#endif
+
+/**
+ * release_pool - Unmap a pool's region and free the pool
+ * @param pool Pool with no objects in use
+ *
+ * The caller must hold the lock.
+ */
+static void release_pool(struct SlabPool *pool)
+{
+  for (struct SlabPool **pp = &Pools; *pp; pp = &(*pp)->next_pool)
+  {
+    if (*pp == pool)
+    {
+      *pp = pool->next_pool;
+      break;
+    }
+  }
+
+  munmap(pool->base, pool->end - pool->base);
+  FREE(&pool);
+}
+
+/**
+ * find_class - Find the freed objects of a given size
+ * @param pool Pool
+ * @param size Size of the objects, rounded up
+ * @retval ptr  Class of the objects
+ * @retval NULL The pool has too many sizes already
+ */
+static struct SlabClass *find_class(struct SlabPool *pool, size_t size)
+{
+  for (size_t i = 0; i < SLAB_MAX_CLASSES; i++)
+  {
+    struct SlabClass *sc = &pool->classes[i];
+    if (sc->size == 0)
+      sc->size = size;
+    if (sc->size == size)
+      return sc;
+  }
+  return NULL;
+}
+
+/**
+ * mutt_slab_pool_new - Create a pool
+ * @retval ptr  New pool
+ * @retval NULL The address space couldn't be reserved
+ */
+struct SlabPool *mutt_slab_pool_new(void)
+{
+  /* A 32-bit process can't spare the address space */
+  if (sizeof(void *) < 8)
+    return NULL;
+
+  void *base = mmap(NULL, SLAB_RESERVE, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (base == MAP_FAILED)
+    return NULL;
+
+  struct SlabPool *pool = mutt_mem_calloc(1, sizeof(struct SlabPool));
+  pool->base = base;
+  pool->next = base;
+  pool->end = pool->base + SLAB_RESERVE;
+
+  SLAB_LOCK();
+  pool->next_pool = Pools;
+  Pools = pool;
+  SLAB_UNLOCK();
+  return pool;
+}
+
+/**
+ * mutt_slab_pool_free - Close a pool
+ * @param pool Pool to close (may be NULL)
+ *
+ * If all the pool's objects have been freed, its region is released now.
+ * Otherwise, it's released with the last object.
+ */
+void mutt_slab_pool_free(struct SlabPool **pool)
+{
+  if (!pool || !*pool)
+    return;
+
+  SLAB_LOCK();
+  (*pool)->closed = true;
+  if ((*pool)->used == 0)
+    release_pool(*pool);
+  SLAB_UNLOCK();
+  *pool = NULL;
+}
+
+/**
+ * mutt_slab_alloc - Allocate an object
+ * @param pool Pool to use, or NULL for malloc()
+ * @param size Size of the object
+ * @retval ptr New object, filled with zeroes
+ */
+void *mutt_slab_alloc(struct SlabPool *pool, size_t size)
+{
+  if (!pool)
+    return mutt_mem_calloc(1, size);
+
+  size = (size + SLAB_ALIGN - 1) / SLAB_ALIGN * SLAB_ALIGN;
+  void *obj = NULL;
+
+  SLAB_LOCK();
+  struct SlabClass *sc = find_class(pool, size);
+  if (sc && sc->spare)
+  {
+    obj = sc->spare;
+    sc->spare = *(void **) obj;
+    memset(obj, 0, size);
+  }
+  else if (sc && ((size_t)(pool->end - pool->next) >= size))
+  {
+    /* The region starts out filled with zeroes */
+    obj = pool->next;
+    pool->next += size;
+  }
+  if (obj)
+    pool->used++;
+  SLAB_UNLOCK();
+
+  if (!obj)
+    obj = mutt_mem_calloc(1, size);
+  return obj;
+}
+
+/**
+ * mutt_slab_free - Free an object
+ * @param ptr  Object to free (may be NULL)
+ * @param size Size of the object, as allocated
+ */
+void mutt_slab_free(void *ptr, size_t size)
+{
+  if (!ptr)
+    return;
+
+  size = (size + SLAB_ALIGN - 1) / SLAB_ALIGN * SLAB_ALIGN;
+
+  SLAB_LOCK();
+  struct SlabPool *pool = Pools;
+  while (pool && (((char *) ptr < pool->base) || ((char *) ptr >= pool->next)))
+    pool = pool->next_pool;
+
+  if (pool)
+  {
+    pool->used--;
+    if (pool->closed)
+    {
+      if (pool->used == 0)
+        release_pool(pool);
+    }
+    else
+    {
+      struct SlabClass *sc = find_class(pool, size);
+      *(void **) ptr = sc->spare;
+      sc->spare = ptr;
+    }
+  }
+  SLAB_UNLOCK();
+
+  if (!pool)
+    free(ptr);
+}
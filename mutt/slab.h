@@ -0,0 +1,60 @@
+/**
+ * @file
+ * Allocate the objects of a mailbox from one region
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MUTT_LIB_SLAB_H
+#define MUTT_LIB_SLAB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SLAB_MAX_CLASSES 8 /**< Most object sizes in a pool */
+
+/**
+ * struct SlabClass - Freed objects of one size
+ */
+struct SlabClass
+{
+  size_t size; /**< Size of the objects, rounded up */
+  void *spare; /**< Freed objects, linked through their first bytes */
+};
+
+/**
+ * struct SlabPool - A region of memory holding the objects of a mailbox
+ *
+ * The objects are carved out of the region in turn.  Freed objects are kept
+ * for reuse, and the whole region is released once the pool has been closed
+ * and all of its objects have been freed.
+ */
+struct SlabPool
+{
+  char *base;                                 /**< Start of the region */
+  char *next;                                 /**< First unused byte */
+  char *end;                                  /**< End of the region */
+  size_t used;                                /**< Number of objects in use */
+  bool closed;                                /**< The owner has gone */
+  struct SlabClass classes[SLAB_MAX_CLASSES]; /**< Freed objects, by size */
+  struct SlabPool *next_pool;                 /**< Next pool with objects in use */
+};
+
+struct SlabPool *mutt_slab_pool_new (void);
+void             mutt_slab_pool_free(struct SlabPool **pool);
+void *           mutt_slab_alloc    (struct SlabPool *pool, size_t size);
+void             mutt_slab_free     (void *ptr, size_t size);
+
+#endif /* MUTT_LIB_SLAB_H */
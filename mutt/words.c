@@ -0,0 +1,119 @@
+/**
+ * @file
+ * Split text into words
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page words Split text into words
+ *
+ * A word is a run of letters, digits or 8-bit characters.  Runs longer than
+ * #MUTT_WORD_MAX are passed on as pieces of that size, each overlapping the
+ * one before by half, so that any part of the run up to half that length is
+ * wholly inside one of the pieces.
+ *
+ * | Function          | Description
+ * | :---------------- | :-------------------------------
+ * | mutt_words_read() | Split the text of a file into words
+ */
+
+#include "config.h"
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "words.h"
+#include "memory.h"
+
+/* Overlap of the pieces of a long run */
+#define WORD_OVERLAP (MUTT_WORD_MAX / 2)
+
+/**
+ * end_word - Pass on the end of a run of characters
+ * @param word    Run, or the rest of a long one
+ * @param wlen    Length of the run
+ * @param split   Part of the run has already been passed on
+ * @param min     Shortest word to pass on
+ * @param handler Function to receive the word
+ * @param data    Private data for the handler
+ */
+static void end_word(char *word, size_t wlen, bool split, size_t min,
+                     word_handler_t handler, void *data)
+{
+  /* The tail of a long run is only new if it's longer than the overlap */
+  if ((wlen < min) || (split && (wlen <= WORD_OVERLAP)))
+    return;
+
+  word[wlen] = '\0';
+  handler(word, data);
+}
+
+/**
+ * mutt_words_read - Split the text of a file into words
+ * @param fp      File, read from the current position
+ * @param len     Maximum number of bytes to read
+ * @param min     Shortest word to pass on
+ * @param handler Function to receive each word
+ * @param data    Private data for the handler
+ *
+ * The words are passed on in lower case.  A word may be passed on more than
+ * once.
+ */
+void mutt_words_read(FILE *fp, LOFF_T len, size_t min, word_handler_t handler, void *data)
+{
+  char buf[4096];
+  char word[MUTT_WORD_MAX + 1];
+  size_t wlen = 0;
+  bool split = false; /* part of the current run has already been passed on */
+
+  while (len > 0)
+  {
+    const size_t n = fread(buf, 1, MIN((LOFF_T) sizeof(buf), len), fp);
+    if (n == 0)
+      break;
+    len -= n;
+
+    for (size_t i = 0; i <= n; i++)
+    {
+      const unsigned char c = (i < n) ? buf[i] : 0;
+      if ((i < n) && ((c >= 0x80) || isalnum(c)))
+      {
+        word[wlen++] = tolower(c);
+        if (wlen == MUTT_WORD_MAX)
+        {
+          /* Pass on the piece and keep its second half as the start of the next */
+          word[wlen] = '\0';
+          handler(word, data);
+          memmove(word, word + WORD_OVERLAP, MUTT_WORD_MAX - WORD_OVERLAP);
+          wlen = MUTT_WORD_MAX - WORD_OVERLAP;
+          split = true;
+        }
+        continue;
+      }
+
+      /* A run may continue into the next block */
+      if ((i == n) && (len > 0))
+        break;
+
+      end_word(word, wlen, split, min, handler, data);
+      wlen = 0;
+      split = false;
+    }
+  }
+
+  /* The file ended before len bytes, e.g. when len is unknown */
+  end_word(word, wlen, split, min, handler, data);
+}
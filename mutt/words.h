@@ -0,0 +1,38 @@
+/**
+ * @file
+ * Split text into words
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MUTT_LIB_WORDS_H
+#define MUTT_LIB_WORDS_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+/* Longest word, or piece of a word, passed to a word_handler_t */
+#define MUTT_WORD_MAX 64
+
+/**
+ * typedef word_handler_t - Receive a word from mutt_words_read()
+ * @param word Word, in lower case
+ * @param data Private data passed to mutt_words_read()
+ */
+typedef void (*word_handler_t)(const char *word, void *data);
+
+void mutt_words_read(FILE *fp, LOFF_T len, size_t min, word_handler_t handler, void *data);
+
+#endif /* MUTT_LIB_WORDS_H */
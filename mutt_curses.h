@@ -177,7 +177,7 @@ enum ColorId
  */
 struct ColorLine
 {
-  regex_t regex;
+  struct Regex *regex; /**< compiled regex (not used for index colours) */
   int match; /**< which substringmap 0 for old behaviour */
   char *pattern;
   struct Pattern *color_pattern; /**< compiled pattern to speed up index color
@@ -33,10 +33,15 @@
 #include "mutt_thread.h"
 #include "context.h"
 #include "curs_lib.h"
+#include "curs_main.h"
+#include "globals.h"
 #include "mailbox.h"
 #include "mx.h"
 #include "protos.h"
 #include "sort.h"
+#ifdef USE_HCACHE
+#include "hcache/hcache.h"
+#endif
 
 /* These Config Variables are only used in mutt_thread.c */
 bool DuplicateThreads; ///< Config: Highlight messages with duplicated message IDs
@@ -50,6 +55,8 @@ bool SortRe;     ///< Config: Sort method for the sidebar
 bool StrictThreads; ///< Config: Thread messages using 'In-Reply-To' and 'References' headers
 bool ThreadReceived; ///< Config: Sort threaded messages by their received date
 
+#define TREE_CACHE_SIZE 256 ///< Number of threads whose trees are kept, see mutt_draw_thread_tree()
+
 /**
  * is_visible - Is the message visible?
  * @param e Header of message
@@ -150,18 +157,19 @@ static void linearize_tree(struct Context *ctx)
 /**
  * calculate_visibility - Are tree nodes visible
  * @param ctx       Mailbox
+ * @param tree      First thread to check (it and its siblings are checked)
  * @param max_depth Maximum depth to check
  *
  * this calculates whether a node is the root of a subtree that has visible
  * nodes, whether a node itself is visible, whether, if invisible, it has
  * depth anyway, and whether any of its later siblings are roots of visible
  * subtrees.  while it's at it, it frees the old thread display, so we can
- * skip parts of the tree in mutt_draw_tree() if we've decided here that we
+ * skip parts of the tree in draw_tree() if we've decided here that we
  * don't care about them any more.
  */
-static void calculate_visibility(struct Context *ctx, int *max_depth)
+static void calculate_visibility(struct Context *ctx, struct MuttThread *tree, int *max_depth)
 {
-  struct MuttThread *tmp = NULL, *tree = ctx->tree;
+  struct MuttThread *tmp = NULL, *first = tree;
   int hide_top_missing = HideTopMissing && !HideMissing;
   int hide_top_limited = HideTopLimited && !HideLimited;
   int depth = 0;
@@ -236,7 +244,7 @@ static void calculate_visibility(struct Context *ctx, int *max_depth)
   /* now fix up for the OPTHIDETOP* options if necessary */
   if (hide_top_limited || hide_top_missing)
   {
-    tree = ctx->tree;
+    tree = first;
     while (true)
     {
       if (!tree->visible && tree->deep && tree->subtree_visible < 2 &&
@@ -262,8 +270,9 @@ static void calculate_visibility(struct Context *ctx, int *max_depth)
 }
 
 /**
- * mutt_draw_tree - Draw a tree of threaded emails
- * @param ctx Mailbox
+ * draw_tree - Draw the trees of some threads
+ * @param ctx  Mailbox
+ * @param tree First thread to draw (it and its siblings are drawn)
  *
  * Since the graphics characters have a value >255, I have to resort to using
  * escape sequences to pass the information to print_enriched_string().  These
@@ -273,18 +282,18 @@ static void calculate_visibility(struct Context *ctx, int *max_depth)
  * graphics chars on terminals which don't support them (see the man page for
  * curs_addch).
  */
-void mutt_draw_tree(struct Context *ctx)
+static void draw_tree(struct Context *ctx, struct MuttThread *tree)
 {
   char *pfx = NULL, *mypfx = NULL, *arrow = NULL, *myarrow = NULL, *new_tree = NULL;
   char corner = (Sort & SORT_REVERSE) ? MUTT_TREE_ULCORNER : MUTT_TREE_LLCORNER;
   char vtee = (Sort & SORT_REVERSE) ? MUTT_TREE_BTEE : MUTT_TREE_TTEE;
   int depth = 0, start_depth = 0, max_depth = 0, width = NarrowTree ? 1 : 2;
-  struct MuttThread *nextdisp = NULL, *pseudo = NULL, *parent = NULL, *tree = ctx->tree;
+  struct MuttThread *nextdisp = NULL, *pseudo = NULL, *parent = NULL;
 
   /* Do the visibility calculations and free the old thread chars.
    * From now on we can simply ignore invisible subtrees
    */
-  calculate_visibility(ctx, &max_depth);
+  calculate_visibility(ctx, tree, &max_depth);
   pfx = mutt_mem_malloc(width * max_depth + 2);
   arrow = mutt_mem_malloc(width * max_depth + 2);
   while (tree)
@@ -386,6 +395,118 @@ void mutt_draw_tree(struct Context *ctx)
   FREE(&arrow);
 }
 
+/**
+ * draw_thread - Draw the tree of a single thread
+ * @param ctx Mailbox
+ * @param top Top-level thread
+ */
+static void draw_thread(struct Context *ctx, struct MuttThread *top)
+{
+  struct MuttThread *prev = top->prev, *next = top->next;
+
+  top->prev = NULL;
+  top->next = NULL;
+  draw_tree(ctx, top);
+  top->prev = prev;
+  top->next = next;
+}
+
+/**
+ * free_thread_tree - Free the drawn tree of a thread
+ * @param top Thread
+ */
+static void free_thread_tree(struct MuttThread *top)
+{
+  struct MuttThread *tree = top;
+
+  while (true)
+  {
+    if (tree->message)
+      FREE(&tree->message->tree);
+
+    if (tree->child)
+      tree = tree->child;
+    else
+    {
+      while ((tree != top) && !tree->next)
+        tree = tree->parent;
+      if (tree == top)
+        break;
+      tree = tree->next;
+    }
+  }
+}
+
+/**
+ * forget_drawn_trees - Free the trees of all the threads that have been drawn
+ * @param ctx Mailbox
+ */
+static void forget_drawn_trees(struct Context *ctx)
+{
+  if (!ctx->tree_cache)
+    return;
+
+  for (int i = 0; i < TREE_CACHE_SIZE; i++)
+  {
+    if (ctx->tree_cache[i])
+      free_thread_tree(ctx->tree_cache[i]);
+    ctx->tree_cache[i] = NULL;
+  }
+  ctx->tree_cache_next = 0;
+}
+
+/**
+ * mutt_draw_tree - Get a tree of threaded emails ready to draw
+ * @param ctx Mailbox
+ *
+ * The visibility of every thread is calculated, but the trees themselves are
+ * only drawn when they're displayed, by mutt_draw_thread_tree().
+ */
+void mutt_draw_tree(struct Context *ctx)
+{
+  int max_depth = 0;
+
+  forget_drawn_trees(ctx);
+  calculate_visibility(ctx, ctx->tree, &max_depth);
+}
+
+/**
+ * mutt_draw_thread_tree - Draw the tree of an email's thread
+ * @param ctx Mailbox
+ * @param e   Email
+ *
+ * The last #TREE_CACHE_SIZE threads to be drawn keep their trees.  Drawing
+ * another thread frees the tree of the oldest one.
+ */
+void mutt_draw_thread_tree(struct Context *ctx, struct Email *e)
+{
+  struct MuttThread *top = e->thread;
+  if (!top)
+    return;
+
+  while (top->parent)
+    top = top->parent;
+
+  /* a thread of one email has no tree */
+  if (!top->child)
+    return;
+
+  if (!ctx->tree_cache)
+    ctx->tree_cache = mutt_mem_calloc(TREE_CACHE_SIZE, sizeof(struct MuttThread *));
+
+  for (int i = 0; i < TREE_CACHE_SIZE; i++)
+    if (ctx->tree_cache[i] == top)
+      return;
+
+  struct MuttThread **slot = &ctx->tree_cache[ctx->tree_cache_next];
+  if (*slot)
+    free_thread_tree(*slot);
+  *slot = top;
+  ctx->tree_cache_next = (ctx->tree_cache_next + 1) % TREE_CACHE_SIZE;
+
+  draw_thread(ctx, top);
+}
+
 /**
  * make_subject_list - Create a sorted list of all subjects in a thread
  * @param[out] subjects String List of subjects
@@ -441,6 +562,226 @@ static void make_subject_list(struct ListHead *subjects, struct MuttThread *cur,
   }
 }
 
+/**
+ * thread_date - Get the date of an email used for threading
+ * @param e Email
+ * @retval num Date the email was sent, or received
+ */
+static time_t thread_date(const struct Email *e)
+{
+  return ThreadReceived ? e->received : e->date_sent;
+}
+
+/**
+ * struct SubjectEmails - Emails with the same real subject
+ *
+ * The emails are sorted by their threading dates.  Emails with the same date
+ * are kept in the order they were added.
+ */
+struct SubjectEmails
+{
+  struct Email **emails; /**< Emails, earliest first */
+  size_t num;            /**< Number of emails */
+  size_t max;            /**< Size of the array */
+  struct Email *first;   /**< Storage for the first email, as most subjects have one */
+  char subject[];        /**< Real subject, the key in the subject index */
+};
+
+/**
+ * subject_emails_destructor - Free a SubjectEmails - Implements ::hash_destructor_t
+ */
+static void subject_emails_destructor(int type, void *obj, intptr_t data)
+{
+  struct SubjectEmails *se = obj;
+
+  if (se->emails != &se->first)
+    FREE(&se->emails);
+  FREE(&se);
+}
+
+/**
+ * subject_emails_append - Add an email to the end of a SubjectEmails
+ * @param se Emails with the same subject
+ * @param e  Email
+ */
+static void subject_emails_append(struct SubjectEmails *se, struct Email *e)
+{
+  if (se->num == se->max)
+  {
+    se->max *= 4;
+    if (se->emails == &se->first)
+    {
+      se->emails = mutt_mem_malloc(se->max * sizeof(struct Email *));
+      se->emails[0] = se->first;
+    }
+    else
+      mutt_mem_realloc(&se->emails, se->max * sizeof(struct Email *));
+  }
+  se->emails[se->num++] = e;
+}
+
+/**
+ * subject_index_find - Find the emails with a subject
+ * @param index Subject index
+ * @param e     Email whose subject to look for
+ * @retval ptr Emails with the same subject, created if necessary
+ */
+static struct SubjectEmails *subject_index_find(struct Hash *index, struct Email *e)
+{
+  struct SubjectEmails *se = mutt_hash_find(index, e->env->real_subj);
+  if (se)
+    return se;
+
+  const size_t len = strlen(e->env->real_subj) + 1;
+  se = mutt_mem_malloc(sizeof(struct SubjectEmails) + len);
+  se->emails = &se->first;
+  se->num = 0;
+  se->max = 1;
+  memcpy(se->subject, e->env->real_subj, len);
+  mutt_hash_insert(index, se->subject, se);
+  return se;
+}
+
+/**
+ * subject_index_add - Add an email to the subject index
+ * @param index Subject index
+ * @param e     Email
+ */
+static void subject_index_add(struct Hash *index, struct Email *e)
+{
+  if (!e->env->real_subj)
+    return;
+
+  struct SubjectEmails *se = subject_index_find(index, e);
+  subject_emails_append(se, e);
+
+  /* new emails are usually the latest, otherwise move it into place */
+  const time_t date = thread_date(e);
+  size_t pos = se->num - 1;
+  while ((pos > 0) && (thread_date(se->emails[pos - 1]) > date))
+  {
+    se->emails[pos] = se->emails[pos - 1];
+    pos--;
+  }
+  se->emails[pos] = e;
+}
+
+/**
+ * compare_thread_dates - Sorting function for emails by threading date
+ * @param a First email to compare
+ * @param b Second email to compare
+ * @retval -1 a precedes b
+ * @retval  0 a and b are identical
+ * @retval  1 b precedes a
+ *
+ * Emails with the same date keep their order in the mailbox.
+ */
+static int compare_thread_dates(const void *a, const void *b)
+{
+  const struct Email *ea = *(struct Email *const *) a;
+  const struct Email *eb = *(struct Email *const *) b;
+  const time_t da = thread_date(ea);
+  const time_t db = thread_date(eb);
+
+  if (da != db)
+    return (da > db) - (da < db);
+  return (ea->msgno > eb->msgno) - (ea->msgno < eb->msgno);
+}
+
+/**
+ * make_subject_index - Create an index of the emails by subject
+ * @param ctx Mailbox
+ * @retval ptr Newly allocated Hash Table of SubjectEmails
+ *
+ * The index lives as long as thread_hash.  Emails that arrive later are added
+ * to it by mutt_sort_threads().
+ */
+static struct Hash *make_subject_index(struct Context *ctx)
+{
+  struct Mailbox *m = ctx->mailbox;
+  /* subject_index_find() never adds a subject twice, so don't check */
+  struct Hash *index = mutt_hash_create(m->msg_count, MUTT_HASH_ALLOW_DUPS);
+  mutt_hash_set_destructor(index, subject_emails_destructor, 0);
+
+  /* the emails are usually in date order already.  if not, they're sorted
+   * once they've all been added. */
+  bool sorted = true;
+  for (int i = 0; i < m->msg_count; i++)
+  {
+    struct Email *e = m->hdrs[i];
+    if (!e->env->real_subj)
+      continue;
+
+    struct SubjectEmails *se = subject_index_find(index, e);
+    if ((se->num > 0) && (thread_date(se->emails[se->num - 1]) > thread_date(e)))
+      sorted = false;
+    subject_emails_append(se, e);
+  }
+
+  if (!sorted)
+  {
+    struct HashWalkState state = { 0 };
+    struct HashElem *elem = NULL;
+    while ((elem = mutt_hash_walk(index, &state)))
+    {
+      struct SubjectEmails *se = elem->data;
+      qsort(se->emails, se->num, sizeof(struct Email *), compare_thread_dates);
+    }
+  }
+
+  return index;
+}
+
+/**
+ * find_subject_match - Find the best parent with a given subject
+ * @param ctx     Mailbox
+ * @param cur     Thread to match
+ * @param subject Real subject to look for
+ * @param date    Earliest date in the thread
+ * @param last    Best match so far, may be NULL
+ * @retval ptr Best match
+ *
+ * The best parent is the latest interesting email sent before the thread.
+ */
+static struct MuttThread *find_subject_match(struct Context *ctx, struct MuttThread *cur,
+                                             const char *subject, time_t date,
+                                             struct MuttThread *last)
+{
+  struct SubjectEmails *se = mutt_hash_find(ctx->subj_index, subject);
+  if (!se || (thread_date(se->emails[0]) > date))
+    return last;
+
+  /* skip the emails sent after the thread */
+  size_t lo = 0, hi = se->num;
+  while (lo < hi)
+  {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (thread_date(se->emails[mid]) > date)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  while (lo > 0)
+  {
+    struct Email *e = se->emails[--lo];
+    struct MuttThread *tmp = e->thread;
+    if (last && (thread_date(e) <= thread_date(last->message)))
+      break;
+
+    if ((tmp != cur) &&                     /* don't match the same message */
+        !tmp->fake_thread &&                /* don't match pseudo threads */
+        e->subject_changed &&               /* only match interesting replies */
+        !is_descendant(tmp, cur) &&         /* don't match in the same thread */
+        (mutt_str_strcmp(subject, e->env->real_subj) == 0))
+    {
+      return tmp;
+    }
+  }
+
+  return last;
+}
+
 /**
  * find_subject - Find the best possible match for a parent based on subject
  * @param ctx Mailbox
@@ -452,32 +793,25 @@ static void make_subject_list(struct ListHead *subjects, struct MuttThread *cur,
  */
 static struct MuttThread *find_subject(struct Context *ctx, struct MuttThread *cur)
 {
-  struct HashElem *ptr = NULL;
-  struct MuttThread *tmp = NULL, *last = NULL;
   struct ListHead subjects = STAILQ_HEAD_INITIALIZER(subjects);
+  struct MuttThread *last = NULL;
   time_t date = 0;
 
+  if (cur->message)
+  {
+    /* the usual case: only the thread's own subject needs matching */
+    const struct Envelope *env = cur->message->env;
+    if (!env->real_subj || ((env->real_subj == env->subject) && SortRe))
+      return NULL;
+    return find_subject_match(ctx, cur, env->real_subj, thread_date(cur->message), NULL);
+  }
+
   make_subject_list(&subjects, cur, &date);
 
   struct ListNode *np = NULL;
   STAILQ_FOREACH(np, &subjects, entries)
   {
-    for (ptr = mutt_hash_find_bucket(ctx->mailbox->subj_hash, np->data); ptr; ptr = ptr->next)
-    {
-      tmp = ((struct Email *) ptr->data)->thread;
-      if (tmp != cur &&                    /* don't match the same message */
-          !tmp->fake_thread &&             /* don't match pseudo threads */
-          tmp->message->subject_changed && /* only match interesting replies */
-          !is_descendant(tmp, cur) &&      /* don't match in the same thread */
-          (date >= (ThreadReceived ? tmp->message->received : tmp->message->date_sent)) &&
-          (!last || (ThreadReceived ? (last->message->received < tmp->message->received) :
-                                      (last->message->date_sent < tmp->message->date_sent))) &&
-          tmp->message->env->real_subj &&
-          (mutt_str_strcmp(np->data, tmp->message->env->real_subj) == 0))
-      {
-        last = tmp; /* best match so far */
-      }
-    }
+    last = find_subject_match(ctx, cur, np->data, date, last);
   }
 
   mutt_list_clear(&subjects);
@@ -485,22 +819,59 @@ static struct MuttThread *find_subject(struct Context *ctx, struct MuttThread *c
 }
 
 /**
- * make_subj_hash - Create a Hash Table for the email subjects
+ * pseudo_thread - Thread a message by subject
  * @param ctx Mailbox
- * @retval ptr Newly allocated Hash Table
+ * @param top List of top-level threads
+ * @param cur Top-level thread to attach, if its subject matches another thread
  */
-static struct Hash *make_subj_hash(struct Context *ctx)
+static void pseudo_thread(struct Context *ctx, struct MuttThread **top, struct MuttThread *cur)
 {
-  struct Hash *hash = mutt_hash_create(ctx->mailbox->msg_count * 2, MUTT_HASH_ALLOW_DUPS);
+  struct MuttThread *tmp = NULL, *parent = NULL, *curchild = NULL, *nextchild = NULL;
 
-  for (int i = 0; i < ctx->mailbox->msg_count; i++)
+  parent = find_subject(ctx, cur);
+  if (!parent)
+    return;
+
+  cur->fake_thread = true;
+  unlink_message(top, cur);
+  insert_message(&parent->child, parent, cur);
+  parent->sort_children = true;
+  tmp = cur;
+  while (true)
   {
-    struct Email *e = ctx->mailbox->hdrs[i];
-    if (e->env->real_subj)
-      mutt_hash_insert(hash, e->env->real_subj, e);
-  }
+    while (!tmp->message)
+      tmp = tmp->child;
+
+    /* if the message we're attaching has pseudo-children, they
+     * need to be attached to its parent, so move them up a level.
+     * but only do this if they have the same real subject as the
+     * parent, since otherwise they rightly belong to the message
+     * we're attaching. */
+    if (tmp == cur || (mutt_str_strcmp(tmp->message->env->real_subj,
+                                       parent->message->env->real_subj) == 0))
+    {
+      tmp->message->subject_changed = false;
 
-  return hash;
+      for (curchild = tmp->child; curchild;)
+      {
+        nextchild = curchild->next;
+        if (curchild->fake_thread)
+        {
+          unlink_message(&tmp->child, curchild);
+          insert_message(&parent->child, parent, curchild);
+        }
+        curchild = nextchild;
+      }
+    }
+
+    while (!tmp->next && tmp != cur)
+    {
+      tmp = tmp->parent;
+    }
+    if (tmp == cur)
+      break;
+    tmp = tmp->next;
+  }
 }
 
 /**
@@ -512,60 +883,16 @@ static struct Hash *make_subj_hash(struct Context *ctx)
 static void pseudo_threads(struct Context *ctx)
 {
   struct MuttThread *tree = ctx->tree, *top = tree;
-  struct MuttThread *tmp = NULL, *cur = NULL, *parent = NULL, *curchild = NULL,
-                    *nextchild = NULL;
+  struct MuttThread *cur = NULL;
 
-  if (!ctx->mailbox->subj_hash)
-    ctx->mailbox->subj_hash = make_subj_hash(ctx);
+  if (!ctx->subj_index)
+    ctx->subj_index = make_subject_index(ctx);
 
   while (tree)
   {
     cur = tree;
     tree = tree->next;
-    parent = find_subject(ctx, cur);
-    if (parent)
-    {
-      cur->fake_thread = true;
-      unlink_message(&top, cur);
-      insert_message(&parent->child, parent, cur);
-      parent->sort_children = true;
-      tmp = cur;
-      while (true)
-      {
-        while (!tmp->message)
-          tmp = tmp->child;
-
-        /* if the message we're attaching has pseudo-children, they
-         * need to be attached to its parent, so move them up a level.
-         * but only do this if they have the same real subject as the
-         * parent, since otherwise they rightly belong to the message
-         * we're attaching. */
-        if (tmp == cur || (mutt_str_strcmp(tmp->message->env->real_subj,
-                                           parent->message->env->real_subj) == 0))
-        {
-          tmp->message->subject_changed = false;
-
-          for (curchild = tmp->child; curchild;)
-          {
-            nextchild = curchild->next;
-            if (curchild->fake_thread)
-            {
-              unlink_message(&tmp->child, curchild);
-              insert_message(&parent->child, parent, curchild);
-            }
-            curchild = nextchild;
-          }
-        }
-
-        while (!tmp->next && tmp != cur)
-        {
-          tmp = tmp->parent;
-        }
-        if (tmp == cur)
-          break;
-        tmp = tmp->next;
-      }
-    }
+    pseudo_thread(ctx, &top, cur);
   }
   ctx->tree = top;
 }
@@ -586,9 +913,12 @@ void mutt_clear_threads(struct Context *ctx)
     }
   }
   ctx->tree = NULL;
+  FREE(&ctx->tree_cache);
+  ctx->tree_cache_next = 0;
 
   if (ctx->thread_hash)
     mutt_hash_destroy(&ctx->thread_hash);
+  mutt_hash_destroy(&ctx->subj_index);
 }
 
 /**
@@ -794,10 +1124,600 @@ static void check_subjects(struct Context *ctx, bool init)
   }
 }
 
+/**
+ * compare_thread_addr - Sorting function for pointers to threads
+ * @param a First thread to compare
+ * @param b Second thread to compare
+ * @retval -1 a precedes b
+ * @retval  0 a and b are identical
+ * @retval  1 b precedes a
+ */
+static int compare_thread_addr(const void *a, const void *b)
+{
+  const struct MuttThread *ta = *(struct MuttThread *const *) a;
+  const struct MuttThread *tb = *(struct MuttThread *const *) b;
+
+  return (ta > tb) - (ta < tb);
+}
+
+/**
+ * find_thread_tops - Find the top-level threads containing some threads
+ * @param threads Threads, replaced by their top-level threads
+ * @param num     Number of threads
+ * @retval num Number of distinct top-level threads, at the start of the array
+ */
+static size_t find_thread_tops(struct MuttThread **threads, size_t num)
+{
+  size_t unique = 0;
+
+  for (size_t i = 0; i < num; i++)
+    while (threads[i]->parent)
+      threads[i] = threads[i]->parent;
+
+  qsort(threads, num, sizeof(struct MuttThread *), compare_thread_addr);
+
+  for (size_t i = 0; i < num; i++)
+    if ((unique == 0) || (threads[unique - 1] != threads[i]))
+      threads[unique++] = threads[i];
+
+  return unique;
+}
+
+/**
+ * resort_threads - Sort some top-level threads back into place
+ * @param ctx  Mailbox
+ * @param tops Top-level threads that have changed
+ * @param num  Number of threads
+ *
+ * The threads are taken out of the list of threads and their subthreads are
+ * sorted.  Then they're merged back into the list, which is still sorted.
+ */
+static void resort_threads(struct Context *ctx, struct MuttThread **tops, size_t num)
+{
+  struct MuttThread *pos = NULL, *prev = NULL;
+
+  for (size_t i = 0; i < num; i++)
+  {
+    unlink_message(&ctx->tree, tops[i]);
+    tops[i]->prev = NULL;
+    tops[i]->next = NULL;
+    tops[i] = mutt_sort_subthreads(tops[i], false);
+  }
+
+  /* mutt_sort_subthreads() sorts backwards, the list of threads is forwards */
+  const bool sorted = (compare_threads(NULL, NULL) != 0);
+  if (sorted)
+    qsort(tops, num, sizeof(struct MuttThread *), compare_threads);
+
+  pos = ctx->tree;
+  for (size_t i = 0; i < num; i++)
+  {
+    while (sorted && pos && (compare_threads(&pos, &tops[i]) <= 0))
+    {
+      prev = pos;
+      pos = pos->next;
+    }
+
+    tops[i]->prev = prev;
+    tops[i]->next = pos;
+    if (prev)
+      prev->next = tops[i];
+    else
+      ctx->tree = tops[i];
+    if (pos)
+      pos->prev = tops[i];
+    prev = tops[i];
+  }
+}
+
+/**
+ * undraw_thread - Forget the tree of a thread that has changed
+ * @param ctx Mailbox
+ * @param top Top-level thread
+ *
+ * The thread's visibility is calculated again and its tree is freed, ready for
+ * mutt_draw_thread_tree().
+ */
+static void undraw_thread(struct Context *ctx, struct MuttThread *top)
+{
+  struct MuttThread *prev = top->prev, *next = top->next;
+  int max_depth = 0;
+
+  top->prev = NULL;
+  top->next = NULL;
+  calculate_visibility(ctx, top, &max_depth);
+  top->prev = prev;
+  top->next = next;
+}
+
+#ifdef USE_HCACHE
+/**
+ * struct ThreadIndex - Threads of a mailbox stored in the header cache
+ *
+ * This record, stored under "/threads", is followed by a ThreadIndexNode for
+ * each MuttThread, in pre-order.  Then come the Message-IDs of the threads
+ * whose emails are missing, each ending with a NUL.
+ */
+struct ThreadIndex
+{
+  size_t len;               /**< Size of the whole record */
+  unsigned int settings;    /**< Config that affects threading */
+  int msg_count;            /**< Number of emails threaded */
+  int num_threads;          /**< Number of MuttThreads stored */
+  size_t ids_len;           /**< Size of the Message-IDs of missing emails */
+  unsigned char digest[16]; /**< MD5 of the headers used for threading */
+};
+
+/**
+ * struct ThreadKey - The key of a MuttThread in thread_hash
+ */
+struct ThreadKey
+{
+  struct MuttThread *thread; /**< Thread, first so that compare_thread_addr() works */
+  const char *id;            /**< Message-ID of its email */
+};
+
+/**
+ * struct ThreadIndexNode - A MuttThread stored in the header cache
+ */
+struct ThreadIndexNode
+{
+  int parent;          /**< Position of the parent, or -1 for a top-level thread */
+  int msgno;           /**< Email::index of the email, or -1 if it's missing */
+  unsigned char flags; /**< Flags, e.g. #THREAD_INDEX_FAKE */
+};
+
+#define THREAD_INDEX_FAKE      (1 << 0) /**< MuttThread::fake_thread */
+#define THREAD_INDEX_DUPLICATE (1 << 1) /**< MuttThread::duplicate_thread */
+#define THREAD_INDEX_CHANGED   (1 << 2) /**< Email::subject_changed */
+
+/**
+ * thread_index_settings - Get the config that affects threading
+ * @retval num Bit field of config variables
+ */
+static unsigned int thread_index_settings(void)
+{
+  return (StrictThreads << 0) | (DuplicateThreads << 1) | (SortRe << 2) |
+         (ThreadReceived << 3);
+}
+
+/**
+ * thread_index_usable - Can the threads of a mailbox be saved?
+ * @param m Mailbox
+ * @retval true The threads can be saved in the mailbox's header cache
+ *
+ * Only local mailboxes are saved.  The others keep their header caches under
+ * names of their own.  A compressed folder is read from a new temporary file
+ * each time, so its threads would never be found again.
+ */
+static bool thread_index_usable(const struct Mailbox *m)
+{
+  if (!HeaderCache)
+    return false;
+
+  if ((m->magic != MUTT_MBOX) && (m->magic != MUTT_MMDF) &&
+      (m->magic != MUTT_MAILDIR) && (m->magic != MUTT_MH))
+  {
+    return false;
+  }
+
+#ifdef USE_COMPRESSED
+  if (m->compress_info)
+    return false;
+#endif
+
+  return true;
+}
+
+/**
+ * emails_by_index - List a mailbox's emails in the order they were read
+ * @param m Mailbox
+ * @retval ptr  Array of Emails, indexed by Email::index
+ * @retval NULL The indexes aren't 0 to msg_count-1
+ */
+static struct Email **emails_by_index(struct Mailbox *m)
+{
+  struct Email **emails = mutt_mem_calloc(m->msg_count, sizeof(struct Email *));
+
+  for (int i = 0; i < m->msg_count; i++)
+  {
+    struct Email *e = m->hdrs[i];
+    if ((e->index < 0) || (e->index >= m->msg_count) || emails[e->index])
+    {
+      FREE(&emails);
+      return NULL;
+    }
+    emails[e->index] = e;
+  }
+
+  return emails;
+}
+
+/**
+ * digest_string - Add a string, which may be NULL, to a digest
+ * @param s      String
+ * @param md5ctx Digest
+ */
+static void digest_string(const char *s, struct Md5Ctx *md5ctx)
+{
+  if (s)
+    mutt_md5_process_bytes(s, strlen(s) + 1, md5ctx);
+  else
+    mutt_md5_process_bytes("\001", 1, md5ctx);
+}
+
+/**
+ * digest_list - Add a list of strings to a digest
+ * @param head   List of strings
+ * @param md5ctx Digest
+ */
+static void digest_list(struct ListHead *head, struct Md5Ctx *md5ctx)
+{
+  struct ListNode *np = NULL;
+  int count = 0;
+
+  STAILQ_FOREACH(np, head, entries)
+  {
+    digest_string(np->data, md5ctx);
+    count++;
+  }
+  mutt_md5_process_bytes(&count, sizeof(count), md5ctx);
+}
+
+/**
+ * thread_index_digest - Fingerprint the headers used for threading
+ * @param[in]  emails Emails, in the order they were read
+ * @param[in]  num    Number of Emails
+ * @param[out] digest MD5 digest, 16 bytes
+ */
+static void thread_index_digest(struct Email **emails, int num, unsigned char *digest)
+{
+  struct Md5Ctx md5ctx;
+
+  mutt_md5_init_ctx(&md5ctx);
+  for (int i = 0; i < num; i++)
+  {
+    struct Email *e = emails[i];
+    struct Envelope *env = e->env;
+    const bool reply = (env->real_subj != env->subject);
+
+    digest_string(env->message_id, &md5ctx);
+    digest_list(&env->in_reply_to, &md5ctx);
+    digest_list(&env->references, &md5ctx);
+    digest_string(env->real_subj, &md5ctx);
+    mutt_md5_process_bytes(&reply, sizeof(reply), &md5ctx);
+    mutt_md5_process_bytes(&e->date_sent, sizeof(e->date_sent), &md5ctx);
+    mutt_md5_process_bytes(&e->received, sizeof(e->received), &md5ctx);
+  }
+  mutt_md5_finish_ctx(&md5ctx, digest);
+}
+
+/**
+ * next_thread - Find the next thread in pre-order
+ * @param thread Current thread
+ * @param depth  Depth of the current thread, updated
+ * @retval ptr  Next thread
+ * @retval NULL No more threads
+ */
+static struct MuttThread *next_thread(struct MuttThread *thread, int *depth)
+{
+  if (thread->child)
+  {
+    (*depth)++;
+    return thread->child;
+  }
+
+  while (!thread->next && thread->parent)
+  {
+    thread = thread->parent;
+    (*depth)--;
+  }
+  return thread->next;
+}
+
+/**
+ * find_reference - Find the key for a thread whose email is missing
+ * @param thread Thread without an email
+ * @param id     Message-ID of the missing email
+ * @retval ptr  String equal to @a id
+ * @retval NULL The thread's descendants don't refer to @a id
+ *
+ * The thread was created for a reference in the headers of one of its
+ * descendants.  The keys of thread_hash belong to the Envelopes, so that
+ * reference is used as the key.
+ */
+static const char *find_reference(struct MuttThread *thread, const char *id)
+{
+  struct ListNode *np = NULL;
+  int depth = 1;
+
+  for (struct MuttThread *cur = thread->child; cur && (depth > 0);
+       cur = next_thread(cur, &depth))
+  {
+    if (!cur->message)
+      continue;
+
+    STAILQ_FOREACH(np, &cur->message->env->in_reply_to, entries)
+    {
+      if (mutt_str_strcmp(np->data, id) == 0)
+        return np->data;
+    }
+    STAILQ_FOREACH(np, &cur->message->env->references, entries)
+    {
+      if (mutt_str_strcmp(np->data, id) == 0)
+        return np->data;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * mutt_save_threads - Save the threads of a mailbox in the header cache
+ * @param ctx Mailbox
+ *
+ * When the mailbox is next opened, mutt_sort_threads() can restore them,
+ * rather than threading all the emails again.
+ */
+void mutt_save_threads(struct Context *ctx)
+{
+  struct Mailbox *m = ctx->mailbox;
+  struct ThreadIndex idx = { 0 };
+  struct ThreadIndexNode node = { 0 };
+  struct HashWalkState state = { 0 };
+  struct HashElem *elem = NULL;
+  struct MuttThread *thread = NULL;
+  struct ThreadKey *keys = NULL, *key = NULL;
+  unsigned char *data = NULL;
+  int *parents = NULL;
+  size_t num_keys = 0;
+  int depth = 0, max_depth = 0, pos = 0;
+
+  if (!ctx->tree || !ctx->thread_hash || (m->msg_count == 0) || !thread_index_usable(m))
+    return;
+
+  /* the threads are out of date if sorting by threads has been turned off */
+  for (int i = 0; i < m->msg_count; i++)
+    if (!m->hdrs[i]->thread)
+      return;
+
+  struct Email **emails = emails_by_index(m);
+  if (!emails)
+    return;
+
+  /* threads without emails only know their Message-IDs through thread_hash */
+  keys = mutt_mem_malloc((ctx->thread_hash->count + 1) * sizeof(struct ThreadKey));
+  while ((elem = mutt_hash_walk(ctx->thread_hash, &state)))
+  {
+    thread = elem->data;
+    if (thread->message)
+      continue;
+    keys[num_keys].thread = thread;
+    keys[num_keys].id = elem->key.strkey;
+    num_keys++;
+  }
+  qsort(keys, num_keys, sizeof(struct ThreadKey), compare_thread_addr);
+
+  for (thread = ctx->tree; thread; thread = next_thread(thread, &depth))
+  {
+    idx.num_threads++;
+    if (depth > max_depth)
+      max_depth = depth;
+    if (thread->message)
+      continue;
+    key = bsearch(&thread, keys, num_keys, sizeof(struct ThreadKey), compare_thread_addr);
+    if (!key)
+      goto done;
+    idx.ids_len += strlen(key->id) + 1;
+  }
+
+  idx.settings = thread_index_settings();
+  idx.msg_count = m->msg_count;
+  thread_index_digest(emails, m->msg_count, idx.digest);
+
+  idx.len = sizeof(idx) + (idx.num_threads * sizeof(node)) + idx.ids_len;
+  data = mutt_mem_malloc(idx.len);
+  memcpy(data, &idx, sizeof(idx));
+  unsigned char *nodes = data + sizeof(idx);
+  char *id = (char *) (nodes + (idx.num_threads * sizeof(node)));
+
+  /* the parent of a thread is the last one seen at the depth above it */
+  parents = mutt_mem_calloc(max_depth + 1, sizeof(int));
+  depth = 0;
+  for (thread = ctx->tree; thread; thread = next_thread(thread, &depth), pos++)
+  {
+    node.parent = (depth > 0) ? parents[depth - 1] : -1;
+    node.msgno = -1;
+    node.flags = 0;
+    if (thread->fake_thread)
+      node.flags |= THREAD_INDEX_FAKE;
+    if (thread->duplicate_thread)
+      node.flags |= THREAD_INDEX_DUPLICATE;
+
+    if (thread->message)
+    {
+      node.msgno = thread->message->index;
+      if (thread->message->subject_changed)
+        node.flags |= THREAD_INDEX_CHANGED;
+    }
+    else
+    {
+      key = bsearch(&thread, keys, num_keys, sizeof(struct ThreadKey), compare_thread_addr);
+      const size_t id_len = strlen(key->id) + 1;
+      memcpy(id, key->id, id_len);
+      id += id_len;
+    }
+
+    parents[depth] = pos;
+    memcpy(nodes, &node, sizeof(node));
+    nodes += sizeof(node);
+  }
+
+  header_cache_t *hc = mutt_hcache_open(HeaderCache, m->path, NULL);
+  if (hc)
+  {
+    mutt_hcache_store_raw(hc, "/threads", 8, data, idx.len);
+    mutt_hcache_close(hc);
+    mutt_debug(2, "saved %d threads of %d messages\n", idx.num_threads, idx.msg_count);
+  }
+
+done:
+  FREE(&parents);
+  FREE(&data);
+  FREE(&keys);
+  FREE(&emails);
+}
+
+/**
+ * restore_threads - Restore the threads of a mailbox from the header cache
+ * @param ctx Mailbox
+ * @retval num Number of emails threaded
+ *
+ * The threads are used if the headers of the emails they were saved with
+ * haven't changed.  Any emails that have been added since then are left for
+ * mutt_sort_threads() to thread.  The threads still need sorting.
+ */
+static int restore_threads(struct Context *ctx)
+{
+  struct Mailbox *m = ctx->mailbox;
+  struct ThreadIndex idx;
+  struct ThreadIndexNode node;
+  struct MuttThread **threads = NULL, *thread = NULL;
+  const char **keys = NULL;
+  struct Email **emails = NULL;
+  unsigned char digest[16];
+  size_t len = 0;
+  int restored = 0, num_keys = 0, i;
+
+  if (!thread_index_usable(m))
+    return 0;
+
+  header_cache_t *hc = mutt_hcache_open(HeaderCache, m->path, NULL);
+  if (!hc)
+    return 0;
+
+  unsigned char *data = mutt_hcache_fetch_raw(hc, "/threads", 8, &len);
+  if (!data || (len < sizeof(idx)))
+    goto done;
+
+  memcpy(&idx, data, sizeof(idx));
+  if ((idx.len != len) || (idx.settings != thread_index_settings()) ||
+      (idx.msg_count <= 0) || (idx.msg_count > m->msg_count) ||
+      (idx.num_threads < idx.msg_count) ||
+      ((size_t) idx.num_threads > ((len - sizeof(idx)) / sizeof(node))) ||
+      (idx.ids_len != (len - sizeof(idx) - (idx.num_threads * sizeof(node)))))
+  {
+    goto done;
+  }
+
+  emails = emails_by_index(m);
+  if (!emails)
+    goto done;
+
+  thread_index_digest(emails, idx.msg_count, digest);
+  if (memcmp(digest, idx.digest, sizeof(digest)) != 0)
+  {
+    mutt_debug(1, "emails in %s have changed, ignoring the saved threads\n", m->path);
+    goto done;
+  }
+
+  const unsigned char *nodes = data + sizeof(idx);
+  const char *id = (const char *) (nodes + (idx.num_threads * sizeof(node)));
+  const char *end = id + idx.ids_len;
+  if ((idx.ids_len > 0) && (end[-1] != '\0'))
+    goto done;
+
+  threads = mutt_mem_calloc(idx.num_threads, sizeof(struct MuttThread *));
+  keys = mutt_mem_calloc(idx.num_threads, sizeof(char *));
+  for (i = 0; i < idx.num_threads; i++)
+  {
+    memcpy(&node, nodes + (i * sizeof(node)), sizeof(node));
+    if ((node.parent < -1) || (node.parent >= i) || (node.msgno < -1) ||
+        (node.msgno >= idx.msg_count) || ((node.msgno >= 0) && emails[node.msgno]->thread))
+    {
+      goto fail;
+    }
+
+    thread = mutt_mem_calloc(1, sizeof(struct MuttThread));
+    threads[i] = thread;
+    thread->fake_thread = (node.flags & THREAD_INDEX_FAKE);
+    thread->duplicate_thread = (node.flags & THREAD_INDEX_DUPLICATE);
+
+    if (node.msgno >= 0)
+    {
+      struct Email *e = emails[node.msgno];
+      thread->message = e;
+      e->thread = thread;
+      e->threaded = true;
+      e->subject_changed = (node.flags & THREAD_INDEX_CHANGED);
+      restored++;
+    }
+  }
+  if (restored != idx.msg_count)
+    goto fail;
+
+  /* link the threads backwards, so that siblings keep their order */
+  for (i = idx.num_threads - 1; i >= 0; i--)
+  {
+    memcpy(&node, nodes + (i * sizeof(node)), sizeof(node));
+    if (node.parent >= 0)
+      insert_message(&threads[node.parent]->child, threads[node.parent], threads[i]);
+    else
+      insert_message(&ctx->tree, NULL, threads[i]);
+  }
+
+  for (i = 0; i < idx.num_threads; i++)
+  {
+    if (threads[i]->message)
+      continue;
+    if ((id >= end) || !(keys[num_keys++] = find_reference(threads[i], id)))
+      goto fail;
+    id += strlen(id) + 1;
+  }
+
+  ctx->thread_hash = mutt_hash_create(m->msg_count * 2, MUTT_HASH_ALLOW_DUPS);
+  mutt_hash_set_destructor(ctx->thread_hash, thread_hash_destructor, 0);
+  for (i = 0; i < idx.msg_count; i++)
+  {
+    mutt_hash_insert(ctx->thread_hash, NONULL(emails[i]->env->message_id),
+                     emails[i]->thread);
+  }
+  for (i = 0, num_keys = 0; i < idx.num_threads; i++)
+    if (!threads[i]->message)
+      mutt_hash_insert(ctx->thread_hash, keys[num_keys++], threads[i]);
+
+  mutt_debug(2, "restored the threads of %d messages\n", restored);
+  goto done;
+
+fail:
+  mutt_debug(1, "saved threads of %s are corrupt\n", m->path);
+  for (i = 0; i < idx.num_threads; i++)
+    FREE(&threads[i]);
+  for (i = 0; i < m->msg_count; i++)
+  {
+    m->hdrs[i]->thread = NULL;
+    m->hdrs[i]->threaded = false;
+  }
+  ctx->tree = NULL;
+  restored = 0;
+
+done:
+  FREE(&keys);
+  FREE(&threads);
+  FREE(&emails);
+  mutt_hcache_free(hc, (void **) &data);
+  mutt_hcache_close(hc);
+  return restored;
+}
+#endif
+
 /**
  * mutt_sort_threads - Sort email threads
  * @param ctx  Mailbox
  * @param init If true, rebuild the thread
+ *
+ * If new emails have arrived, only they are threaded.  The threads they join
+ * are sorted back into place, but the rest are left alone.
  */
 void mutt_sort_threads(struct Context *ctx, bool init)
 {
@@ -806,6 +1726,8 @@ void mutt_sort_threads(struct Context *ctx, bool init)
   struct MuttThread *thread = NULL, *new = NULL, *tmp = NULL, top;
   memset(&top, 0, sizeof(top));
   struct ListNode *ref = NULL;
+  struct MuttThread **changed = NULL;
+  size_t num_changed = 0;
 
   /* set Sort to the secondary method to support the set sort_aux=reverse-*
    * settings.  The sorting functions just look at the value of
@@ -815,13 +1737,42 @@ void mutt_sort_threads(struct Context *ctx, bool init)
   Sort = SortAux;
 
   if (!ctx->thread_hash)
+  {
     init = true;
+#ifdef USE_HCACHE
+    /* the threads may have been saved when the mailbox was last closed */
+    const int restored = restore_threads(ctx);
+    if (restored > 0)
+    {
+      init = false;
+      ctx->tree = mutt_sort_subthreads(ctx->tree, true);
+      if (restored == ctx->mailbox->msg_count)
+      {
+        Sort = oldsort;
+        linearize_tree(ctx);
+        mutt_draw_tree(ctx);
+        return;
+      }
+    }
+#endif
+  }
 
   if (init)
   {
+    mutt_hash_destroy(&ctx->subj_index);
     ctx->thread_hash = mutt_hash_create(ctx->mailbox->msg_count * 2, MUTT_HASH_ALLOW_DUPS);
     mutt_hash_set_destructor(ctx->thread_hash, thread_hash_destructor, 0);
   }
+  else if (ctx->tree)
+  {
+    /* each new email changes its own thread and maybe the one it leaves */
+    for (i = 0; i < ctx->mailbox->msg_count; i++)
+      if (!ctx->mailbox->hdrs[i]->thread)
+        num_changed += 2;
+    if (num_changed)
+      changed = mutt_mem_malloc(num_changed * sizeof(struct MuttThread *));
+    num_changed = 0;
+  }
 
   /* we want a quick way to see if things are actually attached to the top of the
    * thread tree or if they're just dangling, so we attach everything to a top
@@ -844,6 +1795,9 @@ void mutt_sort_threads(struct Context *ctx, bool init)
 
     if (!cur->thread)
     {
+      if (ctx->subj_index)
+        subject_index_add(ctx->subj_index, cur);
+
       if ((!init || DuplicateThreads) && cur->env->message_id)
         thread = mutt_hash_find(ctx->thread_hash, cur->env->message_id);
       else
@@ -884,6 +1838,9 @@ void mutt_sort_threads(struct Context *ctx, bool init)
             thread->fake_thread = false;
             thread = tmp;
           } while (thread != &top && !thread->child && !thread->message);
+
+          if (changed && (thread != &top))
+            changed[num_changed++] = thread;
         }
       }
       else
@@ -909,8 +1866,11 @@ void mutt_sort_threads(struct Context *ctx, bool init)
           thread->message->threaded = true;
         }
       }
+
+      if (changed)
+        changed[num_changed++] = cur->thread;
     }
-    else
+    else if (!changed)
     {
       /* unlink pseudo-threads because they might be children of newly
        * arrived messages */
@@ -1015,6 +1975,31 @@ void mutt_sort_threads(struct Context *ctx, bool init)
 
   check_subjects(ctx, init);
 
+  if (changed)
+  {
+    /* only the new emails' threads need threading by subject, sorting and
+     * drawing.  the other threads keep their places in the list. */
+    num_changed = find_thread_tops(changed, num_changed);
+    if (!StrictThreads)
+    {
+      if (!ctx->subj_index)
+        ctx->subj_index = make_subject_index(ctx);
+      for (size_t j = 0; j < num_changed; j++)
+        pseudo_thread(ctx, &ctx->tree, changed[j]);
+      num_changed = find_thread_tops(changed, num_changed);
+    }
+
+    resort_threads(ctx, changed, num_changed);
+    Sort = oldsort;
+    linearize_tree(ctx);
+    forget_drawn_trees(ctx);
+    for (size_t j = 0; j < num_changed; j++)
+      undraw_thread(ctx, changed[j]);
+
+    FREE(&changed);
+    return;
+  }
+
   if (!StrictThreads)
     pseudo_threads(ctx);
 
@@ -1153,6 +2138,8 @@ int mutt_parent_message(struct Context *ctx, struct Email *e, bool find_root)
 void mutt_set_virtual(struct Context *ctx)
 {
   struct Email *cur = NULL;
+  struct MuttThread *top = NULL, *last_top = NULL;
+  int num_hidden = 0;
 
   ctx->mailbox->vcount = 0;
   ctx->vsize = 0;
@@ -1168,7 +2155,17 @@ void mutt_set_virtual(struct Context *ctx)
       ctx->mailbox->vcount++;
       ctx->vsize += cur->content->length + cur->content->offset -
                     cur->content->hdr_offset + padding;
-      cur->num_hidden = mutt_get_hidden(ctx, cur);
+
+      /* the whole thread has the same number of hidden messages, and the
+       * messages of a thread are next to each other, so count them once */
+      for (top = cur->thread; top && top->parent; top = top->parent)
+        ;
+      if (!top || (top != last_top))
+      {
+        num_hidden = mutt_get_hidden(ctx, cur);
+        last_top = top;
+      }
+      cur->num_hidden = num_hidden;
     }
   }
 }
@@ -1227,7 +2224,7 @@ int mutt_traverse_thread(struct Context *ctx, struct Email *cur, int flag)
 
   if (flag & (MUTT_THREAD_COLLAPSE | MUTT_THREAD_UNCOLLAPSE))
   {
-    cur->pair = 0; /* force index entry's color to be re-evaluated */
+    mutt_reset_header_color(cur);
     cur->collapsed = flag & MUTT_THREAD_COLLAPSE;
     if (cur->virtual != -1)
     {
@@ -1260,7 +2257,7 @@ int mutt_traverse_thread(struct Context *ctx, struct Email *cur, int flag)
     {
       if (flag & (MUTT_THREAD_COLLAPSE | MUTT_THREAD_UNCOLLAPSE))
       {
-        cur->pair = 0; /* force index entry's color to be re-evaluated */
+        mutt_reset_header_color(cur);
         cur->collapsed = flag & MUTT_THREAD_COLLAPSE;
         if (!roothdr && CHECK_LIMIT)
         {
@@ -66,6 +66,7 @@ int mutt_traverse_thread(struct Context *ctx, struct Email *cur, int flag);
 int mutt_link_threads(struct Email *cur, struct Email *last, struct Context *ctx);
 int mutt_messages_in_thread(struct Context *ctx, struct Email *e, int flag);
 void mutt_draw_tree(struct Context *ctx);
+void mutt_draw_thread_tree(struct Context *ctx, struct Email *e);
 
 void mutt_clear_threads(struct Context *ctx);
 struct MuttThread *mutt_sort_subthreads(struct MuttThread *thread, bool init);
@@ -73,5 +74,8 @@ void mutt_sort_threads(struct Context *ctx, bool init);
 int mutt_parent_message(struct Context *ctx, struct Email *e, bool find_root);
 void mutt_set_virtual(struct Context *ctx);
 struct Hash *mutt_make_id_hash(struct Mailbox *mailbox);
+#ifdef USE_HCACHE
+void mutt_save_threads(struct Context *ctx);
+#endif
 
 #endif /* MUTT_MUTT_THREAD_H */
@@ -32,6 +32,7 @@
 #include <limits.h>
 #include <pwd.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -310,7 +311,13 @@ struct Context *mx_mbox_open(const char *path, int flags)
   if (!ctx->mailbox->quiet)
     mutt_message(_("Reading %s..."), ctx->mailbox->path);
 
+  /* The emails are allocated together, and released with the mailbox */
+  if (!ctx->mailbox->slabs)
+    ctx->mailbox->slabs = mutt_slab_pool_new();
+  struct SlabPool *old_pool = EmailSlabPool;
+  EmailSlabPool = ctx->mailbox->slabs;
   int rc = ctx->mailbox->mx_ops->mbox_open(ctx);
+  EmailSlabPool = old_pool;
 
   if ((rc == 0) || (rc == -2))
   {
@@ -351,13 +358,18 @@ void mx_fastclose_mailbox(struct Context *ctx)
   if (!ctx->peekonly)
     mutt_mailbox_setnotified(ctx->mailbox->path);
 
+#ifdef USE_HCACHE
+  mutt_save_threads(ctx);
+#endif
+
   if (ctx->mailbox->mx_ops)
     ctx->mailbox->mx_ops->mbox_close(ctx);
 
-  mutt_hash_destroy(&ctx->mailbox->subj_hash);
   mutt_hash_destroy(&ctx->mailbox->id_hash);
   mutt_hash_destroy(&ctx->mailbox->label_hash);
   mutt_clear_threads(ctx);
+  /* The pool's region is released with the last email */
+  mutt_slab_pool_free(&ctx->mailbox->slabs);
   for (int i = 0; i < ctx->mailbox->msg_count; i++)
     mutt_email_free(&ctx->mailbox->hdrs[i]);
   FREE(&ctx->mailbox->hdrs);
@@ -840,9 +852,6 @@ void mx_update_tables(struct Context *ctx, bool committing)
                                ctx->mailbox->hdrs[i]->content->hdr_offset);
       }
       /* remove message from the hash tables */
-      if (ctx->mailbox->subj_hash && ctx->mailbox->hdrs[i]->env->real_subj)
-        mutt_hash_delete(ctx->mailbox->subj_hash, ctx->mailbox->hdrs[i]->env->real_subj,
-                         ctx->mailbox->hdrs[i]);
       if (ctx->mailbox->id_hash && ctx->mailbox->hdrs[i]->env->message_id)
         mutt_hash_delete(ctx->mailbox->id_hash, ctx->mailbox->hdrs[i]->env->message_id,
                          ctx->mailbox->hdrs[i]);
@@ -1067,7 +1076,11 @@ int mx_mbox_check(struct Context *ctx, int *index_hint)
     return -1;
   }
 
-  return ctx->mailbox->mx_ops->mbox_check(ctx, index_hint);
+  struct SlabPool *old_pool = EmailSlabPool;
+  EmailSlabPool = ctx->mailbox->slabs;
+  int rc = ctx->mailbox->mx_ops->mbox_check(ctx, index_hint);
+  EmailSlabPool = old_pool;
+  return rc;
 }
 
 /**
@@ -1145,29 +1158,30 @@ int mx_msg_close(struct Context *ctx, struct Message **msg)
 }
 
 /**
- * mx_alloc_memory - Create storage for the emails
+ * mx_reserve_memory - Make room for a number of emails
  * @param mailbox Mailbox
+ * @param count   Number of emails the Mailbox must be able to hold
+ *
+ * Backends that know how many emails they are about to read should call this
+ * first, so that the storage is only allocated once.
  */
-void mx_alloc_memory(struct Mailbox *mailbox)
+void mx_reserve_memory(struct Mailbox *mailbox, int count)
 {
+  if (!mailbox || (count <= mailbox->hdrmax))
+    return;
+
   size_t s = MAX(sizeof(struct Email *), sizeof(int));
 
-  if ((mailbox->hdrmax + 25) * s < mailbox->hdrmax * s)
+  if ((size_t) count > (SIZE_MAX / s))
   {
     mutt_error(_("Out of memory"));
     mutt_exit(1);
   }
 
-  if (mailbox->hdrs)
-  {
-    mutt_mem_realloc(&mailbox->hdrs, sizeof(struct Email *) * (mailbox->hdrmax += 25));
-    mutt_mem_realloc(&mailbox->v2r, sizeof(int) * mailbox->hdrmax);
-  }
-  else
-  {
-    mailbox->hdrs = mutt_mem_calloc((mailbox->hdrmax += 25), sizeof(struct Email *));
-    mailbox->v2r = mutt_mem_calloc(mailbox->hdrmax, sizeof(int));
-  }
+  mutt_mem_realloc(&mailbox->hdrs, sizeof(struct Email *) * count);
+  mutt_mem_realloc(&mailbox->v2r, sizeof(int) * count);
+  mailbox->hdrmax = count;
+
   for (int i = mailbox->msg_count; i < mailbox->hdrmax; i++)
   {
     mailbox->hdrs[i] = NULL;
@@ -1175,6 +1189,25 @@ void mx_alloc_memory(struct Mailbox *mailbox)
   }
 }
 
+/**
+ * mx_alloc_memory - Create storage for the emails
+ * @param mailbox Mailbox
+ *
+ * The storage grows by half each time, so reading n emails costs O(n) copying.
+ */
+void mx_alloc_memory(struct Mailbox *mailbox)
+{
+  const int grow = MAX(mailbox->hdrmax / 2, 25);
+
+  if (mailbox->hdrmax > (INT_MAX - grow))
+  {
+    mutt_error(_("Out of memory"));
+    mutt_exit(1);
+  }
+
+  mx_reserve_memory(mailbox, mailbox->hdrmax + grow);
+}
+
 /**
  * mx_update_context - Update the Context's message counts
  * @param ctx          Mailbox
@@ -1225,8 +1258,6 @@ void mx_update_context(struct Context *ctx, int new_messages)
     /* add this message to the hash tables */
     if (ctx->mailbox->id_hash && e->env->message_id)
       mutt_hash_insert(ctx->mailbox->id_hash, e->env->message_id, e);
-    if (ctx->mailbox->subj_hash && e->env->real_subj)
-      mutt_hash_insert(ctx->mailbox->subj_hash, e->env->real_subj, e);
     mutt_label_hash_add(ctx->mailbox, e);
 
     if (Score)
@@ -256,6 +256,7 @@ int                 mx_check_empty(const char *path);
 int                 mx_check_mailbox(struct Context *ctx, int *index_hint);
 void                mx_fastclose_mailbox(struct Context *ctx);
 const struct MxOps *mx_get_ops(enum MailboxType magic);
+void                mx_reserve_memory(struct Mailbox *mailbox, int count);
 bool                mx_tags_is_supported(struct Context *ctx);
 void                mx_update_context(struct Context *ctx, int new_messages);
 void                mx_update_tables(struct Context *ctx, bool committing);
@@ -763,7 +763,7 @@ void nntp_hcache_update(struct NntpMboxData *mdata, header_cache_t *hc)
     return;
 
   /* fetch previous values of first and last */
-  hdata = mutt_hcache_fetch_raw(hc, "index", 5);
+  hdata = mutt_hcache_fetch_raw(hc, "index", 5, NULL);
   if (hdata)
   {
     mutt_debug(2, "mutt_hcache_fetch index: %s\n", (char *) hdata);
@@ -1153,7 +1153,7 @@ struct NntpServer *nntp_select_server(struct Mailbox *mailbox, char *server, boo
           continue;
 
         /* fetch previous values of first and last */
-        hdata = mutt_hcache_fetch_raw(hc, "index", 5);
+        hdata = mutt_hcache_fetch_raw(hc, "index", 5, NULL);
         if (hdata)
         {
           anum_t first, last;
@@ -1172,6 +1172,8 @@ static int nntp_fetch_headers(struct Context *ctx, void *hc, anum_t first,
     return -1;
 #ifdef USE_HCACHE
   fc.hc = hc;
+  /* Group all the header stores and deletes into a single transaction */
+  mutt_hcache_begin(fc.hc);
 #endif
 
   /* fetch list of articles */
@@ -1218,6 +1220,13 @@ static int nntp_fetch_headers(struct Context *ctx, void *hc, anum_t first,
       fc.messages[current - first] = 1;
   }
 
+  /* make room for all the articles in the range */
+  int count = 0;
+  for (current = first; current <= last; current++)
+    if (fc.messages[current - first])
+      count++;
+  mx_reserve_memory(ctx->mailbox, ctx->mailbox->msg_count + count);
+
   /* fetching header from cache or server, or fallback to fetch overview */
   if (!ctx->mailbox->quiet)
   {
@@ -1364,6 +1373,10 @@ static int nntp_fetch_headers(struct Context *ctx, void *hc, anum_t first,
     }
   }
 
+#ifdef USE_HCACHE
+  mutt_hcache_commit(fc.hc);
+#endif
+
   if (ctx->mailbox->msg_count > oldmsgcount)
     mx_update_context(ctx, ctx->mailbox->msg_count - oldmsgcount);
 
@@ -1594,8 +1607,6 @@ static int check_mailbox(struct Context *ctx)
   /* some headers were removed, context must be updated */
   if (ret == MUTT_REOPENED)
   {
-    if (ctx->mailbox->subj_hash)
-      mutt_hash_destroy(&ctx->mailbox->subj_hash);
     if (ctx->mailbox->id_hash)
       mutt_hash_destroy(&ctx->mailbox->id_hash);
     mutt_clear_threads(ctx);
@@ -1607,7 +1618,6 @@ static int check_mailbox(struct Context *ctx)
     ctx->mailbox->msg_flagged = 0;
     ctx->mailbox->changed = false;
     ctx->mailbox->id_hash = NULL;
-    ctx->mailbox->subj_hash = NULL;
     mx_update_context(ctx, ctx->mailbox->msg_count);
   }
 
@@ -2452,6 +2462,7 @@ static int nntp_mbox_sync(struct Context *ctx, int *index_hint)
 #ifdef USE_HCACHE
   mdata->last_cached = 0;
   hc = nntp_hcache_open(mdata);
+  mutt_hcache_begin(hc);
 #endif
 
   for (int i = 0; i < ctx->mailbox->msg_count; i++)
@@ -2607,16 +2618,12 @@ static int nntp_msg_open(struct Context *ctx, struct Message *msg, int msgno)
    * hash elements must be updated because pointers will be changed */
   if (ctx->mailbox->id_hash && e->env->message_id)
     mutt_hash_delete(ctx->mailbox->id_hash, e->env->message_id, e);
-  if (ctx->mailbox->subj_hash && e->env->real_subj)
-    mutt_hash_delete(ctx->mailbox->subj_hash, e->env->real_subj, e);
 
   mutt_env_free(&e->env);
   e->env = mutt_rfc822_read_header(msg->fp, e, false, false);
 
   if (ctx->mailbox->id_hash && e->env->message_id)
     mutt_hash_insert(ctx->mailbox->id_hash, e->env->message_id, e);
-  if (ctx->mailbox->subj_hash && e->env->real_subj)
-    mutt_hash_insert(ctx->mailbox->subj_hash, e->env->real_subj, e);
 
   /* fix content length */
   fseek(msg->fp, 0, SEEK_END);
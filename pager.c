@@ -175,6 +175,36 @@ struct Line
   unsigned int is_cont_hdr; /**< this line is a continuation of the previous header line */
 };
 
+/**
+ * struct LineCache - What the regexes found in a line of the pager
+ *
+ * The colour chunks and quote prefix of a line only depend on its text, so
+ * they are kept, keyed by the text, for as long as the pager shows the file.
+ * Repeated lines are only matched once and reflowing the text doesn't match
+ * the lines again.
+ */
+struct LineCache
+{
+  struct ColorLineHead *head; /**< Colour rules that made the chunks, or NULL */
+  short chunks;               /**< Number of coloured chunks */
+  struct Syntax *syntax;      /**< Coloured chunks */
+  short quoted;               /**< Is the line quoted? -1 if not known yet */
+  regmatch_t qmatch;          /**< Quote prefix, if quoted */
+  struct QClass *qclass;      /**< Class of the quote prefix, if known */
+};
+
+/**
+ * struct ColorMatch - Where a colour rule next matches a line
+ */
+struct ColorMatch
+{
+  bool known;      /**< The rule has been run */
+  bool found;      /**< The rule matched */
+  bool positional; /**< The match can depend on where the search starts */
+  int first;       /**< Start of the match */
+  int last;        /**< End of the match */
+};
+
 #define ANSI_OFF (1 << 0)
 #define ANSI_BLINK (1 << 1)
 #define ANSI_BOLD (1 << 2)
@@ -840,9 +870,10 @@ int mutt_is_quote_line(char *line, regmatch_t *pmatch)
   if (!pmatch)
     pmatch = pmatch_internal;
 
-  if (QuoteRegex && QuoteRegex->regex && regexec(QuoteRegex->regex, line, 1, pmatch, 0) == 0)
+  if (QuoteRegex && QuoteRegex->regex &&
+      mutt_regex_exec(QuoteRegex, line, 1, pmatch, 0) == 0)
   {
-    if (Smileys && Smileys->regex && regexec(Smileys->regex, line, 1, smatch, 0) == 0)
+    if (Smileys && Smileys->regex && mutt_regex_exec(Smileys, line, 1, smatch, 0) == 0)
     {
       if (smatch[0].rm_so > 0)
       {
@@ -862,6 +893,245 @@ int mutt_is_quote_line(char *line, regmatch_t *pmatch)
   return is_quote;
 }
 
+/**
+ * line_cache_free - Free a LineCache - Implements ::hash_destructor_t
+ */
+static void line_cache_free(int type, void *obj, intptr_t data)
+{
+  struct LineCache *lc = obj;
+
+  FREE(&lc->syntax);
+  FREE(&lc);
+}
+
+/**
+ * line_cache_get - Get the cached results for a line
+ * @param cache Cache of lines (created if necessary)
+ * @param line  Text of the line
+ * @retval ptr  Cached results for the line
+ * @retval NULL There's no cache
+ */
+static struct LineCache *line_cache_get(struct Hash **cache, const char *line)
+{
+  if (!cache)
+    return NULL;
+
+  if (!*cache)
+  {
+    *cache = mutt_hash_create(1024, MUTT_HASH_STRDUP_KEYS);
+    mutt_hash_set_destructor(*cache, line_cache_free, 0);
+  }
+
+  struct LineCache *lc = mutt_hash_find(*cache, line);
+  if (lc)
+    return lc;
+
+  lc = mutt_mem_calloc(1, sizeof(struct LineCache));
+  lc->quoted = -1;
+  mutt_hash_insert(*cache, line, lc);
+  return lc;
+}
+
+/**
+ * is_cached_quote_line - Is a line of message text a quote?
+ * @param[in]  line   Line to test
+ * @param[in]  lc     Cached results for the line (optional)
+ * @param[out] pmatch Regex sub-matches
+ * @retval true Line is quoted
+ *
+ * Like mutt_is_quote_line(), but the answer is remembered in the cache.
+ */
+static bool is_cached_quote_line(char *line, struct LineCache *lc, regmatch_t *pmatch)
+{
+  if (!lc)
+    return mutt_is_quote_line(line, pmatch);
+
+  if (lc->quoted < 0)
+    lc->quoted = mutt_is_quote_line(line, &lc->qmatch);
+
+  pmatch[0] = lc->qmatch;
+  return lc->quoted;
+}
+
+/**
+ * regex_is_positional - Can a regex match differently if the text is cut?
+ * @param r Regex to check
+ * @retval true The regex can look before its match, e.g. '\<' or '\b'
+ *
+ * resolve_color_chunks() searches from the middle of a line, but the regex
+ * engine sees that as the start of the text.  That only matters to the
+ * assertions that look at the character before a match.
+ */
+static bool regex_is_positional(const struct Regex *r)
+{
+  if (!r || !r->pattern)
+    return true;
+
+  for (const char *p = r->pattern; *p; p++)
+  {
+    if ((p[0] == '\\') && p[1])
+    {
+      if (strchr("<>bBAGK`'", p[1]))
+        return true;
+      p++;
+    }
+    else if ((p[0] == '(') && (p[1] == '?') && (p[2] == '<'))
+      return true;
+  }
+  return false;
+}
+
+/**
+ * resolve_color_chunks - Split a line into chunks coloured by a list of rules
+ * @param line_info Line info array
+ * @param n         Line number (index into line_info)
+ * @param buf       Text of the line, without the line ending
+ * @param head      Colour rules, e.g. #ColorBodyList
+ *
+ * From the start of the line, the leftmost, then longest, match of any rule
+ * becomes the next chunk.  Rather than running every rule again after each
+ * chunk, a rule's match is remembered until a chunk passes its start.  So,
+ * each rule is usually run once or twice per line.
+ */
+static void resolve_color_chunks(struct Line *line_info, int n, const char *buf,
+                                 struct ColorLineHead *head)
+{
+  struct ColorLine *color_line = NULL;
+  struct ColorMatch *cm = NULL;
+  regmatch_t pmatch[1];
+  bool found;
+  bool null_rx;
+  int offset = 0, i = 0;
+  size_t num = 0, total = 0;
+
+  STAILQ_FOREACH(color_line, head, entries)
+  {
+    total++;
+  }
+  if (total == 0)
+  {
+    line_info[n].chunks = 0;
+    return;
+  }
+
+  cm = mutt_mem_calloc(total, sizeof(struct ColorMatch));
+  num = 0;
+  STAILQ_FOREACH(color_line, head, entries)
+  {
+    cm[num++].positional = regex_is_positional(color_line->regex);
+  }
+
+  line_info[n].chunks = 0;
+  do
+  {
+    if (!buf[offset])
+      break;
+
+    found = false;
+    null_rx = false;
+    num = 0;
+    STAILQ_FOREACH(color_line, head, entries)
+    {
+      struct ColorMatch *m = &cm[num++];
+
+      if (!m->known || m->positional || (m->found && (m->first < offset)))
+      {
+        m->known = true;
+        m->found = (mutt_regex_exec(color_line->regex, buf + offset, 1, pmatch,
+                                    (offset ? REG_NOTBOL : 0)) == 0);
+        if (m->found)
+        {
+          m->first = pmatch[0].rm_so + offset;
+          m->last = pmatch[0].rm_eo + offset;
+        }
+      }
+
+      if (!m->found)
+        continue;
+
+      if (m->last != m->first)
+      {
+        if (!found)
+        {
+          /* Abort if we fill up chunks.
+           * Yes, this really happened. See #3888 */
+          if (line_info[n].chunks == SHRT_MAX)
+          {
+            null_rx = false;
+            break;
+          }
+          if (++(line_info[n].chunks) > 1)
+          {
+            mutt_mem_realloc(&(line_info[n].syntax),
+                             (line_info[n].chunks) * sizeof(struct Syntax));
+          }
+        }
+        i = line_info[n].chunks - 1;
+        if (!found || m->first < (line_info[n].syntax)[i].first ||
+            (m->first == (line_info[n].syntax)[i].first &&
+             m->last > (line_info[n].syntax)[i].last))
+        {
+          (line_info[n].syntax)[i].color = color_line->pair;
+          (line_info[n].syntax)[i].first = m->first;
+          (line_info[n].syntax)[i].last = m->last;
+        }
+        found = true;
+        null_rx = false;
+      }
+      else
+        null_rx = true; /* empty regex; don't add it, but keep looking */
+    }
+
+    if (null_rx)
+    {
+      offset++; /* avoid degenerate cases */
+      /* the offset may now be inside a multibyte character, so start again */
+      for (size_t j = 0; j < total; j++)
+        cm[j].known = false;
+    }
+    else
+      offset = (line_info[n].syntax)[i].last;
+  } while (found || null_rx);
+
+  FREE(&cm);
+}
+
+/**
+ * resolve_cached_chunks - Colour a line, using the cache if possible
+ * @param line_info Line info array
+ * @param n         Line number (index into line_info)
+ * @param buf       Text of the line, without the line ending
+ * @param head      Colour rules, e.g. #ColorBodyList
+ * @param lc        Cached results for the line (optional)
+ */
+static void resolve_cached_chunks(struct Line *line_info, int n, const char *buf,
+                                  struct ColorLineHead *head, struct LineCache *lc)
+{
+  if (lc && (lc->head == head))
+  {
+    line_info[n].chunks = lc->chunks;
+    if (lc->chunks > 1)
+      mutt_mem_realloc(&(line_info[n].syntax), lc->chunks * sizeof(struct Syntax));
+    if (lc->chunks > 0)
+      memcpy(line_info[n].syntax, lc->syntax, lc->chunks * sizeof(struct Syntax));
+    return;
+  }
+
+  resolve_color_chunks(line_info, n, buf, head);
+
+  if (lc)
+  {
+    FREE(&lc->syntax);
+    lc->head = head;
+    lc->chunks = line_info[n].chunks;
+    if (lc->chunks > 0)
+    {
+      lc->syntax = mutt_mem_malloc(lc->chunks * sizeof(struct Syntax));
+      memcpy(lc->syntax, line_info[n].syntax, lc->chunks * sizeof(struct Syntax));
+    }
+  }
+}
+
 /**
  * resolve_types - Determine the style for a line of text
  * @param buf          Formatted text
@@ -871,18 +1141,18 @@ int mutt_is_quote_line(char *line, regmatch_t *pmatch)
  * @param last         Last line
  * @param quote_list   List of quote colours
  * @param q_level      Quote level
+ * @param line_cache   Cache of the regex results, keyed by text (optional)
  * @param force_redraw Set to true if a screen redraw is needed
  * @param q_classify   If true, style the text
  */
 static void resolve_types(char *buf, char *raw, struct Line *line_info, int n,
                           int last, struct QClass **quote_list, int *q_level,
-                          bool *force_redraw, bool q_classify)
+                          struct Hash **line_cache, bool *force_redraw, bool q_classify)
 {
   struct ColorLine *color_line = NULL;
+  struct LineCache *lc = line_cache_get(line_cache, buf);
   regmatch_t pmatch[1];
-  bool found;
-  bool null_rx;
-  int offset, i = 0;
+  int i = 0;
 
   if (n == 0 || ISHEADER(line_info[n - 1].type))
   {
@@ -917,7 +1187,7 @@ static void resolve_types(char *buf, char *raw, struct Line *line_info, int n,
       {
         STAILQ_FOREACH(color_line, &ColorHdrList, entries)
         {
-          if (regexec(&color_line->regex, buf, 0, NULL, 0) == 0)
+          if (mutt_regex_exec(color_line->regex, buf, 0, NULL, 0) == 0)
           {
             line_info[n].type = MT_COLOR_HEADER;
             line_info[n].syntax[0].color = color_line->pair;
@@ -968,14 +1238,20 @@ static void resolve_types(char *buf, char *raw, struct Line *line_info, int n,
   }
   else if (check_sig(buf, line_info, n - 1) == 0)
     line_info[n].type = MT_COLOR_SIGNATURE;
-  else if (mutt_is_quote_line(buf, pmatch))
-
+  else if (is_cached_quote_line(buf, lc, pmatch))
   {
     if (q_classify && line_info[n].quote == NULL)
     {
-      line_info[n].quote = classify_quote(quote_list, buf + pmatch[0].rm_so,
-                                          pmatch[0].rm_eo - pmatch[0].rm_so,
-                                          force_redraw, q_level);
+      if (lc && lc->qclass)
+        line_info[n].quote = lc->qclass;
+      else
+      {
+        line_info[n].quote = classify_quote(quote_list, buf + pmatch[0].rm_so,
+                                            pmatch[0].rm_eo - pmatch[0].rm_so,
+                                            force_redraw, q_level);
+        if (lc)
+          lc->qclass = line_info[n].quote;
+      }
     }
     line_info[n].type = MT_COLOR_QUOTED;
   }
@@ -994,67 +1270,12 @@ static void resolve_types(char *buf, char *raw, struct Line *line_info, int n,
     if ((nl > 0) && (buf[nl - 1] == '\n'))
       buf[nl - 1] = 0;
 
-    i = 0;
-    offset = 0;
-    line_info[n].chunks = 0;
-    do
-    {
-      if (!buf[offset])
-        break;
-
-      found = false;
-      null_rx = false;
-      struct ColorLineHead *head = NULL;
-      if (line_info[n].type == MT_COLOR_HDEFAULT)
-        head = &ColorHdrList;
-      else
-        head = &ColorBodyList;
-      STAILQ_FOREACH(color_line, head, entries)
-      {
-        if (regexec(&color_line->regex, buf + offset, 1, pmatch,
-                    (offset ? REG_NOTBOL : 0)) == 0)
-        {
-          if (pmatch[0].rm_eo != pmatch[0].rm_so)
-          {
-            if (!found)
-            {
-              /* Abort if we fill up chunks.
-               * Yes, this really happened. See #3888 */
-              if (line_info[n].chunks == SHRT_MAX)
-              {
-                null_rx = false;
-                break;
-              }
-              if (++(line_info[n].chunks) > 1)
-              {
-                mutt_mem_realloc(&(line_info[n].syntax),
-                                 (line_info[n].chunks) * sizeof(struct Syntax));
-              }
-            }
-            i = line_info[n].chunks - 1;
-            pmatch[0].rm_so += offset;
-            pmatch[0].rm_eo += offset;
-            if (!found || pmatch[0].rm_so < (line_info[n].syntax)[i].first ||
-                (pmatch[0].rm_so == (line_info[n].syntax)[i].first &&
-                 pmatch[0].rm_eo > (line_info[n].syntax)[i].last))
-            {
-              (line_info[n].syntax)[i].color = color_line->pair;
-              (line_info[n].syntax)[i].first = pmatch[0].rm_so;
-              (line_info[n].syntax)[i].last = pmatch[0].rm_eo;
-            }
-            found = true;
-            null_rx = false;
-          }
-          else
-            null_rx = true; /* empty regex; don't add it, but keep looking */
-        }
-      }
-
-      if (null_rx)
-        offset++; /* avoid degenerate cases */
-      else
-        offset = (line_info[n].syntax)[i].last;
-    } while (found || null_rx);
+    struct ColorLineHead *head = NULL;
+    if (line_info[n].type == MT_COLOR_HDEFAULT)
+      head = &ColorHdrList;
+    else
+      head = &ColorBodyList;
+    resolve_cached_chunks(line_info, n, buf, head, lc);
     if (nl > 0)
       buf[nl] = '\n';
   }
@@ -1069,55 +1290,7 @@ static void resolve_types(char *buf, char *raw, struct Line *line_info, int n,
     if ((nl > 0) && (buf[nl - 1] == '\n'))
       buf[nl - 1] = 0;
 
-    i = 0;
-    offset = 0;
-    line_info[n].chunks = 0;
-    do
-    {
-      if (!buf[offset])
-        break;
-
-      found = false;
-      null_rx = false;
-      STAILQ_FOREACH(color_line, &ColorAttachList, entries)
-      {
-        if (regexec(&color_line->regex, buf + offset, 1, pmatch,
-                    (offset ? REG_NOTBOL : 0)) == 0)
-        {
-          if (pmatch[0].rm_eo != pmatch[0].rm_so)
-          {
-            if (!found)
-            {
-              if (++(line_info[n].chunks) > 1)
-              {
-                mutt_mem_realloc(&(line_info[n].syntax),
-                                 (line_info[n].chunks) * sizeof(struct Syntax));
-              }
-            }
-            i = line_info[n].chunks - 1;
-            pmatch[0].rm_so += offset;
-            pmatch[0].rm_eo += offset;
-            if (!found || pmatch[0].rm_so < (line_info[n].syntax)[i].first ||
-                (pmatch[0].rm_so == (line_info[n].syntax)[i].first &&
-                 pmatch[0].rm_eo > (line_info[n].syntax)[i].last))
-            {
-              (line_info[n].syntax)[i].color = color_line->pair;
-              (line_info[n].syntax)[i].first = pmatch[0].rm_so;
-              (line_info[n].syntax)[i].last = pmatch[0].rm_eo;
-            }
-            found = 1;
-            null_rx = 0;
-          }
-          else
-            null_rx = 1; /* empty regex; don't add it, but keep looking */
-        }
-      }
-
-      if (null_rx)
-        offset++; /* avoid degenerate cases */
-      else
-        offset = (line_info[n].syntax)[i].last;
-    } while (found || null_rx);
+    resolve_cached_chunks(line_info, n, buf, &ColorAttachList, lc);
     if (nl > 0)
       buf[nl] = '\n';
   }
@@ -1504,6 +1677,7 @@ static int format_line(struct Line **line_info, int n, unsigned char *buf, int f
  * @param flags           See below
  * @param quote_list      Email quoting style
  * @param q_level         Level of quoting
+ * @param line_cache      Cache of the regex results, keyed by text
  * @param force_redraw    Force a repaint
  * @param search_re       Regex to highlight
  * @param pager_window    Window to draw into
@@ -1522,8 +1696,8 @@ static int format_line(struct Line **line_info, int n, unsigned char *buf, int f
  */
 static int display_line(FILE *f, LOFF_T *last_pos, struct Line **line_info, int n,
                         int *last, int *max, int flags, struct QClass **quote_list,
-                        int *q_level, bool *force_redraw, regex_t *search_re,
-                        struct MuttWindow *pager_window)
+                        int *q_level, struct Hash **line_cache, bool *force_redraw,
+                        regex_t *search_re, struct MuttWindow *pager_window)
 {
   unsigned char *buf = NULL, *fmt = NULL;
   size_t buflen = 0;
@@ -1592,7 +1766,8 @@ static int display_line(FILE *f, LOFF_T *last_pos, struct Line **line_info, int
       }
 
       resolve_types((char *) fmt, (char *) buf, *line_info, n, *last,
-                    quote_list, q_level, force_redraw, flags & MUTT_SHOWCOLOR);
+                    quote_list, q_level, line_cache, force_redraw,
+                    flags & MUTT_SHOWCOLOR);
 
       /* avoid race condition for continuation lines when scrolling up */
       for (m = n + 1; m < *last && (*line_info)[m].offset && (*line_info)[m].continuation; m++)
@@ -1864,6 +2039,7 @@ struct PagerRedrawData
   int hide_quoted;
   int q_level;
   struct QClass *quote_list;
+  struct Hash *line_cache; /**< Regex results for the lines of the file */
   LOFF_T last_pos;
   LOFF_T last_offset;
   struct MuttWindow *index_status_window;
@@ -2043,7 +2219,7 @@ static void pager_custom_redraw(struct Menu *pager_menu)
     int j = -1;
     while (display_line(rd->fp, &rd->last_pos, &rd->line_info, ++i, &rd->last_line,
                         &rd->max_line, rd->has_types | rd->search_flag | (rd->flags & MUTT_PAGER_NOWRAP),
-                        &rd->quote_list, &rd->q_level, &rd->force_redraw,
+                        &rd->quote_list, &rd->q_level, &rd->line_cache, &rd->force_redraw,
                         &rd->search_re, rd->pager_window) == 0)
     {
       if (!rd->line_info[i].continuation && ++j == rd->lines)
@@ -2079,7 +2255,7 @@ static void pager_custom_redraw(struct Menu *pager_menu)
                          &rd->last_line, &rd->max_line,
                          (rd->flags & MUTT_DISPLAYFLAGS) | rd->hide_quoted |
                              rd->search_flag | (rd->flags & MUTT_PAGER_NOWRAP),
-                         &rd->quote_list, &rd->q_level, &rd->force_redraw,
+                         &rd->quote_list, &rd->q_level, &rd->line_cache, &rd->force_redraw,
                          &rd->search_re, rd->pager_window) > 0)
         {
           rd->lines++;
@@ -2702,7 +2878,7 @@ int mutt_pager(const char *banner, const char *fname, int flags, struct Pager *e
           i = 0;
           while (display_line(rd.fp, &rd.last_pos, &rd.line_info, i, &rd.last_line, &rd.max_line,
                               MUTT_SEARCH | (flags & MUTT_PAGER_NSKIP) | (flags & MUTT_PAGER_NOWRAP),
-                              &rd.quote_list, &rd.q_level, &rd.force_redraw,
+                              &rd.quote_list, &rd.q_level, &rd.line_cache, &rd.force_redraw,
                               &rd.search_re, rd.pager_window) == 0)
             i++;
 
@@ -2813,7 +2989,7 @@ int mutt_pager(const char *banner, const char *fname, int flags, struct Pager *e
                     (0 == (dretval = display_line(
                                rd.fp, &rd.last_pos, &rd.line_info, new_topline, &rd.last_line,
                                &rd.max_line, MUTT_TYPES | (flags & MUTT_PAGER_NOWRAP),
-                               &rd.quote_list, &rd.q_level, &rd.force_redraw,
+                               &rd.quote_list, &rd.q_level, &rd.line_cache, &rd.force_redraw,
                                &rd.search_re, rd.pager_window)))) &&
                    ISHEADER(rd.line_info[new_topline].type))
             {
@@ -2827,7 +3003,7 @@ int mutt_pager(const char *banner, const char *fname, int flags, struct Pager *e
                   (0 == (dretval = display_line(
                              rd.fp, &rd.last_pos, &rd.line_info, new_topline, &rd.last_line,
                              &rd.max_line, MUTT_TYPES | (flags & MUTT_PAGER_NOWRAP),
-                             &rd.quote_list, &rd.q_level, &rd.force_redraw,
+                             &rd.quote_list, &rd.q_level, &rd.line_cache, &rd.force_redraw,
                              &rd.search_re, rd.pager_window)))) &&
                  rd.line_info[new_topline + SkipQuotedOffset].type != MT_COLOR_QUOTED)
             new_topline++;
@@ -2842,7 +3018,7 @@ int mutt_pager(const char *banner, const char *fname, int flags, struct Pager *e
                   (0 == (dretval = display_line(
                              rd.fp, &rd.last_pos, &rd.line_info, new_topline, &rd.last_line,
                              &rd.max_line, MUTT_TYPES | (flags & MUTT_PAGER_NOWRAP),
-                             &rd.quote_list, &rd.q_level, &rd.force_redraw,
+                             &rd.quote_list, &rd.q_level, &rd.line_cache, &rd.force_redraw,
                              &rd.search_re, rd.pager_window)))) &&
                  rd.line_info[new_topline + SkipQuotedOffset].type == MT_COLOR_QUOTED)
             new_topline++;
@@ -2863,7 +3039,7 @@ int mutt_pager(const char *banner, const char *fname, int flags, struct Pager *e
           /* make sure the types are defined to the end of file */
           while (display_line(rd.fp, &rd.last_pos, &rd.line_info, i, &rd.last_line,
                               &rd.max_line, rd.has_types | (flags & MUTT_PAGER_NOWRAP),
-                              &rd.quote_list, &rd.q_level, &rd.force_redraw,
+                              &rd.quote_list, &rd.q_level, &rd.line_cache, &rd.force_redraw,
                               &rd.search_re, rd.pager_window) == 0)
             i++;
           rd.topline = up_n_lines(rd.pager_window->rows, rd.line_info,
@@ -3019,6 +3195,8 @@ int mutt_pager(const char *banner, const char *fname, int flags, struct Pager *e
         old_PagerIndexLines = PagerIndexLines;
 
         mutt_enter_command();
+        /* the colours or $quote_regex may have changed */
+        mutt_hash_destroy(&rd.line_cache);
 
         if (OptNeedResort)
         {
@@ -3450,6 +3628,7 @@ int mutt_pager(const char *banner, const char *fname, int flags, struct Pager *e
   }
 
   cleanup_quote(&rd.quote_list);
+  mutt_hash_destroy(&rd.line_cache);
 
   for (i = 0; i < rd.max_line; i++)
   {
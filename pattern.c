@@ -31,6 +31,7 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 #include "mutt/mutt.h"
 #include "config/lib.h"
 #include "email/lib.h"
@@ -60,8 +61,16 @@
 #ifdef USE_IMAP
 #include "imap/imap.h"
 #endif
+#ifdef USE_HCACHE
+#include "textindex.h"
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <signal.h>
+#endif
 
 /* These Config Variables are only used in pattern.c */
+short SearchThreads; ///< Config: Number of threads searching message text
 bool ThoroughSearch; ///< Config: Decode headers and messages before searching them
 
 // clang-format off
@@ -220,18 +229,24 @@ static bool eat_regex(struct Pattern *pat, struct Buffer *s, struct Buffer *err)
   }
   else
   {
-    pat->p.regex = mutt_mem_malloc(sizeof(regex_t));
-    int flags = mutt_mb_is_lower(buf.data) ? REG_ICASE : 0;
-    r = REGCOMP(pat->p.regex, buf.data, REG_NEWLINE | REG_NOSUB | flags);
+    struct Regex *rx = mutt_mem_calloc(1, sizeof(struct Regex));
+    rx->regex = mutt_mem_malloc(sizeof(regex_t));
+    int flags = REG_NEWLINE | REG_NOSUB;
+    if (mutt_mb_is_lower(buf.data))
+      flags |= REG_ICASE;
+    r = REGCOMP(rx->regex, buf.data, flags);
     if (r != 0)
     {
-      regerror(r, pat->p.regex, errmsg, sizeof(errmsg));
+      regerror(r, rx->regex, errmsg, sizeof(errmsg));
       mutt_buffer_add_printf(err, "'%s': %s", buf.data, errmsg);
       FREE(&buf.data);
-      FREE(&pat->p.regex);
+      FREE(&rx->regex);
+      FREE(&rx);
       return false;
     }
-    FREE(&buf.data);
+    mutt_regex_prepare(rx, buf.data, flags);
+    rx->pattern = buf.data;
+    pat->p.regex = rx;
   }
 
   return true;
@@ -959,29 +974,29 @@ static int patmatch(const struct Pattern *pat, const char *buf)
   else if (pat->groupmatch)
     return !mutt_group_match(pat->p.g, buf);
   else
-    return regexec(pat->p.regex, buf, 0, NULL, 0);
+    return mutt_regex_exec(pat->p.regex, buf, 0, NULL, 0);
 }
 
 /**
- * msg_search - Search an email
- * @param ctx   Mailbox
- * @param pat   Pattern to find
- * @param msgno Message to search
+ * search_message - Search the text of an email
+ * @param pat     Pattern to find (~b, ~B or ~h)
+ * @param e       Email
+ * @param fpin    Open message (or mailbox) file
+ * @param charset Charset of parts that don't name one, NULL to look it up
  * @retval true Pattern found
  * @retval false Error or pattern not found
+ *
+ * The MIME structure of the email must already have been parsed, if the body
+ * needs decoding.  This only reads the file, so it may be called on a search
+ * thread, see mutt_can_decode_concurrently().  The threads must pass the
+ * charset in, because mutt_ch_get_default_charset() uses a static buffer.
  */
-static bool msg_search(struct Context *ctx, struct Pattern *pat, int msgno)
+static bool search_message(struct Pattern *pat, struct Email *e, FILE *fpin,
+                           const char *charset)
 {
   bool match = false;
-  struct Message *msg = mx_msg_open(ctx, msgno);
-  if (!msg)
-  {
-    return match;
-  }
-
   FILE *fp = NULL;
   long lng = 0;
-  struct Email *e = ctx->mailbox->hdrs[msgno];
 #ifdef USE_FMEMOPEN
   char *temp = NULL;
   size_t tempsize;
@@ -993,8 +1008,9 @@ static bool msg_search(struct Context *ctx, struct Pattern *pat, int msgno)
   {
     /* decode the header / body */
     struct State s = { 0 };
-    s.fpin = msg->fp;
+    s.fpin = fpin;
     s.flags = MUTT_CHARCONV;
+    s.charset = charset;
 #ifdef USE_FMEMOPEN
     s.fpout = open_memstream(&temp, &tempsize);
     if (!s.fpout)
@@ -1012,26 +1028,11 @@ static bool msg_search(struct Context *ctx, struct Pattern *pat, int msgno)
 #endif
 
     if (pat->op != MUTT_BODY)
-      mutt_copy_header(msg->fp, e, s.fpout, CH_FROM | CH_DECODE, NULL);
+      mutt_copy_header(fpin, e, s.fpout, CH_FROM | CH_DECODE, NULL);
 
     if (pat->op != MUTT_HEADER)
     {
-      mutt_parse_mime_message(ctx, e);
-
-      if ((WithCrypto != 0) && (e->security & ENCRYPT) && !crypt_valid_passphrase(e->security))
-      {
-        mx_msg_close(ctx, &msg);
-        if (s.fpout)
-        {
-          mutt_file_fclose(&s.fpout);
-#ifdef USE_FMEMOPEN
-          FREE(&temp);
-#endif
-        }
-        return false;
-      }
-
-      fseeko(msg->fp, e->offset, SEEK_SET);
+      fseeko(fpin, e->offset, SEEK_SET);
       mutt_body_handler(e->content, &s);
     }
 
@@ -1045,6 +1046,7 @@ static bool msg_search(struct Context *ctx, struct Pattern *pat, int msgno)
       if (!fp)
       {
         mutt_perror(_("Error re-opening 'memory stream'"));
+        FREE(&temp);
         return false;
       }
     }
@@ -1068,7 +1070,7 @@ static bool msg_search(struct Context *ctx, struct Pattern *pat, int msgno)
   else
   {
     /* raw header / body */
-    fp = msg->fp;
+    fp = fpin;
     if (pat->op != MUTT_BODY)
     {
       fseeko(fp, e->offset, SEEK_SET);
@@ -1106,8 +1108,6 @@ static bool msg_search(struct Context *ctx, struct Pattern *pat, int msgno)
 
   FREE(&buf);
 
-  mx_msg_close(ctx, &msg);
-
   if (ThoroughSearch)
   {
     mutt_file_fclose(&fp);
@@ -1120,6 +1120,665 @@ static bool msg_search(struct Context *ctx, struct Pattern *pat, int msgno)
   return match;
 }
 
+#if defined(USE_HCACHE) || defined(HAVE_PTHREAD)
+/**
+ * is_text_search - Does this Pattern search the text of a message
+ * @param pat Pattern to test
+ * @retval true It's a ~b, ~B or ~h test
+ */
+static bool is_text_search(const struct Pattern *pat)
+{
+  return (pat->op == MUTT_BODY) || (pat->op == MUTT_HEADER) || (pat->op == MUTT_WHOLE_MSG);
+}
+
+/**
+ * get_text_searches - Find all the text searches in a Pattern
+ * @param pat    Pattern list to search
+ * @param leaves Array of text searches
+ * @param num    Number of text searches found
+ */
+static void get_text_searches(struct Pattern *pat, struct Pattern ***leaves, int *num)
+{
+  for (; pat; pat = pat->next)
+  {
+    if (is_text_search(pat))
+    {
+      mutt_mem_realloc(leaves, (*num + 1) * sizeof(struct Pattern *));
+      (*leaves)[(*num)++] = pat;
+    }
+    get_text_searches(pat->child, leaves, num);
+  }
+}
+
+#endif
+
+#ifdef USE_HCACHE
+/**
+ * struct IndexFilter - Messages ruled out by the search index
+ *
+ * The text searches of a Pattern are looked up in the search index before
+ * any message is read.  msg_search() skips the messages that can't match.
+ */
+struct IndexFilter
+{
+  struct Context *ctx;     ///< Mailbox being searched
+  struct Pattern **leaves; ///< Text tests that were looked up
+  unsigned char **cands;   ///< Per test, per message: 1 if it may match
+  int num_leaves;          ///< Number of text tests
+  int msg_count;           ///< Number of messages in each cands array
+};
+
+static struct IndexFilter *ActiveFilter = NULL; /**< filter used by msg_search() */
+
+/**
+ * index_filter_free - Stop using the search index
+ * @param ptr Filter to free
+ */
+static void index_filter_free(struct IndexFilter **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  struct IndexFilter *f = *ptr;
+  if (ActiveFilter == f)
+    ActiveFilter = NULL;
+
+  for (int i = 0; i < f->num_leaves; i++)
+    FREE(&f->cands[i]);
+  FREE(&f->cands);
+  FREE(&f->leaves);
+  FREE(ptr);
+}
+
+/**
+ * pattern_text - Get the text that every match of a Pattern contains
+ * @param pat Pattern
+ * @retval ptr  Text
+ * @retval NULL No text is certain
+ */
+static const char *pattern_text(const struct Pattern *pat)
+{
+  if (pat->stringmatch)
+    return pat->p.str;
+  if (!pat->groupmatch && pat->p.regex && pat->p.regex->literal)
+    return pat->p.regex->literal->text;
+  return NULL;
+}
+
+/**
+ * index_filter_new - Look up the text searches of a Pattern in the index
+ * @param ctx Mailbox
+ * @param pat Compiled Pattern
+ * @retval ptr  Filter, now used by msg_search()
+ * @retval NULL No filter; if SigInt is set, the user interrupted the indexing
+ *
+ * Without $thorough_search, ~b and ~B read the raw body, which isn't indexed.
+ */
+static struct IndexFilter *index_filter_new(struct Context *ctx, struct Pattern *pat)
+{
+  if (!SearchIndex || ActiveFilter)
+    return NULL;
+
+  struct Pattern **leaves = NULL;
+  int num = 0;
+  get_text_searches(pat, &leaves, &num);
+
+  int usable = 0;
+  for (int i = 0; i < num; i++)
+    if (pattern_text(leaves[i]) && (ThoroughSearch || (leaves[i]->op == MUTT_HEADER)))
+      leaves[usable++] = leaves[i];
+
+  struct TextIndex *ti = NULL;
+  if (usable > 0)
+    ti = mutt_textindex_open(ctx);
+  if (!ti)
+  {
+    FREE(&leaves);
+    return NULL;
+  }
+
+  struct IndexFilter *f = mutt_mem_calloc(1, sizeof(struct IndexFilter));
+  f->ctx = ctx;
+  f->leaves = leaves;
+  f->num_leaves = usable;
+  f->msg_count = ctx->mailbox->msg_count;
+  f->cands = mutt_mem_calloc(usable, sizeof(unsigned char *));
+  for (int i = 0; i < usable; i++)
+    f->cands[i] = mutt_textindex_lookup(ti, pattern_text(leaves[i]), leaves[i]->op != MUTT_HEADER);
+
+  ActiveFilter = f;
+  return f;
+}
+
+/**
+ * index_filter_excludes - Has the search index ruled out a match
+ * @param ctx   Mailbox
+ * @param pat   Text search, e.g. ~b
+ * @param msgno Message number
+ * @retval true The Pattern can't match the message
+ */
+static bool index_filter_excludes(struct Context *ctx, struct Pattern *pat, int msgno)
+{
+  struct IndexFilter *f = ActiveFilter;
+  if (!f || (f->ctx != ctx) || (msgno >= f->msg_count))
+    return false;
+
+  for (int i = 0; i < f->num_leaves; i++)
+    if (f->leaves[i] == pat)
+      return f->cands[i] && !f->cands[i][msgno];
+
+  return false;
+}
+#endif
+
+#ifdef HAVE_PTHREAD
+/* Searching fewer messages than this isn't worth starting threads */
+#define SEARCH_MIN_JOBS 64
+
+/* Largest number of messages searched ahead by mutt_search_command() */
+#define SEARCH_MAX_BATCH 4096
+
+/**
+ * struct SearchWorker - A thread searching the text of messages
+ */
+struct SearchWorker
+{
+  struct SearchPool *pool; ///< Pool the thread belongs to
+  pthread_t thread;        ///< The thread
+  struct Pattern *pat;     ///< Private copy of the Pattern
+  struct Pattern **leaves; ///< Text tests in the copy, in the same order as the pool's
+  FILE *fp;                ///< Private handle on the mailbox (mbox, MMDF)
+};
+
+/**
+ * struct SearchPool - Search the text of messages on several threads
+ *
+ * The ~b, ~B and ~h tests of a Pattern are evaluated ahead of time, for many
+ * messages at once.  msg_search() then just looks up the result.
+ */
+struct SearchPool
+{
+  struct Context *ctx;      ///< Mailbox being searched
+  struct Pattern *pat;      ///< Pattern being evaluated
+  struct Pattern **leaves;  ///< Text tests in the Pattern
+  int num_leaves;           ///< Number of text tests
+  bool need_body;           ///< At least one test reads the body
+  unsigned char *results;   ///< Result per leaf, per message: 0 unknown, 1 false, 2 true
+  int msg_count;            ///< Number of messages in results
+  char *charset;            ///< Default charset, resolved before the threads start
+
+  struct Email **jobs;      ///< Messages to search
+  int max_jobs;             ///< Size of the jobs array
+  int num_jobs;             ///< Number of messages to search
+  int next;                 ///< Next message to hand to a thread
+  int done;                 ///< Number of messages searched
+  bool quit;                ///< Tell the threads to stop
+
+  pthread_mutex_t lock;     ///< Protects the jobs
+  pthread_cond_t work;      ///< Signalled when there are jobs
+  pthread_cond_t finished;  ///< Signalled when all the jobs are done
+
+  struct SearchWorker *workers; ///< Search threads
+  int num_workers;              ///< Number of threads running
+};
+
+static struct SearchPool *ActiveSearch = NULL; /**< search being run on threads */
+static log_dispatcher_t SearchLogger = NULL;   /**< logger in use before the search */
+static pthread_t SearchMainThread;             /**< thread that owns the screen */
+
+/**
+ * search_log_dispatch - Drop messages logged by the search threads
+ * @param stamp    Unix time (optional)
+ * @param file     Source file
+ * @param line     Source line
+ * @param function Source function
+ * @param level    Logging level, e.g. #LL_WARNING
+ * @param ...      Format string and parameters, like printf()
+ * @retval num Number of characters written
+ *
+ * The display and the log file belong to the main thread.  The decoders may
+ * report problems while a search thread is using them, so the messages are
+ * dropped.
+ */
+static int search_log_dispatch(time_t stamp, const char *file, int line,
+                               const char *function, int level, ...)
+{
+  if (!pthread_equal(pthread_self(), SearchMainThread))
+    return 0;
+
+  char buf[LONG_STRING];
+  va_list ap;
+  va_start(ap, level);
+  const char *fmt = va_arg(ap, const char *);
+  vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+
+  return SearchLogger(stamp, file, line, function, level, "%s", buf);
+}
+
+/**
+ * has_text_search - Does a Pattern contain any text searches
+ * @param pat Pattern to test (its siblings are ignored)
+ * @retval true The Pattern, or one of its children, is a text search
+ */
+static bool has_text_search(const struct Pattern *pat)
+{
+  if (is_text_search(pat))
+    return true;
+
+  for (const struct Pattern *c = pat->child; c; c = c->next)
+    if (has_text_search(c))
+      return true;
+
+  return false;
+}
+
+/**
+ * search_worker_email - Run the text searches on one email
+ * @param w Search thread
+ * @param e Email to search
+ */
+static void search_worker_email(struct SearchWorker *w, struct Email *e)
+{
+  struct SearchPool *sp = w->pool;
+  FILE *fp = w->fp;
+
+  if (!fp)
+  {
+    /* leave any failure to msg_search(), the file may have been renamed */
+    char path[PATH_MAX];
+    const int len = snprintf(path, sizeof(path), "%s/%s", sp->ctx->mailbox->path, e->path);
+    if ((len < 0) || (len >= (int) sizeof(path)))
+      return;
+    fp = fopen(path, "r");
+    if (!fp)
+      return;
+  }
+
+  for (int i = 0; i < sp->num_leaves; i++)
+  {
+    unsigned char *r = &sp->results[i * sp->msg_count + e->msgno];
+    *r = search_message(w->leaves[i], e, fp, sp->charset) ? 2 : 1;
+  }
+
+  if (fp != w->fp)
+    fclose(fp);
+}
+
+/**
+ * search_thread - Search messages until told to stop
+ * @param arg Search thread
+ * @retval NULL Always
+ */
+static void *search_thread(void *arg)
+{
+  struct SearchWorker *w = arg;
+  struct SearchPool *sp = w->pool;
+
+  pthread_mutex_lock(&sp->lock);
+  while (true)
+  {
+    while (!sp->quit && (sp->next >= sp->num_jobs))
+      pthread_cond_wait(&sp->work, &sp->lock);
+    if (sp->quit)
+      break;
+
+    struct Email *e = sp->jobs[sp->next++];
+    pthread_mutex_unlock(&sp->lock);
+
+    search_worker_email(w, e);
+
+    pthread_mutex_lock(&sp->lock);
+    sp->done++;
+    if (sp->done == sp->num_jobs)
+      pthread_cond_signal(&sp->finished);
+  }
+  pthread_mutex_unlock(&sp->lock);
+
+  return NULL;
+}
+
+/**
+ * search_pool_free - Stop the search threads and free the results
+ * @param sp Search pool to free
+ */
+static void search_pool_free(struct SearchPool **sp)
+{
+  if (!sp || !*sp)
+    return;
+
+  struct SearchPool *p = *sp;
+
+  pthread_mutex_lock(&p->lock);
+  p->quit = true;
+  pthread_cond_broadcast(&p->work);
+  pthread_mutex_unlock(&p->lock);
+
+  for (int i = 0; i < p->num_workers; i++)
+    pthread_join(p->workers[i].thread, NULL);
+
+  if (ActiveSearch == p)
+  {
+    MuttLogger = SearchLogger;
+    ActiveSearch = NULL;
+  }
+
+  pthread_cond_destroy(&p->finished);
+  pthread_cond_destroy(&p->work);
+  pthread_mutex_destroy(&p->lock);
+
+  /* The copies may outnumber the threads, if some failed to start */
+  for (int i = 0; p->workers && p->workers[i].pool; i++)
+  {
+    mutt_file_fclose(&p->workers[i].fp);
+    mutt_pattern_free(&p->workers[i].pat);
+    FREE(&p->workers[i].leaves);
+  }
+  FREE(&p->workers);
+  FREE(&p->jobs);
+  FREE(&p->results);
+  FREE(&p->leaves);
+  FREE(&p->charset);
+  FREE(sp);
+}
+
+/**
+ * search_pool_new - Start threads to search the text of messages
+ * @param ctx Mailbox
+ * @param pat Compiled Pattern
+ * @param str Pattern string that pat was compiled from
+ * @retval ptr  Search pool
+ * @retval NULL The Pattern, Mailbox or config doesn't allow a threaded search
+ *
+ * Only local mailboxes are searched this way.  Each thread gets its own copy
+ * of the Pattern, so that they don't share any regexes.
+ */
+static struct SearchPool *search_pool_new(struct Context *ctx, struct Pattern *pat, char *str)
+{
+  int threads = SearchThreads;
+  if (threads == 0)
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+  if ((threads < 2) || ActiveSearch)
+    return NULL;
+
+  const int magic = ctx->mailbox->magic;
+  if ((magic != MUTT_MBOX) && (magic != MUTT_MMDF) && (magic != MUTT_MAILDIR) &&
+      (magic != MUTT_MH))
+  {
+    return NULL;
+  }
+
+  struct SearchPool *sp = mutt_mem_calloc(1, sizeof(struct SearchPool));
+  sp->ctx = ctx;
+  sp->pat = pat;
+  get_text_searches(pat, &sp->leaves, &sp->num_leaves);
+  if (sp->num_leaves == 0)
+  {
+    FREE(&sp);
+    return NULL;
+  }
+
+  for (int i = 0; i < sp->num_leaves; i++)
+    if (sp->leaves[i]->op != MUTT_HEADER)
+      sp->need_body = true;
+
+  sp->msg_count = ctx->mailbox->msg_count;
+  sp->results = mutt_mem_calloc(sp->num_leaves * sp->msg_count, 1);
+  pthread_mutex_init(&sp->lock, NULL);
+  pthread_cond_init(&sp->work, NULL);
+  pthread_cond_init(&sp->finished, NULL);
+
+  /* One spare entry, with a NULL pool, marks the end */
+  sp->workers = mutt_mem_calloc(threads + 1, sizeof(struct SearchWorker));
+  struct Buffer err;
+  mutt_buffer_init(&err);
+  err.dsize = STRING;
+  err.data = mutt_mem_malloc(err.dsize);
+  for (int i = 0; i < threads; i++)
+  {
+    struct SearchWorker *w = &sp->workers[i];
+    w->pool = sp;
+    w->pat = mutt_pattern_comp(str, MUTT_FULL_MSG, &err);
+    int num = 0;
+    if (w->pat)
+      get_text_searches(w->pat, &w->leaves, &num);
+    if ((magic == MUTT_MBOX) || (magic == MUTT_MMDF))
+      w->fp = fopen(ctx->mailbox->path, "r");
+    if ((num != sp->num_leaves) || (((magic == MUTT_MBOX) || (magic == MUTT_MMDF)) && !w->fp))
+    {
+      FREE(&err.data);
+      search_pool_free(&sp);
+      return NULL;
+    }
+  }
+  FREE(&err.data);
+
+  /* Some helpers set up static data on first use; do that here, not in the
+   * threads.  rfc2047_decode() compiles a regex for encoded words. */
+  char *word = mutt_str_strdup("=?us-ascii?q?x?=");
+  rfc2047_decode(&word);
+  FREE(&word);
+  mutt_rand64();
+
+  /* mutt_ch_get_default_charset() returns a static buffer; the threads get a copy */
+  sp->charset = mutt_str_strdup(mutt_ch_get_default_charset());
+
+  SearchMainThread = pthread_self();
+  SearchLogger = MuttLogger;
+  MuttLogger = search_log_dispatch;
+  ActiveSearch = sp;
+
+  /* The threads inherit our signal mask; keep all signals for the main thread */
+  sigset_t all, old;
+  sigfillset(&all);
+  pthread_sigmask(SIG_SETMASK, &all, &old);
+
+  for (int i = 0; i < threads; i++)
+  {
+    if (pthread_create(&sp->workers[i].thread, NULL, search_thread, &sp->workers[i]) != 0)
+      break;
+    sp->num_workers++;
+  }
+
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+  if (sp->num_workers == 0)
+  {
+    search_pool_free(&sp);
+    return NULL;
+  }
+
+  mutt_debug(3, "searching with %d threads\n", sp->num_workers);
+  return sp;
+}
+
+/**
+ * search_pool_needs_text - Does the result for this Email depend on its text
+ * @param sp Search pool
+ * @param e  Email to test
+ * @retval true The text searches must be run
+ *
+ * If one of the cheap tests of the top-level AND fails, or one of the top-level
+ * OR succeeds, the text won't be searched by mutt_pattern_exec().
+ */
+static bool search_pool_needs_text(struct SearchPool *sp, struct Email *e)
+{
+  struct Pattern *pat = sp->pat;
+  if ((pat->op != MUTT_AND) && (pat->op != MUTT_OR))
+    return true;
+
+  const bool decider = (pat->op == MUTT_OR);
+  for (struct Pattern *c = pat->child; c; c = c->next)
+  {
+    if (has_text_search(c))
+      continue;
+    if ((mutt_pattern_exec(c, MUTT_MATCH_FULL_ADDRESS, sp->ctx, e, NULL) > 0) == decider)
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * search_pool_run - Search the text of some messages
+ * @param sp       Search pool
+ * @param emails   Emails to search
+ * @param num      Number of Emails
+ * @param progress Progress bar to update (optional)
+ * @param base     Progress already made
+ * @retval  0 Success, the results can be used by msg_search()
+ * @retval -1 The user interrupted the search
+ *
+ * Emails that need the main thread, e.g. encrypted ones, are skipped.  They'll
+ * be searched as usual, by msg_search().
+ */
+static int search_pool_run(struct SearchPool *sp, struct Email **emails, int num,
+                           struct Progress *progress, int base)
+{
+  if (num > sp->max_jobs)
+  {
+    sp->max_jobs = num;
+    mutt_mem_realloc(&sp->jobs, num * sizeof(struct Email *));
+  }
+
+  /* Parsing the MIME structure may need the mailbox, so it's done here */
+  int count = 0;
+  for (int i = 0; i < num; i++)
+  {
+    struct Email *e = emails[i];
+    if ((e->msgno >= sp->msg_count) || !search_pool_needs_text(sp, e))
+      continue;
+#ifdef USE_HCACHE
+    int excluded = 0;
+    for (int j = 0; j < sp->num_leaves; j++)
+      if (index_filter_excludes(sp->ctx, sp->leaves[j], e->msgno))
+        excluded++;
+    if (excluded == sp->num_leaves)
+      continue;
+#endif
+
+    if (ThoroughSearch && sp->need_body)
+    {
+      mutt_parse_mime_message(sp->ctx, e);
+      if ((WithCrypto != 0) && (e->security & ENCRYPT))
+        continue;
+      if (!mutt_can_decode_concurrently(e->content))
+        continue;
+    }
+    sp->jobs[count++] = e;
+  }
+
+  int rc = 0;
+  pthread_mutex_lock(&sp->lock);
+  sp->num_jobs = count;
+  sp->next = 0;
+  sp->done = 0;
+  pthread_cond_broadcast(&sp->work);
+
+  while (sp->done < sp->num_jobs)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 100 * 1000 * 1000;
+    if (ts.tv_nsec >= 1000000000)
+    {
+      ts.tv_sec++;
+      ts.tv_nsec -= 1000000000;
+    }
+    pthread_cond_timedwait(&sp->finished, &sp->lock, &ts);
+
+    if (SigInt == 1)
+    {
+      /* Hand out no more work, but wait for the threads to finish theirs */
+      sp->num_jobs = sp->next;
+      rc = -1;
+    }
+    else if (progress)
+    {
+      const int done = sp->done;
+      pthread_mutex_unlock(&sp->lock);
+      mutt_progress_update(progress, base + done, -1);
+      pthread_mutex_lock(&sp->lock);
+    }
+  }
+  pthread_mutex_unlock(&sp->lock);
+
+  return rc;
+}
+
+/**
+ * search_pool_result - Look up the result of a threaded text search
+ * @param ctx   Mailbox
+ * @param pat   Text search, e.g. ~b
+ * @param msgno Message number
+ * @retval  1 The Pattern matched
+ * @retval  0 The Pattern didn't match
+ * @retval -1 No result, the message must be searched
+ */
+static int search_pool_result(struct Context *ctx, struct Pattern *pat, int msgno)
+{
+  struct SearchPool *sp = ActiveSearch;
+  if (!sp || (sp->ctx != ctx) || (msgno >= sp->msg_count))
+    return -1;
+
+  for (int i = 0; i < sp->num_leaves; i++)
+  {
+    if (sp->leaves[i] == pat)
+    {
+      const unsigned char r = sp->results[i * sp->msg_count + msgno];
+      return r ? (r - 1) : -1;
+    }
+  }
+
+  return -1;
+}
+#endif
+
+/**
+ * msg_search - Search an email
+ * @param ctx   Mailbox
+ * @param pat   Pattern to find
+ * @param msgno Message to search
+ * @retval true Pattern found
+ * @retval false Error or pattern not found
+ */
+static bool msg_search(struct Context *ctx, struct Pattern *pat, int msgno)
+{
+#ifdef USE_HCACHE
+  if (index_filter_excludes(ctx, pat, msgno))
+    return false;
+#endif
+#ifdef HAVE_PTHREAD
+  int cached = search_pool_result(ctx, pat, msgno);
+  if (cached >= 0)
+    return cached;
+#endif
+
+  struct Message *msg = mx_msg_open(ctx, msgno);
+  if (!msg)
+  {
+    return false;
+  }
+
+  struct Email *e = ctx->mailbox->hdrs[msgno];
+
+  if (ThoroughSearch && (pat->op != MUTT_HEADER))
+  {
+    mutt_parse_mime_message(ctx, e);
+
+    if ((WithCrypto != 0) && (e->security & ENCRYPT) && !crypt_valid_passphrase(e->security))
+    {
+      mx_msg_close(ctx, &msg);
+      return false;
+    }
+  }
+
+  bool match = search_message(pat, e, msg->fp, NULL);
+
+  mx_msg_close(ctx, &msg);
+  return match;
+}
+
 // clang-format off
 /**
  * Flags - Lookup table for all patterns
@@ -1233,10 +1892,7 @@ void mutt_pattern_free(struct Pattern **pat)
     else if (tmp->groupmatch)
       tmp->p.g = NULL;
     else if (tmp->p.regex)
-    {
-      regfree(tmp->p.regex);
-      FREE(&tmp->p.regex);
-    }
+      mutt_regex_free(&tmp->p.regex);
 
     if (tmp->child)
       mutt_pattern_free(&tmp->child);
@@ -1253,6 +1909,204 @@ struct Pattern *mutt_pattern_new(void)
   return mutt_mem_calloc(1, sizeof(struct Pattern));
 }
 
+/**
+ * enum PatternCost - Rough cost of evaluating a Pattern against one Email
+ */
+enum PatternCost
+{
+  PAT_COST_FLAG = 1,      ///< Test a field of the Email, e.g. ~F, ~d, ~z
+  PAT_COST_ENVELOPE = 2,  ///< Match against the parsed envelope, e.g. ~f, ~s
+  PAT_COST_MIME = 50,     ///< Parse the MIME structure, e.g. ~X, ~M
+  PAT_COST_MESSAGE = 100, ///< Read the message from the mailbox, e.g. ~b, ~h
+  PAT_COST_THREAD = 10,   ///< Multiplier for patterns run across a thread
+  PAT_COST_MAX = 1000000,
+};
+
+/**
+ * pattern_cost - Estimate the cost of a single Pattern
+ * @param pat        Pattern
+ * @param child_cost Cost of the Pattern's children
+ * @retval num Relative cost
+ */
+static int pattern_cost(const struct Pattern *pat, int child_cost)
+{
+  switch (pat->op)
+  {
+    case MUTT_AND:
+    case MUTT_OR:
+      return child_cost;
+    case MUTT_THREAD:
+    case MUTT_PARENT:
+    case MUTT_CHILDREN:
+      return MIN(child_cost * PAT_COST_THREAD, PAT_COST_MAX);
+    case MUTT_BODY:
+    case MUTT_HEADER:
+    case MUTT_WHOLE_MSG:
+      return PAT_COST_MESSAGE;
+    case MUTT_MIMEATTACH:
+    case MUTT_MIMETYPE:
+      return PAT_COST_MIME;
+    case MUTT_SENDER:
+    case MUTT_FROM:
+    case MUTT_TO:
+    case MUTT_CC:
+    case MUTT_SUBJECT:
+    case MUTT_ID:
+    case MUTT_REFERENCE:
+    case MUTT_ADDRESS:
+    case MUTT_RECIPIENT:
+    case MUTT_LIST:
+    case MUTT_SUBSCRIBED_LIST:
+    case MUTT_PERSONAL_RECIP:
+    case MUTT_PERSONAL_FROM:
+    case MUTT_XLABEL:
+    case MUTT_DRIVER_TAGS:
+    case MUTT_HORMEL:
+    case MUTT_SERVERSEARCH:
+#ifdef USE_NNTP
+    case MUTT_NEWSGROUPS:
+#endif
+      return PAT_COST_ENVELOPE;
+    default:
+      return PAT_COST_FLAG;
+  }
+}
+
+/**
+ * pattern_set_const - Replace a Pattern with a constant
+ * @param pat   Pattern to replace
+ * @param value Value the Pattern always has
+ *
+ * Any children are freed.  The result is an "all" (~A) Pattern, negated if
+ * necessary.
+ */
+static void pattern_set_const(struct Pattern *pat, bool value)
+{
+  mutt_pattern_free(&pat->child);
+  pat->op = MUTT_ALL;
+  pat->not = !value;
+}
+
+/**
+ * pattern_optimise - Simplify and reorder a compiled Pattern
+ * @param pat Pattern to optimise (a single node, not a list)
+ * @retval num Estimated cost of evaluating the Pattern
+ *
+ * The children of AND and OR nodes can be evaluated in any order, so:
+ * - nested ANDs (or ORs) are merged into their parent
+ * - constant children (~A, !~A) are removed, or decide the result
+ * - a node with just one child is replaced by that child
+ * - the children are sorted so that the cheap tests run first
+ *
+ * The sort is stable, so tests of the same cost keep the order the user
+ * typed them.  This means that "~b foo ~F" will check the flag before
+ * reading the message.
+ */
+static int pattern_optimise(struct Pattern *pat)
+{
+  if ((pat->op != MUTT_AND) && (pat->op != MUTT_OR))
+  {
+    int child_cost = 0;
+    for (struct Pattern *c = pat->child; c; c = c->next)
+      child_cost = MIN(child_cost + pattern_optimise(c), PAT_COST_MAX);
+    return pattern_cost(pat, child_cost);
+  }
+
+  /* AND: true children can be dropped, a false one makes the node false.
+   * OR:  false children can be dropped, a true one makes the node true. */
+  const bool absorb = (pat->op == MUTT_OR);
+
+  struct PatternSort
+  {
+    int cost;
+    struct Pattern *pat;
+  } *sorted = NULL;
+  int count = 0;
+  int max = 0;
+  int total = 0;
+
+  struct Pattern *list = pat->child;
+  pat->child = NULL;
+
+  while (list)
+  {
+    struct Pattern *c = list;
+    list = list->next;
+    c->next = NULL;
+
+    if ((c->op == pat->op) && !c->not && c->child)
+    {
+      /* (A & B) & C == A & B & C */
+      struct Pattern *last = c->child;
+      while (last->next)
+        last = last->next;
+      last->next = list;
+      list = c->child;
+      c->child = NULL;
+      mutt_pattern_free(&c);
+      continue;
+    }
+
+    const int cost = pattern_optimise(c);
+    if (c->op == MUTT_ALL)
+    {
+      const bool value = !c->not;
+      mutt_pattern_free(&c);
+      if (value == absorb)
+      {
+        for (int i = 0; i < count; i++)
+          mutt_pattern_free(&sorted[i].pat);
+        FREE(&sorted);
+        mutt_pattern_free(&list);
+        pattern_set_const(pat, pat->not ^ absorb);
+        return PAT_COST_FLAG;
+      }
+      continue;
+    }
+
+    if (count == max)
+    {
+      max += 8;
+      mutt_mem_realloc(&sorted, max * sizeof(*sorted));
+    }
+
+    /* Insertion sort, keeping equal costs in their original order */
+    int i = count++;
+    for (; (i > 0) && (sorted[i - 1].cost > cost); i--)
+      sorted[i] = sorted[i - 1];
+    sorted[i].cost = cost;
+    sorted[i].pat = c;
+    total = MIN(total + cost, PAT_COST_MAX);
+  }
+
+  if (count == 0)
+  {
+    pattern_set_const(pat, pat->not ^ !absorb);
+    return PAT_COST_FLAG;
+  }
+
+  if (count == 1)
+  {
+    /* Replace the node with its only child */
+    struct Pattern *c = sorted[0].pat;
+    struct Pattern *next = pat->next;
+    const bool not = pat->not;
+    FREE(&sorted);
+    *pat = *c;
+    pat->next = next;
+    pat->not ^= not;
+    FREE(&c);
+    return total;
+  }
+
+  for (int i = 0; i < (count - 1); i++)
+    sorted[i].pat->next = sorted[i + 1].pat;
+  pat->child = sorted[0].pat;
+  FREE(&sorted);
+
+  return pattern_cost(pat, total);
+}
+
 /**
  * mutt_pattern_comp - Create a Pattern
  * @param s     Pattern string
@@ -1490,6 +2344,7 @@ struct Pattern *mutt_pattern_comp(/* const */ char *s, int flags, struct Buffer
     tmp->child = curlist;
     curlist = tmp;
   }
+  pattern_optimise(curlist);
   return curlist;
 }
 
@@ -2220,6 +3075,12 @@ int mutt_pattern_func(int op, char *prompt)
   struct Buffer err;
   int rc = -1, padding;
   struct Progress progress;
+#ifdef USE_HCACHE
+  struct IndexFilter *filter = NULL;
+#endif
+#ifdef HAVE_PTHREAD
+  struct SearchPool *sp = NULL;
+#endif
 
   mutt_str_strfcpy(buf, Context->pattern, sizeof(buf));
   if (prompt || op != MUTT_LIMIT)
@@ -2246,11 +3107,48 @@ int mutt_pattern_func(int op, char *prompt)
     goto bail;
 #endif
 
+#ifdef USE_HCACHE
+  filter = index_filter_new(Context, pat);
+  if (!filter && (SigInt == 1))
+  {
+    mutt_error(_("Search interrupted"));
+    SigInt = 0;
+    goto bail;
+  }
+#endif
+
   mutt_progress_init(&progress, _("Executing command on matching messages..."),
                      MUTT_PROGRESS_MSG, ReadInc,
                      (op == MUTT_LIMIT) ? Context->mailbox->msg_count :
                                           Context->mailbox->vcount);
 
+#ifdef HAVE_PTHREAD
+  const int count = (op == MUTT_LIMIT) ? Context->mailbox->msg_count :
+                                         Context->mailbox->vcount;
+  if (count >= SEARCH_MIN_JOBS)
+    sp = search_pool_new(Context, pat, buf);
+  if (sp)
+  {
+    struct Email **emails = Context->mailbox->hdrs;
+    if (op != MUTT_LIMIT)
+    {
+      emails = mutt_mem_calloc(count, sizeof(struct Email *));
+      for (int i = 0; i < count; i++)
+        emails[i] = Context->mailbox->hdrs[Context->mailbox->v2r[i]];
+    }
+
+    int rc2 = search_pool_run(sp, emails, count, &progress, 0);
+    if (emails != Context->mailbox->hdrs)
+      FREE(&emails);
+    if (rc2 < 0)
+    {
+      mutt_error(_("Search interrupted"));
+      SigInt = 0;
+      goto bail;
+    }
+  }
+#endif
+
   if (op == MUTT_LIMIT)
   {
     Context->mailbox->vcount = 0;
@@ -2333,6 +3231,12 @@ int mutt_pattern_func(int op, char *prompt)
   rc = 0;
 
 bail:
+#ifdef HAVE_PTHREAD
+  search_pool_free(&sp);
+#endif
+#ifdef USE_HCACHE
+  index_filter_free(&filter);
+#endif
   FREE(&simple);
   mutt_pattern_free(&pat);
   FREE(&err.data);
@@ -2391,8 +3295,10 @@ int mutt_search_command(int cur, int op)
         mutt_error("%s", err.data);
         FREE(&err.data);
         LastSearch[0] = '\0';
+        LastSearchExpn[0] = '\0';
         return -1;
       }
+      mutt_str_strfcpy(LastSearchExpn, temp, sizeof(LastSearchExpn));
       FREE(&err.data);
       mutt_clear_error();
     }
@@ -2414,9 +3320,31 @@ int mutt_search_command(int cur, int op)
   if (op == OP_SEARCH_OPPOSITE)
     incr = -incr;
 
+  int rc = -1;
+#ifdef USE_HCACHE
+  struct IndexFilter *filter = index_filter_new(Context, SearchPattern);
+  if (!filter && (SigInt == 1))
+  {
+    mutt_error(_("Search interrupted"));
+    SigInt = 0;
+    return -1;
+  }
+#endif
+
   mutt_progress_init(&progress, _("Searching..."), MUTT_PROGRESS_MSG, ReadInc,
                      Context->mailbox->vcount);
 
+#ifdef HAVE_PTHREAD
+  struct SearchPool *sp = NULL;
+  struct Email **batch = NULL;
+  int batch_size = SEARCH_MIN_JOBS;
+  int batch_end = 0;
+  if (Context->mailbox->vcount >= SEARCH_MIN_JOBS)
+    sp = search_pool_new(Context, SearchPattern, LastSearchExpn);
+  if (sp)
+    batch = mutt_mem_calloc(SEARCH_MAX_BATCH, sizeof(struct Email *));
+#endif
+
   for (int i = cur + incr, j = 0; j != Context->mailbox->vcount; j++)
   {
     const char *msg = NULL;
@@ -2429,7 +3357,7 @@ int mutt_search_command(int cur, int op)
       else
       {
         mutt_message(_("Search hit bottom without finding match"));
-        return -1;
+        goto done;
       }
     }
     else if (i < 0)
@@ -2440,10 +3368,42 @@ int mutt_search_command(int cur, int op)
       else
       {
         mutt_message(_("Search hit top without finding match"));
-        return -1;
+        goto done;
       }
     }
 
+#ifdef HAVE_PTHREAD
+    if (sp && (j == batch_end))
+    {
+      /* Search the text of the next few messages, in the order they'll be
+       * tested.  Each batch is larger than the last. */
+      const int vcount = Context->mailbox->vcount;
+      int num = 0;
+      int k = 0;
+      for (; (k < batch_size) && ((j + k) < vcount); k++)
+      {
+        int idx = i + (k * incr);
+        if (WrapSearch)
+          idx = ((idx % vcount) + vcount) % vcount;
+        else if ((idx < 0) || (idx >= vcount))
+          break;
+
+        struct Email *e = Context->mailbox->hdrs[Context->mailbox->v2r[idx]];
+        if (!e->searched)
+          batch[num++] = e;
+      }
+      batch_end = j + MAX(k, 1);
+      batch_size = MIN(batch_size * 2, SEARCH_MAX_BATCH);
+
+      if (search_pool_run(sp, batch, num, &progress, j) < 0)
+      {
+        mutt_error(_("Search interrupted"));
+        SigInt = 0;
+        goto done;
+      }
+    }
+#endif
+
     struct Email *e = Context->mailbox->hdrs[Context->mailbox->v2r[i]];
     if (e->searched)
     {
@@ -2453,7 +3413,8 @@ int mutt_search_command(int cur, int op)
         mutt_clear_error();
         if (msg && *msg)
           mutt_message(msg);
-        return i;
+        rc = i;
+        goto done;
       }
     }
     else
@@ -2467,7 +3428,8 @@ int mutt_search_command(int cur, int op)
         mutt_clear_error();
         if (msg && *msg)
           mutt_message(msg);
-        return i;
+        rc = i;
+        goto done;
       }
     }
 
@@ -2475,12 +3437,21 @@ int mutt_search_command(int cur, int op)
     {
       mutt_error(_("Search interrupted"));
       SigInt = 0;
-      return -1;
+      goto done;
     }
 
     i += incr;
   }
 
   mutt_error(_("Not found"));
-  return -1;
+
+done:
+#ifdef HAVE_PTHREAD
+  search_pool_free(&sp);
+  FREE(&batch);
+#endif
+#ifdef USE_HCACHE
+  index_filter_free(&filter);
+#endif
+  return rc;
 }
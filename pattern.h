@@ -31,8 +31,10 @@ struct Address;
 struct Buffer;
 struct Email;
 struct Context;
+struct Regex;
 
 /* These Config Variables are only used in pattern.c */
+extern short SearchThreads;
 extern bool ThoroughSearch;
 
 /* flag to mutt_pattern_comp() */
@@ -55,7 +57,7 @@ struct Pattern
   struct Pattern *next;
   struct Pattern *child; /**< arguments to logical op */
   union {
-    regex_t *regex;
+    struct Regex *regex;
     struct Group *g;
     char *str;
   } p;
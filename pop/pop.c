@@ -1066,14 +1066,10 @@ static int pop_msg_open(struct Context *ctx, struct Message *msg, int msgno)
   /* Detach the private data */
   e->data = NULL;
 
-  /* we replace envelope, key in subj_hash has to be updated as well */
-  if (ctx->mailbox->subj_hash && e->env->real_subj)
-    mutt_hash_delete(ctx->mailbox->subj_hash, e->env->real_subj, e);
+  /* we replace envelope, key in label_hash has to be updated as well */
   mutt_label_hash_remove(ctx->mailbox, e);
   mutt_env_free(&e->env);
   e->env = mutt_rfc822_read_header(msg->fp, e, false, false);
-  if (ctx->mailbox->subj_hash && e->env->real_subj)
-    mutt_hash_insert(ctx->mailbox->subj_hash, e->env->real_subj, e);
   mutt_label_hash_add(ctx->mailbox, e);
 
   /* Reattach the private data */
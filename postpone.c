@@ -586,7 +586,7 @@ int mutt_prepare_template(FILE *fp, struct Context *ctx, struct Email *newhdr,
   if (resend)
   {
     FREE(&newhdr->env->message_id);
-    FREE(&newhdr->env->mail_followup_to);
+    mutt_addr_free(&newhdr->env->mail_followup_to);
   }
 
   /* decrypt pgp/mime encoded messages */
@@ -202,23 +202,23 @@ static struct Query *run_query(char *s, int quiet)
  *
  * Try to match various Address fields.
  */
-static int query_search(struct Menu *menu, regex_t *rx, int line)
+static int query_search(struct Menu *menu, struct Regex *rx, int line)
 {
   struct Entry *table = menu->data;
 
-  if (table[line].data->name && !regexec(rx, table[line].data->name, 0, NULL, 0))
+  if (table[line].data->name && !mutt_regex_exec(rx, table[line].data->name, 0, NULL, 0))
     return 0;
-  if (table[line].data->other && !regexec(rx, table[line].data->other, 0, NULL, 0))
+  if (table[line].data->other && !mutt_regex_exec(rx, table[line].data->other, 0, NULL, 0))
     return 0;
   if (table[line].data->addr)
   {
     if (table[line].data->addr->personal &&
-        !regexec(rx, table[line].data->addr->personal, 0, NULL, 0))
+        !mutt_regex_exec(rx, table[line].data->addr->personal, 0, NULL, 0))
     {
       return 0;
     }
     if (table[line].data->addr->mailbox &&
-        !regexec(rx, table[line].data->addr->mailbox, 0, NULL, 0))
+        !mutt_regex_exec(rx, table[line].data->addr->mailbox, 0, NULL, 0))
     {
       return 0;
     }
@@ -29,6 +29,7 @@
 #include "mutt.h"
 #include "score.h"
 #include "context.h"
+#include "curs_main.h"
 #include "globals.h"
 #include "keymap.h"
 #include "mailbox.h"
@@ -79,7 +80,7 @@ void mutt_check_rescore(struct Context *ctx)
     for (int i = 0; ctx && i < ctx->mailbox->msg_count; i++)
     {
       mutt_score_message(ctx, ctx->mailbox->hdrs[i], true);
-      ctx->mailbox->hdrs[i]->pair = 0;
+      mutt_reset_header_color(ctx->mailbox->hdrs[i]);
     }
   }
   OptNeedRescore = false;
@@ -1126,7 +1126,8 @@ int mutt_lookup_mime_type(struct Body *att, const char *path)
         SKIPWS(p);
 
         /* cycle through the file extensions */
-        while ((p = strtok(p, " \t\n")))
+        char *save = NULL;
+        while ((p = strtok_r(p, " \t\n", &save)))
         {
           sze = mutt_str_strlen(p);
           if ((sze > cur_sze) && (szf >= sze) &&
@@ -21,6 +21,7 @@
  */
 
 #include "config.h"
+#include <ctype.h>
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
@@ -46,6 +47,86 @@ bool ReverseAlias; ///< Config: Display the alias in the index, rather than the
 /* function to use as discriminator when normal sort method is equal */
 static sort_t *AuxSort = NULL;
 
+/**
+ * struct EmailSortKey - An email and its precomputed sort keys
+ *
+ * mutt_sort_headers() sorts an array of these, rather than the emails.  The
+ * email comes first, so the sort functions can still treat an element as a
+ * `struct Email **`.
+ */
+struct EmailSortKey
+{
+  struct Email *email; ///< Email, must be first
+  char *text[2];       ///< Folded text for $sort and $sort_aux, if they compare text
+  bool made[2];        ///< true once the text has been made
+};
+
+/* true while sorting an array of EmailSortKey */
+static bool SortByKey = false;
+
+/**
+ * make_sort_text - Get the text an email is sorted by
+ * @param e      Email
+ * @param method Sort method, e.g. #SORT_FROM
+ * @retval ptr  Folded text, which the caller must free
+ * @retval NULL The method doesn't compare text, or the text is empty
+ *
+ * The text is lower-cased, so strcmp() orders it like strcasecmp().
+ */
+static char *make_sort_text(struct Email *e, int method)
+{
+  char buf[SHORT_STRING];
+  const char *text = NULL;
+
+  switch (method & SORT_MASK)
+  {
+    case SORT_FROM:
+      mutt_str_strfcpy(buf, mutt_get_name(e->env->from), sizeof(buf));
+      text = buf;
+      break;
+    case SORT_LABEL:
+      if (e->env && e->env->x_label && *e->env->x_label)
+        text = e->env->x_label;
+      break;
+    case SORT_SUBJECT:
+      text = e->env->real_subj;
+      break;
+    case SORT_TO:
+      mutt_str_strfcpy(buf, mutt_get_name(e->env->to), sizeof(buf));
+      text = buf;
+      break;
+  }
+
+  if (!text)
+    return NULL;
+
+  char *key = mutt_str_strdup(text);
+  for (char *p = key; p && *p; p++)
+    *p = tolower((unsigned char) *p);
+  return key;
+}
+
+/**
+ * sort_key_text - Get the text of an email's sort key
+ * @param a Email's sort key
+ * @retval ptr Folded text for the sort method in use
+ *
+ * The text is made the first time it's needed, so the keys for $sort_aux are
+ * only made for emails that $sort can't tell apart.
+ */
+static const char *sort_key_text(const void *a)
+{
+  struct EmailSortKey *key = (struct EmailSortKey *) a;
+  const int i = OptAuxSort ? 1 : 0;
+
+  if (!key->made[i])
+  {
+    key->text[i] = make_sort_text(key->email, i ? SortAux : Sort);
+    key->made[i] = true;
+  }
+  return NONULL(key->text[i]);
+}
+
 /**
  * perform_auxsort - Compare two emails using the auxilliary sort method
  * @param retval Result of normal sort method
@@ -128,6 +209,8 @@ static int compare_subject(const void *a, const void *b)
   }
   else if (!(*pb)->env->real_subj)
     rc = 1;
+  else if (SortByKey)
+    rc = strcmp(sort_key_text(a), sort_key_text(b));
   else
     rc = mutt_str_strcasecmp((*pa)->env->real_subj, (*pb)->env->real_subj);
   rc = perform_auxsort(rc, a, b);
@@ -168,11 +251,17 @@ static int compare_to(const void *a, const void *b)
 {
   struct Email **ppa = (struct Email **) a;
   struct Email **ppb = (struct Email **) b;
-  char fa[SHORT_STRING];
+  int result;
 
-  mutt_str_strfcpy(fa, mutt_get_name((*ppa)->env->to), SHORT_STRING);
-  const char *fb = mutt_get_name((*ppb)->env->to);
-  int result = mutt_str_strncasecmp(fa, fb, SHORT_STRING);
+  if (SortByKey)
+    result = strcmp(sort_key_text(a), sort_key_text(b));
+  else
+  {
+    char fa[SHORT_STRING];
+    mutt_str_strfcpy(fa, mutt_get_name((*ppa)->env->to), SHORT_STRING);
+    const char *fb = mutt_get_name((*ppb)->env->to);
+    result = mutt_str_strncasecmp(fa, fb, SHORT_STRING);
+  }
   result = perform_auxsort(result, a, b);
   return SORTCODE(result);
 }
@@ -184,11 +273,17 @@ static int compare_from(const void *a, const void *b)
 {
   struct Email **ppa = (struct Email **) a;
   struct Email **ppb = (struct Email **) b;
-  char fa[SHORT_STRING];
+  int result;
 
-  mutt_str_strfcpy(fa, mutt_get_name((*ppa)->env->from), SHORT_STRING);
-  const char *fb = mutt_get_name((*ppb)->env->from);
-  int result = mutt_str_strncasecmp(fa, fb, SHORT_STRING);
+  if (SortByKey)
+    result = strcmp(sort_key_text(a), sort_key_text(b));
+  else
+  {
+    char fa[SHORT_STRING];
+    mutt_str_strfcpy(fa, mutt_get_name((*ppa)->env->from), SHORT_STRING);
+    const char *fb = mutt_get_name((*ppb)->env->from);
+    result = mutt_str_strncasecmp(fa, fb, SHORT_STRING);
+  }
   result = perform_auxsort(result, a, b);
   return SORTCODE(result);
 }
@@ -302,7 +397,10 @@ static int compare_label(const void *a, const void *b)
   }
 
   /* If both have a label, we just do a lexical compare. */
-  result = mutt_str_strcasecmp((*ppa)->env->x_label, (*ppb)->env->x_label);
+  if (SortByKey)
+    result = strcmp(sort_key_text(a), sort_key_text(b));
+  else
+    result = mutt_str_strcasecmp((*ppa)->env->x_label, (*ppb)->env->x_label);
   return SORTCODE(result);
 }
 
@@ -346,6 +444,73 @@ sort_t *mutt_get_sort_func(int method)
   /* not reached */
 }
 
+/**
+ * merge_sort - Sort some emails, keeping equal ones in order
+ * @param keys Emails to sort
+ * @param tmp  Scratch space, for at least half of the emails
+ * @param num  Number of emails
+ * @param cmp  Sort function
+ */
+static void merge_sort(struct EmailSortKey *keys, struct EmailSortKey *tmp,
+                       size_t num, sort_t *cmp)
+{
+  if (num < 2)
+    return;
+
+  const size_t half = num / 2;
+  merge_sort(keys, tmp, half, cmp);
+  merge_sort(keys + half, tmp, num - half, cmp);
+
+  /* the halves are often in order already, e.g. after new mail */
+  if (cmp(&keys[half - 1], &keys[half]) <= 0)
+    return;
+
+  memcpy(tmp, keys, half * sizeof(struct EmailSortKey));
+  size_t i = 0, j = half, k = 0;
+  while ((i < half) && (j < num))
+  {
+    if (cmp(&keys[j], &tmp[i]) < 0)
+      keys[k++] = keys[j++];
+    else
+      keys[k++] = tmp[i++];
+  }
+  while (i < half)
+    keys[k++] = tmp[i++];
+}
+
+/**
+ * sort_by_key - Sort the emails, using precomputed sort keys
+ * @param ctx      Mailbox
+ * @param sortfunc Sort function for $sort
+ *
+ * Sorting by name or subject used to look up the names, or fold the case of
+ * the text, in every comparison.  Now it's done at most once per email.
+ */
+static void sort_by_key(struct Context *ctx, sort_t *sortfunc)
+{
+  struct Mailbox *m = ctx->mailbox;
+  struct EmailSortKey *keys = mutt_mem_calloc(m->msg_count, sizeof(struct EmailSortKey));
+  struct EmailSortKey *tmp =
+      mutt_mem_calloc(m->msg_count / 2 + 1, sizeof(struct EmailSortKey));
+
+  for (int i = 0; i < m->msg_count; i++)
+    keys[i].email = m->hdrs[i];
+
+  SortByKey = true;
+  merge_sort(keys, tmp, m->msg_count, sortfunc);
+  SortByKey = false;
+
+  for (int i = 0; i < m->msg_count; i++)
+  {
+    m->hdrs[i] = keys[i].email;
+    FREE(&keys[i].text[0]);
+    FREE(&keys[i].text[1]);
+  }
+
+  FREE(&tmp);
+  FREE(&keys);
+}
+
 /**
  * mutt_sort_headers - Sort emails by their headers
  * @param ctx  Mailbox
@@ -415,8 +580,7 @@ void mutt_sort_headers(struct Context *ctx, bool init)
     return;
   }
   else
-    qsort((void *) ctx->mailbox->hdrs, ctx->mailbox->msg_count,
-          sizeof(struct Email *), sortfunc);
+    sort_by_key(ctx, sortfunc);
 
   /* adjust the virtual message numbers */
   ctx->mailbox->vcount = 0;
@@ -34,6 +34,7 @@ struct State
   FILE *fpout;
   char *prefix;
   int flags;
+  const char *charset; /**< Charset of parts that don't name one, NULL for mutt_ch_get_default_charset() */
 };
 
 /* flags for the State struct */
@@ -0,0 +1,119 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "config.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "mutt/file.h"
+#include "mutt/memory.h"
+
+#define TEST_FILE_SIZE (256 * 1024 + 17)
+
+static FILE *make_source(char *data, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+    data[i] = 'a' + (i * 7) % 26;
+
+  FILE *fp = tmpfile();
+  if (!fp)
+    return NULL;
+  fwrite(data, 1, len, fp);
+  rewind(fp);
+  return fp;
+}
+
+static bool check_contents(FILE *fp, const char *expected, size_t len)
+{
+  char *buf = mutt_mem_malloc(len + 1);
+  rewind(fp);
+  size_t got = fread(buf, 1, len + 1, fp);
+  bool rc = (got == len) && (memcmp(buf, expected, len) == 0);
+  if (!rc)
+    TEST_MSG("Expected %zu bytes, got %zu", len, got);
+  FREE(&buf);
+  return rc;
+}
+
+void test_file_copy_bytes(void)
+{
+  char *data = mutt_mem_malloc(TEST_FILE_SIZE);
+  FILE *in = make_source(data, TEST_FILE_SIZE);
+  FILE *out = tmpfile();
+  if (!TEST_CHECK(in && out))
+    return;
+
+  /* Copy from the middle of one file onto the end of existing data */
+  fputs("header\n", out);
+  fseek(in, 100, SEEK_SET);
+  TEST_CHECK(mutt_file_copy_bytes(in, out, 200000) == 0);
+  TEST_CHECK(ftell(in) == 200100);
+  TEST_CHECK(ftell(out) == 200007);
+
+  /* The stream must be usable where the copy left off */
+  TEST_CHECK(fgetc(in) == data[200100]);
+  fputs("trailer\n", out);
+
+  char *expected = mutt_mem_malloc(200015);
+  memcpy(expected, "header\n", 7);
+  memcpy(expected + 7, data + 100, 200000);
+  memcpy(expected + 200007, "trailer\n", 8);
+  TEST_CHECK(check_contents(out, expected, 200015));
+  FREE(&expected);
+
+  /* Asking for more than there is copies up to the end of the file */
+  FILE *out2 = tmpfile();
+  rewind(in);
+  TEST_CHECK(mutt_file_copy_bytes(in, out2, TEST_FILE_SIZE + 1000) == 0);
+  TEST_CHECK(check_contents(out2, data, TEST_FILE_SIZE));
+
+  mutt_file_fclose(&out2);
+  mutt_file_fclose(&out);
+  mutt_file_fclose(&in);
+  FREE(&data);
+}
+
+void test_file_copy_stream(void)
+{
+  char *data = mutt_mem_malloc(TEST_FILE_SIZE);
+  FILE *in = make_source(data, TEST_FILE_SIZE);
+  if (!TEST_CHECK(in != NULL))
+    return;
+
+  /* Regular file to a file opened for appending */
+  char path[] = "/tmp/neomutt-test-XXXXXX";
+  int fd = mkstemp(path);
+  if (!TEST_CHECK(fd >= 0))
+    return;
+  close(fd);
+  FILE *out = fopen(path, "a+");
+  fputs("From \n", out);
+  fflush(out);
+  TEST_CHECK(mutt_file_copy_stream(in, out) == 0);
+  fputs("end\n", out);
+  fflush(out);
+
+  char *expected = mutt_mem_malloc(TEST_FILE_SIZE + 10);
+  memcpy(expected, "From \n", 6);
+  memcpy(expected + 6, data, TEST_FILE_SIZE);
+  memcpy(expected + 6 + TEST_FILE_SIZE, "end\n", 4);
+  TEST_CHECK(check_contents(out, expected, TEST_FILE_SIZE + 10));
+  FREE(&expected);
+  mutt_file_fclose(&out);
+  unlink(path);
+
+  /* A non-file destination falls back to stdio */
+  char *mem = NULL;
+  size_t memlen = 0;
+  out = open_memstream(&mem, &memlen);
+  rewind(in);
+  TEST_CHECK(mutt_file_copy_stream(in, out) == 0);
+  TEST_CHECK((memlen == TEST_FILE_SIZE) && (memcmp(mem, data, memlen) == 0));
+  mutt_file_fclose(&out);
+  FREE(&mem);
+
+  mutt_file_fclose(&in);
+  FREE(&data);
+}
@@ -0,0 +1,102 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include <stdio.h>
+#include "mutt/hash.h"
+#include "mutt/memory.h"
+#include "mutt/string2.h"
+
+void test_hash_grow(void)
+{
+  struct Hash *table = mutt_hash_create(4, MUTT_HASH_STRDUP_KEYS);
+  struct HashElem *first = NULL;
+  char key[32];
+
+  for (int i = 0; i < 5000; i++)
+  {
+    snprintf(key, sizeof(key), "key%d", i);
+    struct HashElem *he = mutt_hash_insert(table, key, (void *) (intptr_t) (i + 1));
+    TEST_CHECK(he != NULL);
+    if (i == 0)
+      first = he;
+  }
+
+  /* The table has grown, but the elements haven't moved */
+  TEST_CHECK(table->nelem >= 5000);
+  TEST_CHECK(table->count == 5000);
+  TEST_CHECK(mutt_hash_find_elem(table, "key0") == first);
+
+  for (int i = 0; i < 5000; i++)
+  {
+    snprintf(key, sizeof(key), "key%d", i);
+    if (!TEST_CHECK(mutt_hash_find(table, key) == (void *) (intptr_t) (i + 1)))
+      TEST_MSG("Key: %s", key);
+  }
+
+  TEST_CHECK(mutt_hash_insert(table, "key42", NULL) == NULL);
+  TEST_CHECK(mutt_hash_find(table, "key5000") == NULL);
+
+  for (int i = 0; i < 5000; i += 2)
+  {
+    snprintf(key, sizeof(key), "key%d", i);
+    mutt_hash_delete(table, key, NULL);
+  }
+  TEST_CHECK(table->count == 2500);
+  TEST_CHECK(mutt_hash_find(table, "key42") == NULL);
+  TEST_CHECK(mutt_hash_find(table, "key43") == (void *) (intptr_t) 44);
+
+  mutt_hash_destroy(&table);
+  TEST_CHECK(table == NULL);
+}
+
+void test_hash_dups(void)
+{
+  struct Hash *table = mutt_hash_create(2, MUTT_HASH_ALLOW_DUPS);
+  static int data[100];
+
+  for (int i = 0; i < 100; i++)
+    mutt_hash_insert(table, (i % 2) ? "odd" : "even", &data[i]);
+
+  /* The newest duplicate is found first, even after growing */
+  TEST_CHECK(mutt_hash_find(table, "even") == &data[98]);
+  TEST_CHECK(mutt_hash_find(table, "odd") == &data[99]);
+
+  int count = 0;
+  for (struct HashElem *he = mutt_hash_find_bucket(table, "odd"); he; he = he->next)
+    if (he->data && (mutt_str_strcmp(he->key.strkey, "odd") == 0))
+      count++;
+  TEST_CHECK(count == 50);
+
+  mutt_hash_delete(table, "odd", &data[99]);
+  TEST_CHECK(mutt_hash_find(table, "odd") == &data[97]);
+  mutt_hash_delete(table, "odd", NULL);
+  TEST_CHECK(mutt_hash_find(table, "odd") == NULL);
+  TEST_CHECK(table->count == 50);
+
+  mutt_hash_destroy(&table);
+}
+
+void test_hash_walk(void)
+{
+  struct Hash *table = mutt_hash_int_create(0, 0);
+  static bool seen[1000];
+
+  for (unsigned int i = 0; i < 1000; i++)
+    TEST_CHECK(mutt_hash_int_insert(table, i, &seen[i]) != NULL);
+  TEST_CHECK(mutt_hash_int_find(table, 999) == &seen[999]);
+  TEST_CHECK(mutt_hash_int_insert(table, 5, NULL) == NULL);
+
+  struct HashWalkState state = { 0 };
+  struct HashElem *he = NULL;
+  int count = 0;
+  while ((he = mutt_hash_walk(table, &state)))
+  {
+    TEST_CHECK(he->data == &seen[he->key.intkey]);
+    TEST_CHECK(!seen[he->key.intkey]);
+    seen[he->key.intkey] = true;
+    count++;
+  }
+  TEST_CHECK(count == 1000);
+
+  mutt_hash_destroy(&table);
+}
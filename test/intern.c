@@ -0,0 +1,53 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "config.h"
+#include <stdbool.h>
+#include "mutt/intern.h"
+#include "mutt/memory.h"
+#include "mutt/string2.h"
+
+void test_intern(void)
+{
+  char *a = mutt_intern_add("user@example.com");
+  char *b = mutt_intern_add("user@example.com");
+  char *c = mutt_intern_add("other@example.com");
+  TEST_CHECK(a && (a == b));
+  TEST_CHECK(c && (c != a));
+  TEST_CHECK(mutt_str_strcmp(a, "user@example.com") == 0);
+  TEST_CHECK(mutt_intern_add(NULL) == NULL);
+
+  /* An equal, but private, string isn't shared */
+  char *d = mutt_str_strdup("user@example.com");
+  TEST_CHECK(mutt_intern_is_shared(a));
+  TEST_CHECK(!mutt_intern_is_shared(d));
+  mutt_intern_free(&d);
+  TEST_CHECK(!d);
+
+  /* The string lives until its last reference is dropped */
+  mutt_intern_free(&a);
+  TEST_CHECK(!a);
+  TEST_CHECK(mutt_intern_is_shared(b));
+  TEST_CHECK(mutt_str_strcmp(b, "user@example.com") == 0);
+
+  /* Unsharing gives a private copy, and drops the shared one */
+  char *e = mutt_intern_add(c);
+  TEST_CHECK(e == c);
+  mutt_intern_unshare(&e);
+  TEST_CHECK(e && (e != c) && !mutt_intern_is_shared(e));
+  TEST_CHECK(mutt_str_strcmp(e, "other@example.com") == 0);
+  e[0] = 'O';
+  TEST_CHECK(mutt_str_strcmp(c, "other@example.com") == 0);
+  FREE(&e);
+
+  /* Unsharing a private string does nothing */
+  char *f = mutt_str_strdup("private");
+  char *g = f;
+  mutt_intern_unshare(&f);
+  TEST_CHECK(f == g);
+  mutt_intern_free(&f);
+
+  mutt_intern_free(&b);
+  mutt_intern_free(&c);
+  TEST_CHECK(!b && !c);
+}
@@ -11,13 +11,25 @@
   NEOMUTT_TEST_ITEM(test_md5)                                                  \
   NEOMUTT_TEST_ITEM(test_md5_ctx)                                              \
   NEOMUTT_TEST_ITEM(test_md5_ctx_bytes)                                        \
+  NEOMUTT_TEST_ITEM(test_file_copy_bytes)                                      \
+  NEOMUTT_TEST_ITEM(test_file_copy_stream)                                     \
+  NEOMUTT_TEST_ITEM(test_hash_grow)                                            \
+  NEOMUTT_TEST_ITEM(test_hash_dups)                                            \
+  NEOMUTT_TEST_ITEM(test_hash_walk)                                            \
+  NEOMUTT_TEST_ITEM(test_intern)                                               \
+  NEOMUTT_TEST_ITEM(test_slab)                                                 \
   NEOMUTT_TEST_ITEM(test_string_strfcpy)                                       \
   NEOMUTT_TEST_ITEM(test_string_strnfcpy)                                      \
   NEOMUTT_TEST_ITEM(test_string_strcasestr)                                    \
+  NEOMUTT_TEST_ITEM(test_words_read)                                           \
   NEOMUTT_TEST_ITEM(test_addr_mbox_to_udomain)                                 \
   NEOMUTT_TEST_ITEM(test_mutt_path_tidy_slash)                                 \
   NEOMUTT_TEST_ITEM(test_mutt_path_tidy_dotdot)                                \
-  NEOMUTT_TEST_ITEM(test_mutt_path_tidy)
+  NEOMUTT_TEST_ITEM(test_mutt_path_tidy)                                       \
+  NEOMUTT_TEST_ITEM(test_mbox_reconcile_reorder)                               \
+  NEOMUTT_TEST_ITEM(test_regex_literal)                                        \
+  NEOMUTT_TEST_ITEM(test_regex_literal_excludes)                               \
+  NEOMUTT_TEST_ITEM(test_regex_exec)
 
 /******************************************************************************
  * You probably don't need to touch what follows.
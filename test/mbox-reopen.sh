@@ -0,0 +1,54 @@
+#!/bin/sh
+#
+# Reopen an mbox that has been changed by another program, while a message is
+# marked for deletion, then check that the header cache doesn't lose it.
+#
+# Usage: mbox-reopen.sh <neomutt>
+#
+# The test is skipped if NeoMutt was built without a header cache, or if
+# script(1) isn't available to give NeoMutt a terminal.
+
+NEOMUTT=$(realpath "$1")
+
+if ! "$NEOMUTT" -v | grep -q "^hcache backends: ." || ! command -v script > /dev/null; then
+    echo "mbox-reopen: skipped"
+    exit 0
+fi
+
+TMPDIR=$(mktemp -d)
+trap 'rm -rf "$TMPDIR"' EXIT
+
+for i in 1 2 3; do
+    printf "From user@example.com Mon Jan  1 00:00:00 2018\n"
+    printf "From: user@example.com\n"
+    printf "Subject: message %d\n" "$i"
+    printf "Message-ID: <%d@example.com>\n\n" "$i"
+    printf "Body of message %d\n" "$i"
+done > "$TMPDIR/mbox"
+
+cat > "$TMPDIR/neomuttrc" << RC
+set header_cache="$TMPDIR/hcache"
+set quit=yes delete=no move=no wait_key=no pipe_split=no
+set sort=mailbox-order
+RC
+
+run()
+{
+    TERM=xterm script -qec "'$NEOMUTT' -n -F '$TMPDIR/neomuttrc' -f '$TMPDIR/mbox' -e 'push \"$1\"'" \
+        /dev/null < /dev/null > /dev/null
+}
+
+# Delete the second message, lengthen the first behind NeoMutt's back, so that
+# the folder is reopened, then leave without saving
+run "<next-entry><delete-message><shell-escape>sed -i s/message.1$/message.one/ $TMPDIR/mbox<enter><refresh><exit>"
+
+# Count the messages that a fresh NeoMutt sees
+run "<tag-pattern>~A<enter><tag-prefix><pipe-message>grep -c Message-ID: > $TMPDIR/count<enter><exit>"
+
+count=$(cat "$TMPDIR/count" 2> /dev/null)
+if [ "$count" != "3" ]; then
+    echo "mbox-reopen: FAILED, expected 3 messages, found ${count:-none}"
+    exit 1
+fi
+
+echo "mbox-reopen: OK"
@@ -0,0 +1,66 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "config.h"
+#include <string.h>
+#include "mutt/mutt.h"
+#include "email/lib.h"
+#include "mbox/reconcile.h"
+
+static const char *MsgA = "From a@example.com Mon Jan  1 00:00:00 2018\n"
+                          "Subject: A\n"
+                          "\n"
+                          "first\n";
+
+static const char *MsgB = "From b@example.com Tue Jan  2 00:00:00 2018\n"
+                          "Subject: B\n"
+                          "\n"
+                          "second, a little longer\n";
+
+static struct Email *old_email(const char *msg, LOFF_T offset, int index)
+{
+  struct Email *e = mutt_email_new();
+  e->content = mutt_body_new();
+  e->offset = offset;
+  e->index = index;
+
+  size_t hdrlen = strstr(msg, "\n\n") + 2 - msg;
+  e->content->offset = offset + hdrlen;
+  mbox_set_fingerprint(e, mbox_fingerprint(msg, hdrlen));
+  return e;
+}
+
+void test_mbox_reconcile_reorder(void)
+{
+  const LOFF_T lena = strlen(MsgA);
+  const LOFF_T lenb = strlen(MsgB);
+
+  /* The folder held A, B and another program has rewritten it as B, A */
+  struct Email *ea = old_email(MsgA, 0, 0);
+  struct Email *eb = old_email(MsgB, lena, 1);
+  struct Email *old_hdrs[2] = { ea, eb };
+
+  char data[256];
+  snprintf(data, sizeof(data), "%s%s", MsgB, MsgA);
+  struct MboxMap map = { data, lena + lenb };
+
+  struct MboxReconcile *recon = mbox_reconcile_new(old_hdrs, 2, lena + lenb);
+  LOFF_T next = 0;
+
+  struct Email *e = mbox_reconcile_adopt(recon, &map, 0, 0, &next);
+  TEST_CHECK(e == eb);
+  TEST_CHECK(next == lenb);
+  TEST_CHECK(eb->offset == 0);
+
+  e = mbox_reconcile_adopt(recon, &map, next, 1, &next);
+  TEST_CHECK(e == ea);
+  TEST_CHECK(next == lena + lenb);
+  TEST_CHECK(ea->offset == lenb);
+
+  TEST_CHECK(mbox_reconcile_old_index(recon, 0) == 1);
+  TEST_CHECK(mbox_reconcile_old_index(recon, 1) == 0);
+
+  mbox_reconcile_free(&recon);
+  mutt_email_free(&ea);
+  mutt_email_free(&eb);
+}
@@ -0,0 +1,173 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include <locale.h>
+#include <regex.h>
+#include "mutt/memory.h"
+#include "mutt/regex3.h"
+#include "mutt/string2.h"
+
+static const struct
+{
+  const char *regex;   /* extended regular expression */
+  int flags;           /* flags, e.g. REG_ICASE       */
+  const char *literal; /* expected literal, or NULL   */
+} literal_data[] =
+    /* clang-format off */
+{
+  { "hello",           0,         "hello" },
+  { "Hello",           REG_ICASE, "hello" },
+  { "fo+bar.*ba?z",    0,         "bar"   },
+  { "ab*cdef",         0,         "cdef"  },
+  { "abc{2}d",         0,         "ab"    },
+  { "^re: \\[list\\]", 0,         "re: [list]" },
+  { "foo|barbaz",      0,         NULL    },
+  { "x(bar|baz)yz",    0,         "yz"    },
+  { "(abc)*de",        0,         "de"    },
+  { "[abc]+def",       0,         "def"   },
+  { "[]|x]yz",         0,         "yz"    },
+  { "[[:alpha:]]+wx",  0,         "wx"    },
+  { "a\\wbc",          0,         "bc"    },
+  { "caf\xc3\xa9s",    0,         "caf\xc3\xa9s" },
+  { "caf\xc3\xa9s",    REG_ICASE, "caf"   },
+  { "ab\xc3\xa9*",     0,         "ab"    },
+  { ".*",              0,         NULL    },
+  { "",                0,         NULL    },
+};
+/* clang-format on */
+
+void test_regex_literal(void)
+{
+  for (size_t i = 0; i < mutt_array_size(literal_data); ++i)
+  {
+    struct RegexLiteral *lit =
+        mutt_regex_literal_new(literal_data[i].regex, literal_data[i].flags);
+    const char *text = lit ? lit->text : NULL;
+    if (!TEST_CHECK(mutt_str_strcmp(text, literal_data[i].literal) == 0))
+    {
+      TEST_MSG("Regex   : %s", literal_data[i].regex);
+      TEST_MSG("Expected: %s", NONULL(literal_data[i].literal));
+      TEST_MSG("Actual  : %s", NONULL(text));
+    }
+    mutt_regex_literal_free(&lit);
+  }
+}
+
+void test_regex_literal_excludes(void)
+{
+  static const char *regexes[] = {
+    "hello", "Hello", "fo+bar.*ba?z", "x(bar|baz)yz", "re: \\[list\\]",
+    "[0-9]+ items", "w[aeiou]rld$",
+  };
+  static const char *strings[] = {
+    "hello world", "HELLO WORLD", "say Hello", "foobar baz", "fooobarbz",
+    "xbazyz", "Re: [list] news", "re: [List]", "42 items", "ITEMS",
+    "no match here", "", "wOrld", "world", "hel", "help",
+  };
+
+  for (size_t i = 0; i < mutt_array_size(regexes); ++i)
+  {
+    for (int icase = 0; icase < 2; ++icase)
+    {
+      const int flags = icase ? REG_ICASE : 0;
+      regex_t rx;
+      if (!TEST_CHECK(REGCOMP(&rx, regexes[i], flags) == 0))
+        continue;
+      struct RegexLiteral *lit = mutt_regex_literal_new(regexes[i], flags);
+      TEST_CHECK(lit != NULL);
+
+      /* The literal may only rule out strings that the regex can't match */
+      for (size_t j = 0; j < mutt_array_size(strings); ++j)
+      {
+        const bool match = (regexec(&rx, strings[j], 0, NULL, 0) == 0);
+        if (!TEST_CHECK(!match || !mutt_regex_literal_excludes(lit, strings[j])))
+        {
+          TEST_MSG("Regex : %s (flags %d)", regexes[i], flags);
+          TEST_MSG("String: %s", strings[j]);
+        }
+      }
+
+      mutt_regex_literal_free(&lit);
+      regfree(&rx);
+    }
+  }
+
+  struct RegexLiteral *lit = mutt_regex_literal_new("hello", 0);
+  TEST_CHECK(mutt_regex_literal_excludes(lit, "HELLO"));
+  TEST_CHECK(mutt_regex_literal_excludes(lit, "help"));
+  TEST_CHECK(!mutt_regex_literal_excludes(lit, "say hello"));
+  mutt_regex_literal_free(&lit);
+
+  lit = mutt_regex_literal_new("hello", REG_ICASE);
+  TEST_CHECK(!mutt_regex_literal_excludes(lit, "HELLO"));
+  TEST_CHECK(!mutt_regex_literal_excludes(lit, "hel hElLo"));
+  TEST_CHECK(mutt_regex_literal_excludes(lit, "help"));
+  mutt_regex_literal_free(&lit);
+
+  TEST_CHECK(!mutt_regex_literal_excludes(NULL, "anything"));
+}
+
+void test_regex_exec(void)
+{
+  /* Whichever engine mutt_regex_exec() uses, it must agree with regexec() */
+  static const char *regexes[] = {
+    "hello", "^re: ", "w[aeiou]rld$", "(ab|a)c?", "colou?r", "a.b", "x{2,3}",
+    "\\<word\\>", "[^a]b", "\\bfoo", "caf\xc3\xa9+", "(a)\\1", "a+?b",
+    "\\d", "[[:alpha:]]+[0-9]", "[\\.]x", "^$", "x*(xy)?", "a(bc)?(bcd)?",
+  };
+  static const char *strings[] = {
+    "hello world", "Re: hi", "re: \nre: ", "world\n", "abc", "ac", "color",
+    "colour", "xxx", "a word.", "sword", "a\nb", "\nb", "foo bar", "b foo",
+    "CAF\xc3\x89", "caf\xc3\xa9\xc3\xa9", "aa", "b", "d", "1",
+    "\xc3\xa9t\xc3\xa9" "2", "\\x", ".x", "", "\xff\xfe hello",
+    "xxy", "abcd",
+  };
+  static const int flags[] = { 0, REG_ICASE, REG_NEWLINE };
+
+  char *old = mutt_str_strdup(setlocale(LC_CTYPE, NULL));
+  setlocale(LC_CTYPE, "C.UTF-8");
+
+  for (size_t i = 0; i < mutt_array_size(regexes); ++i)
+  {
+    for (size_t f = 0; f < mutt_array_size(flags); ++f)
+    {
+      struct Regex *r = mutt_regex_compile(regexes[i], flags[f]);
+      regex_t rx;
+      if (!TEST_CHECK(r && (REGCOMP(&rx, regexes[i], flags[f]) == 0)))
+      {
+        TEST_MSG("Regex: %s", regexes[i]);
+        mutt_regex_free(&r);
+        continue;
+      }
+
+      for (size_t j = 0; j < mutt_array_size(strings); ++j)
+      {
+        for (int eflags = 0; eflags <= REG_NOTBOL; eflags += REG_NOTBOL)
+        {
+          regmatch_t expected[1], actual[1];
+          const int rc_expected = regexec(&rx, strings[j], 1, expected, eflags);
+          const int rc_actual = mutt_regex_exec(r, strings[j], 1, actual, eflags);
+          const int rc_bool = mutt_regex_exec(r, strings[j], 0, NULL, eflags);
+          if (!TEST_CHECK((rc_expected == rc_actual) && (rc_expected == rc_bool) &&
+                          ((rc_expected != 0) ||
+                           ((expected[0].rm_so == actual[0].rm_so) &&
+                            (expected[0].rm_eo == actual[0].rm_eo)))))
+          {
+            TEST_MSG("Regex   : %s (flags %d, eflags %d)", regexes[i], flags[f], eflags);
+            TEST_MSG("String  : %s", strings[j]);
+            TEST_MSG("Expected: %d [%d,%d]", rc_expected,
+                     (int) expected[0].rm_so, (int) expected[0].rm_eo);
+            TEST_MSG("Actual  : %d [%d,%d] (%d)", rc_actual,
+                     (int) actual[0].rm_so, (int) actual[0].rm_eo, rc_bool);
+          }
+        }
+      }
+
+      regfree(&rx);
+      mutt_regex_free(&r);
+    }
+  }
+
+  setlocale(LC_CTYPE, old);
+  FREE(&old);
+}
@@ -0,0 +1,66 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "config.h"
+#include <stdbool.h>
+#include "mutt/slab.h"
+
+struct SlabTest
+{
+  int number;
+  char text[20];
+};
+
+void test_slab(void)
+{
+  struct SlabPool *pool = mutt_slab_pool_new();
+  if (!TEST_CHECK(pool != NULL))
+    return;
+
+  struct SlabTest *objs[1000];
+  for (int i = 0; i < 1000; i++)
+  {
+    objs[i] = mutt_slab_alloc(pool, sizeof(struct SlabTest));
+    TEST_CHECK((objs[i]->number == 0) && (objs[i]->text[0] == '\0'));
+    objs[i]->number = i;
+  }
+  TEST_CHECK(pool->used == 1000);
+
+  /* Every object is distinct */
+  bool ok = true;
+  for (int i = 0; i < 1000; i++)
+    ok = ok && (objs[i]->number == i);
+  TEST_CHECK(ok);
+
+  /* Freed objects are reused, and come back zeroed */
+  mutt_slab_free(objs[500], sizeof(struct SlabTest));
+  struct SlabTest *obj = mutt_slab_alloc(pool, sizeof(struct SlabTest));
+  TEST_CHECK(obj == objs[500]);
+  TEST_CHECK(obj->number == 0);
+  objs[500] = obj;
+
+  mutt_slab_free(NULL, sizeof(struct SlabTest));
+  TEST_CHECK(pool->used == 1000);
+
+  /* Objects from malloc() can be freed the same way */
+  obj = mutt_slab_alloc(NULL, sizeof(struct SlabTest));
+  TEST_CHECK(obj && (obj->number == 0));
+  mutt_slab_free(obj, sizeof(struct SlabTest));
+  TEST_CHECK(pool->used == 1000);
+
+  /* A closed pool lasts until its last object is freed */
+  struct SlabPool *closed = pool;
+  mutt_slab_pool_free(&pool);
+  TEST_CHECK(pool == NULL);
+  TEST_CHECK(closed->closed && (closed->used == 1000));
+  for (int i = 0; i < 1000; i++)
+    mutt_slab_free(objs[i], sizeof(struct SlabTest));
+
+  /* An empty pool is released at once */
+  pool = mutt_slab_pool_new();
+  obj = mutt_slab_alloc(pool, sizeof(struct SlabTest));
+  mutt_slab_free(obj, sizeof(struct SlabTest));
+  TEST_CHECK(pool->used == 0);
+  mutt_slab_pool_free(&pool);
+  TEST_CHECK(pool == NULL);
+}
@@ -0,0 +1,48 @@
+#define TEST_NO_MAIN
+#include "acutest.h"
+
+#include "config.h"
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include "mutt/buffer.h"
+#include "mutt/file.h"
+#include "mutt/words.h"
+
+static void collect_word(const char *word, void *data)
+{
+  struct Buffer *buf = data;
+  mutt_buffer_addstr(buf, word);
+  mutt_buffer_addch(buf, ',');
+}
+
+static void read_words(const char *text, LOFF_T len, struct Buffer *buf)
+{
+  FILE *fp = tmpfile();
+  fputs(text, fp);
+  rewind(fp);
+  mutt_buffer_reset(buf);
+  mutt_words_read(fp, len, 3, collect_word, buf);
+  mutt_file_fclose(&fp);
+}
+
+void test_words_read(void)
+{
+  struct Buffer *buf = mutt_buffer_new();
+
+  read_words("Hello, brave World\n", 1024, buf);
+  TEST_CHECK(strcmp(buf->data, "hello,brave,world,") == 0);
+
+  /* The last word is kept when the file ends without a separator */
+  read_words("hello brave world", 1024, buf);
+  TEST_CHECK(strcmp(buf->data, "hello,brave,world,") == 0);
+
+  read_words("hello brave world", LLONG_MAX, buf);
+  TEST_CHECK(strcmp(buf->data, "hello,brave,world,") == 0);
+
+  /* Only len bytes are read, and short words are skipped */
+  read_words("an elephant world", 11, buf);
+  TEST_CHECK(strcmp(buf->data, "elephant,") == 0);
+
+  mutt_buffer_free(&buf);
+}
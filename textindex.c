@@ -0,0 +1,1135 @@
+/**
+ * @file
+ * Index of the words in local mailboxes, used by text searches
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @page textindex Index of the words in local mailboxes
+ *
+ * To find the messages matching ~b, ~B or ~h, every message has to be read,
+ * and usually decoded.  If $search_index is set, the words of each message
+ * are recorded in the header cache, the first time the mailbox is searched.
+ * Later searches only read the messages that could match.
+ *
+ * A word is a run of letters, digits or 8-bit characters, in lower case.
+ * Words shorter than #TEXTINDEX_MIN_WORD aren't indexed.  Long runs, e.g.
+ * base64, are stored as overlapping pieces, so that any part of them up to
+ * #TEXTINDEX_MAX_LOOKUP characters can still be found.
+ *
+ * A search is narrowed by the literal text of its pattern: a message is a
+ * candidate if, for each piece of the text, one of its words contains that
+ * piece.  The candidates are then searched as usual, so the index only has to
+ * be a superset of the matches.
+ *
+ * The index covers the raw and decoded header and the decoded body, i.e.
+ * everything read by a search if $thorough_search is set.  The bodies of
+ * encrypted messages, or ones that need an external viewer, aren't indexed.
+ *
+ * The index is stored as a list of segments.  The messages indexed by a
+ * search are added as a new segment.  If a message changes, it's indexed again
+ * and its old entry is ignored.  When there are too many segments, or too many
+ * unused entries, the index is rewritten as a single segment.
+ */
+
+#include "config.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "mutt/mutt.h"
+#include "email/lib.h"
+#include "mutt.h"
+#include "textindex.h"
+#include "context.h"
+#include "copy.h"
+#include "globals.h"
+#include "handler.h"
+#include "hcache/hcache.h"
+#include "mailbox.h"
+#include "mutt_parse.h"
+#include "mx.h"
+#include "ncrypt/ncrypt.h"
+#include "progress.h"
+#include "state.h"
+
+/* These Config Variables are only used in textindex.c */
+bool SearchIndex; ///< Config: (hcache) Keep an index of the words in local mailboxes
+
+/* Change this if the format of the records changes */
+#define TEXTINDEX_VERSION 2
+
+/* Shortest word that's indexed */
+#define TEXTINDEX_MIN_WORD 3
+
+/* Longer runs of characters are stored as pieces of this size... */
+#define TEXTINDEX_MAX_WORD MUTT_WORD_MAX
+
+/* ...overlapping by this much, which limits the length of a lookup */
+#define TEXTINDEX_MAX_LOOKUP (TEXTINDEX_MAX_WORD / 2)
+
+/* Rewrite the index when it has this many segments */
+#define TEXTINDEX_MAX_SEGMENTS 16
+
+/**
+ * struct TextIndexHeader - Summary record of the index of a mailbox
+ */
+struct TextIndexHeader
+{
+  unsigned int magic;      /**< Format version and config, see textindex_magic() */
+  unsigned int segments;   /**< Number of segment records */
+  unsigned int generation; /**< Incremented by every update */
+};
+
+/**
+ * struct TextDoc - An indexed message
+ */
+struct TextDoc
+{
+  char *key;      /**< Identifies the message, see email_key() */
+  uint64_t stamp; /**< File's modification time and size (Maildir, MH) */
+  bool body;      /**< The body was indexed, not just the header */
+  bool live;      /**< The message is still in the mailbox */
+};
+
+/**
+ * struct TextWord - The messages that contain a word
+ */
+struct TextWord
+{
+  const char *word;   /**< Word, owned by the words hash */
+  unsigned int *docs; /**< Documents, in ascending order */
+  size_t num;         /**< Number of documents */
+  size_t max;         /**< Size of the docs array */
+};
+
+/**
+ * struct MsgKey - The cached key of a message, see email_key()
+ */
+struct MsgKey
+{
+  struct Email *email; /**< Email the key belongs to */
+  LOFF_T offset;       /**< Email's offset when the key was computed (mbox) */
+  char *path;          /**< Email's path when the stamp was read (Maildir, MH) */
+  uint64_t stamp;      /**< File's modification time and size (Maildir, MH) */
+  char key[33];        /**< MD5 of the message, in hex (mbox) */
+};
+
+/**
+ * struct Trigram - The words that contain three characters
+ */
+struct Trigram
+{
+  unsigned int *words; /**< Word numbers, in ascending order */
+  size_t num;          /**< Number of words */
+  size_t max;          /**< Size of the words array */
+};
+
+/**
+ * struct TextIndex - Index of the words of one mailbox
+ */
+struct TextIndex
+{
+  char *path;                 /**< Mailbox's path */
+  struct TextIndexHeader hdr; /**< Summary, as stored */
+  struct TextDoc *docs;       /**< Indexed messages */
+  size_t num_docs;            /**< Number of documents */
+  size_t max_docs;            /**< Size of the docs array */
+  size_t saved_docs;          /**< Documents already stored in a segment */
+  struct Hash *keys;          /**< Message key -> document number + 1 */
+  struct Hash *words;         /**< Word -> TextWord */
+  struct TextWord **vocab;    /**< Every word, by word number */
+  size_t num_vocab;           /**< Number of words */
+  size_t max_vocab;           /**< Size of the vocab array */
+  struct Hash *trigrams;      /**< Three characters -> Trigram */
+  int *msg_docs;              /**< Document of each message, or -1 */
+  int msg_count;              /**< Number of entries in msg_docs */
+  struct MsgKey *msg_keys;    /**< Cached keys of the messages, by msgno */
+  int num_msg_keys;           /**< Number of entries in msg_keys */
+  struct timespec keys_mtime; /**< Folder's mtime when msg_keys was filled */
+  off_t keys_size;            /**< Folder's size when msg_keys was filled */
+};
+
+/* The index of the last mailbox searched */
+static struct TextIndex *LastIndex = NULL;
+
+/**
+ * textindex_magic - Identify the format of the index
+ * @retval num Magic number for the header record
+ *
+ * The decoded text depends on some config, so that's mixed in.  If it
+ * changes, the index is rebuilt.
+ */
+static unsigned int textindex_magic(void)
+{
+  struct Md5Ctx ctx;
+  unsigned int digest[4];
+  const int version = TEXTINDEX_VERSION;
+
+  mutt_md5_init_ctx(&ctx);
+  mutt_md5_process_bytes(&version, sizeof(version), &ctx);
+  mutt_md5_process(NONULL(Charset), &ctx);
+  mutt_md5_process("|", &ctx);
+  mutt_md5_process(NONULL(AssumedCharset), &ctx);
+  mutt_md5_process_bytes(&HonorDisposition, sizeof(HonorDisposition), &ctx);
+
+  struct ListNode *np = NULL;
+  STAILQ_FOREACH(np, &AlternativeOrderList, entries)
+  {
+    mutt_md5_process("|", &ctx);
+    mutt_md5_process(np->data, &ctx);
+  }
+
+  mutt_md5_finish_ctx(&ctx, digest);
+  return digest[0];
+}
+
+/**
+ * word_free - Free a TextWord - Implements ::hash_destructor_t
+ */
+static void word_free(int type, void *obj, intptr_t data)
+{
+  struct TextWord *w = obj;
+  FREE(&w->docs);
+  FREE(&w);
+}
+
+/**
+ * trigram_free - Free a Trigram - Implements ::hash_destructor_t
+ */
+static void trigram_free(int type, void *obj, intptr_t data)
+{
+  struct Trigram *t = obj;
+  FREE(&t->words);
+  FREE(&t);
+}
+
+/**
+ * msg_keys_free - Free the cached keys of the messages
+ * @param ti Index
+ */
+static void msg_keys_free(struct TextIndex *ti)
+{
+  for (int i = 0; i < ti->num_msg_keys; i++)
+    FREE(&ti->msg_keys[i].path);
+  FREE(&ti->msg_keys);
+  ti->num_msg_keys = 0;
+}
+
+/**
+ * textindex_new - Create an empty index
+ * @param path  Mailbox's path
+ * @param magic Magic number for the header
+ * @retval ptr New TextIndex
+ */
+static struct TextIndex *textindex_new(const char *path, unsigned int magic)
+{
+  struct TextIndex *ti = mutt_mem_calloc(1, sizeof(struct TextIndex));
+  ti->path = mutt_str_strdup(path);
+  ti->hdr.magic = magic;
+  ti->keys = mutt_hash_create(1024, 0);
+  ti->words = mutt_hash_create(65536, MUTT_HASH_STRDUP_KEYS);
+  mutt_hash_set_destructor(ti->words, word_free, 0);
+  ti->trigrams = mutt_hash_int_create(16384, 0);
+  mutt_hash_set_destructor(ti->trigrams, trigram_free, 0);
+  return ti;
+}
+
+/**
+ * textindex_free - Free an index
+ * @param ptr Index to free
+ */
+static void textindex_free(struct TextIndex **ptr)
+{
+  if (!ptr || !*ptr)
+    return;
+
+  struct TextIndex *ti = *ptr;
+  mutt_hash_destroy(&ti->keys);
+  mutt_hash_destroy(&ti->words);
+  mutt_hash_destroy(&ti->trigrams);
+  FREE(&ti->vocab);
+  for (size_t i = 0; i < ti->num_docs; i++)
+    FREE(&ti->docs[i].key);
+  FREE(&ti->docs);
+  FREE(&ti->msg_docs);
+  msg_keys_free(ti);
+  FREE(&ti->path);
+  FREE(ptr);
+}
+
+/**
+ * add_doc - Add a document to the index
+ * @param ti    Index
+ * @param key   Message key
+ * @param stamp Modification stamp
+ * @param body  The body is indexed
+ * @retval num Document number
+ *
+ * Any older document with the same key is replaced.
+ */
+static unsigned int add_doc(struct TextIndex *ti, const char *key, uint64_t stamp, bool body)
+{
+  if (ti->num_docs == ti->max_docs)
+  {
+    ti->max_docs = MAX(64, ti->max_docs * 2);
+    mutt_mem_realloc(&ti->docs, ti->max_docs * sizeof(struct TextDoc));
+  }
+
+  const unsigned int doc = ti->num_docs++;
+  struct TextDoc *d = &ti->docs[doc];
+  d->key = mutt_str_strdup(key);
+  d->stamp = stamp;
+  d->body = body;
+  d->live = true;
+
+  /* The key of the old document stays valid, it's only freed with the index */
+  struct HashElem *elem = mutt_hash_find_elem(ti->keys, key);
+  if (elem)
+  {
+    ti->docs[(intptr_t) elem->data - 1].live = false;
+    elem->data = (void *) (intptr_t)(doc + 1);
+  }
+  else
+    mutt_hash_insert(ti->keys, d->key, (void *) (intptr_t)(doc + 1));
+
+  return doc;
+}
+
+/**
+ * trigram_key - Pack three characters into a hash key
+ * @param s String, at least three characters long
+ * @retval num Key
+ */
+static unsigned int trigram_key(const char *s)
+{
+  return ((unsigned int) (unsigned char) s[0] << 16) |
+         ((unsigned int) (unsigned char) s[1] << 8) | (unsigned char) s[2];
+}
+
+/**
+ * add_vocab - Add a new word to the vocabulary
+ * @param ti Index
+ * @param w  Word
+ *
+ * The word is listed under each of its trigrams, so that lookups only need
+ * to check the words that share a trigram with the text.
+ */
+static void add_vocab(struct TextIndex *ti, struct TextWord *w)
+{
+  if (ti->num_vocab == ti->max_vocab)
+  {
+    ti->max_vocab = MAX(1024, ti->max_vocab * 2);
+    mutt_mem_realloc(&ti->vocab, ti->max_vocab * sizeof(struct TextWord *));
+  }
+  const unsigned int id = ti->num_vocab++;
+  ti->vocab[id] = w;
+
+  for (const char *p = w->word; p[0] && p[1] && p[2]; p++)
+  {
+    const unsigned int key = trigram_key(p);
+    struct Trigram *t = mutt_hash_int_find(ti->trigrams, key);
+    if (!t)
+    {
+      t = mutt_mem_calloc(1, sizeof(struct Trigram));
+      mutt_hash_int_insert(ti->trigrams, key, t);
+    }
+    else if ((t->num > 0) && (t->words[t->num - 1] == id))
+      continue;
+
+    if (t->num == t->max)
+    {
+      t->max = MAX(4, t->max * 2);
+      mutt_mem_realloc(&t->words, t->max * sizeof(unsigned int));
+    }
+    t->words[t->num++] = id;
+  }
+}
+
+/**
+ * add_word - Record that a document contains a word
+ * @param ti   Index
+ * @param word Word, in lower case
+ * @param doc  Document number
+ *
+ * Documents must be added in ascending order.
+ */
+static void add_word(struct TextIndex *ti, const char *word, unsigned int doc)
+{
+  struct TextWord *w = mutt_hash_find(ti->words, word);
+  if (!w)
+  {
+    w = mutt_mem_calloc(1, sizeof(struct TextWord));
+    w->word = mutt_hash_insert(ti->words, word, w)->key.strkey;
+    add_vocab(ti, w);
+  }
+  else if ((w->num > 0) && (w->docs[w->num - 1] == doc))
+    return;
+
+  if (w->num == w->max)
+  {
+    w->max = MAX(4, w->max * 2);
+    mutt_mem_realloc(&w->docs, w->max * sizeof(unsigned int));
+  }
+  w->docs[w->num++] = doc;
+}
+
+/**
+ * struct WordTarget - Where mutt_words_read() sends the words of a document
+ */
+struct WordTarget
+{
+  struct TextIndex *ti; /**< Index */
+  unsigned int doc;     /**< Document number */
+};
+
+/**
+ * index_word - Add a word to a document - Implements ::word_handler_t
+ */
+static void index_word(const char *word, void *data)
+{
+  struct WordTarget *target = data;
+  add_word(target->ti, word, target->doc);
+}
+
+/**
+ * index_stream - Add the words of a file to a document
+ * @param ti  Index
+ * @param doc Document number
+ * @param fp  File, read from the current position
+ * @param len Maximum number of bytes to read
+ */
+static void index_stream(struct TextIndex *ti, unsigned int doc, FILE *fp, LOFF_T len)
+{
+  struct WordTarget target = { ti, doc };
+  mutt_words_read(fp, len, TEXTINDEX_MIN_WORD, index_word, &target);
+}
+
+/**
+ * index_email - Add the words of an email to the index
+ * @param ti    Index
+ * @param ctx   Mailbox
+ * @param e     Email
+ * @param key   Message key
+ * @param stamp Modification stamp
+ * @retval true Success
+ */
+static bool index_email(struct TextIndex *ti, struct Context *ctx, struct Email *e,
+                        const char *key, uint64_t stamp)
+{
+  struct Message *msg = mx_msg_open(ctx, e->msgno);
+  if (!msg)
+    return false;
+
+  FILE *fp = mutt_file_mkstemp();
+  if (!fp)
+  {
+    mx_msg_close(ctx, &msg);
+    return false;
+  }
+
+  /* The same decoding as a thorough search, see search_message() */
+  mutt_parse_mime_message(ctx, e);
+  bool body = !((WithCrypto != 0) && (e->security & ENCRYPT)) &&
+              mutt_can_decode_concurrently(e->content);
+
+  mutt_copy_header(msg->fp, e, fp, CH_FROM | CH_DECODE, NULL);
+  if (body)
+  {
+    struct State s = { 0 };
+    s.fpin = msg->fp;
+    s.fpout = fp;
+    s.flags = MUTT_CHARCONV;
+    fseeko(msg->fp, e->offset, SEEK_SET);
+    mutt_body_handler(e->content, &s);
+  }
+
+  const unsigned int doc = add_doc(ti, key, stamp, body);
+
+  fseeko(msg->fp, e->offset, SEEK_SET);
+  index_stream(ti, doc, msg->fp, e->content->offset - e->offset);
+
+  fflush(fp);
+  rewind(fp);
+  index_stream(ti, doc, fp, LLONG_MAX);
+
+  mutt_file_fclose(&fp);
+  mx_msg_close(ctx, &msg);
+  return true;
+}
+
+/**
+ * mbox_content_key - Hash the text of an mbox message
+ * @param[in]  ctx Mailbox
+ * @param[in]  e   Email
+ * @param[out] buf Buffer for the key, at least 33 bytes
+ * @retval true Success
+ */
+static bool mbox_content_key(struct Context *ctx, struct Email *e, char *buf)
+{
+  struct Message *msg = mx_msg_open(ctx, e->msgno);
+  if (!msg)
+    return false;
+
+  char block[LONG_STRING * 4];
+  unsigned char digest[16];
+  struct Md5Ctx md5ctx;
+  LOFF_T left = (e->content->offset - e->offset) + e->content->length;
+  bool ok = (fseeko(msg->fp, e->offset, SEEK_SET) == 0);
+
+  mutt_md5_init_ctx(&md5ctx);
+  while (ok && (left > 0))
+  {
+    const size_t n = fread(block, 1, MIN((LOFF_T) sizeof(block), left), msg->fp);
+    if (n == 0)
+      ok = false;
+    mutt_md5_process_bytes(block, n, &md5ctx);
+    left -= n;
+  }
+  mutt_md5_finish_ctx(&md5ctx, digest);
+  mx_msg_close(ctx, &msg);
+
+  if (ok)
+    mutt_md5_toascii(digest, buf);
+  return ok;
+}
+
+/**
+ * email_key - Identify a message in the index
+ * @param[in]  ti     Index
+ * @param[in]  ctx    Mailbox
+ * @param[in]  e      Email
+ * @param[out] buf    Buffer for the key
+ * @param[in]  buflen Length of the buffer
+ * @param[out] stamp  Modification stamp
+ * @retval true Success
+ *
+ * Maildir and MH messages are identified by their file name, ignoring any
+ * Maildir flags, and the file's modification time and size.  Messages in an
+ * mbox can move, so they're identified by a hash of their text.
+ *
+ * The stamps and hashes are kept until the folder changes, so a search
+ * doesn't need to read every message again.  NeoMutt gives a Maildir message
+ * a new name when it's rewritten, and replacing an MH message changes the
+ * folder.
+ */
+static bool email_key(struct TextIndex *ti, struct Context *ctx, struct Email *e,
+                      char *buf, size_t buflen, uint64_t *stamp)
+{
+  struct Mailbox *m = ctx->mailbox;
+
+  if ((e->msgno < 0) || (e->msgno >= m->msg_count))
+    return false;
+
+  if ((ti->num_msg_keys != m->msg_count) || (ti->keys_size != m->size) ||
+      (ti->keys_mtime.tv_sec != m->mtime.tv_sec) || (ti->keys_mtime.tv_nsec != m->mtime.tv_nsec))
+  {
+    msg_keys_free(ti);
+    ti->msg_keys = mutt_mem_calloc(MAX(m->msg_count, 1), sizeof(struct MsgKey));
+    ti->num_msg_keys = m->msg_count;
+    ti->keys_size = m->size;
+    ti->keys_mtime = m->mtime;
+  }
+
+  struct MsgKey *mk = &ti->msg_keys[e->msgno];
+
+  if ((m->magic == MUTT_MAILDIR) || (m->magic == MUTT_MH))
+  {
+    if ((mk->email != e) || (mutt_str_strcmp(mk->path, e->path) != 0))
+    {
+      char path[PATH_MAX];
+      struct stat st;
+      mk->email = NULL;
+      const int plen = snprintf(path, sizeof(path), "%s/%s", m->path, e->path);
+      if ((plen < 0) || (plen >= (int) sizeof(path)) || (stat(path, &st) != 0))
+        return false;
+      mk->email = e;
+      mutt_str_replace(&mk->path, e->path);
+      mk->stamp = ((uint64_t) st.st_mtime << 32) ^ (uint64_t) st.st_size;
+    }
+
+    const char *name = strrchr(e->path, '/');
+    name = name ? name + 1 : e->path;
+    size_t len = mutt_str_strlen(name);
+    if (m->magic == MUTT_MAILDIR)
+    {
+      const char *flags = strrchr(name, ':');
+      if (flags)
+        len = flags - name;
+    }
+    snprintf(buf, buflen, "%.*s", (int) len, name);
+    *stamp = mk->stamp;
+    return true;
+  }
+
+  if (buflen < 33)
+    return false;
+
+  if ((mk->email != e) || (mk->offset != e->offset))
+  {
+    mk->email = NULL;
+    if (!mbox_content_key(ctx, e, mk->key))
+      return false;
+    mk->email = e;
+    mk->offset = e->offset;
+  }
+
+  mutt_str_strfcpy(buf, mk->key, buflen);
+  *stamp = 0;
+  return true;
+}
+
+/**
+ * blob_add - Append some bytes to a record
+ * @param buf  Record
+ * @param data Bytes to add
+ * @param len  Number of bytes
+ */
+static void blob_add(struct Buffer *buf, const void *data, size_t len)
+{
+  const size_t used = buf->dptr - buf->data;
+  if ((used + len + 1) > buf->dsize)
+    mutt_buffer_increase_size(buf, MAX(buf->dsize * 2, used + len + 1));
+  mutt_buffer_add(buf, data, len);
+}
+
+/**
+ * blob_add_num - Append a number to a record
+ * @param buf Record
+ * @param num Number to add
+ *
+ * The number is stored in 7-bit groups, least significant first.
+ */
+static void blob_add_num(struct Buffer *buf, uint64_t num)
+{
+  unsigned char tmp[10];
+  size_t len = 0;
+
+  do
+  {
+    tmp[len] = num & 0x7f;
+    num >>= 7;
+    if (num)
+      tmp[len] |= 0x80;
+    len++;
+  } while (num);
+
+  blob_add(buf, tmp, len);
+}
+
+/**
+ * blob_get_num - Read a number from a record
+ * @param[in]  d   Record
+ * @param[in]  len Length of the record
+ * @param[out] off Current offset, updated
+ * @param[out] num Number read
+ * @retval true Success
+ */
+static bool blob_get_num(const unsigned char *d, size_t len, size_t *off, uint64_t *num)
+{
+  *num = 0;
+  for (int shift = 0; (*off < len) && (shift < 64); shift += 7)
+  {
+    const unsigned char c = d[(*off)++];
+    *num |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return true;
+  }
+  return false;
+}
+
+/**
+ * segment_dump - Write some documents as a segment record
+ * @param ti    Index
+ * @param first First document to store
+ * @param buf   Buffer for the record
+ *
+ * Format:
+ * - number of documents
+ * - for each document: key length, key, stamp, whether the body is indexed
+ * - for each word: length, word, number of documents, document numbers as
+ *   differences, relative to the start of the segment
+ * - a zero-length word
+ */
+static void segment_dump(struct TextIndex *ti, size_t first, struct Buffer *buf)
+{
+  blob_add_num(buf, ti->num_docs - first);
+  for (size_t i = first; i < ti->num_docs; i++)
+  {
+    const size_t len = mutt_str_strlen(ti->docs[i].key);
+    blob_add_num(buf, len);
+    blob_add(buf, ti->docs[i].key, len);
+    blob_add_num(buf, ti->docs[i].stamp);
+    blob_add_num(buf, ti->docs[i].body);
+  }
+
+  struct HashWalkState state = { 0 };
+  struct HashElem *elem = NULL;
+  while ((elem = mutt_hash_walk(ti->words, &state)))
+  {
+    const struct TextWord *w = elem->data;
+
+    /* The segment's documents are at the end of the list */
+    size_t start = w->num;
+    while ((start > 0) && (w->docs[start - 1] >= first))
+      start--;
+    if (start == w->num)
+      continue;
+
+    const size_t len = mutt_str_strlen(elem->key.strkey);
+    blob_add_num(buf, len);
+    blob_add(buf, elem->key.strkey, len);
+    blob_add_num(buf, w->num - start);
+    unsigned int prev = first;
+    for (size_t i = start; i < w->num; i++)
+    {
+      blob_add_num(buf, w->docs[i] - prev);
+      prev = w->docs[i];
+    }
+  }
+  blob_add_num(buf, 0);
+}
+
+/**
+ * segment_restore - Read a segment record into the index
+ * @param ti  Index
+ * @param d   Record
+ * @param len Length of the record
+ * @retval true Success
+ */
+static bool segment_restore(struct TextIndex *ti, const unsigned char *d, size_t len)
+{
+  char word[TEXTINDEX_MAX_WORD + 1];
+  size_t off = 0;
+  uint64_t count = 0;
+  uint64_t num = 0;
+
+  const unsigned int first = ti->num_docs;
+  if (!blob_get_num(d, len, &off, &count) || (count > len))
+    return false;
+
+  for (uint64_t i = 0; i < count; i++)
+  {
+    uint64_t stamp = 0;
+    uint64_t body = 0;
+    if (!blob_get_num(d, len, &off, &num) || (num >= sizeof(word)) || (num > (len - off)))
+      return false;
+    memcpy(word, d + off, num);
+    word[num] = '\0';
+    off += num;
+    if (!blob_get_num(d, len, &off, &stamp) || !blob_get_num(d, len, &off, &body))
+      return false;
+    add_doc(ti, word, stamp, body);
+  }
+
+  while (true)
+  {
+    if (!blob_get_num(d, len, &off, &num) || (num >= sizeof(word)) || (num > (len - off)))
+      return false;
+    if (num == 0)
+      return true;
+    memcpy(word, d + off, num);
+    word[num] = '\0';
+    off += num;
+
+    if (!blob_get_num(d, len, &off, &count))
+      return false;
+    unsigned int doc = first;
+    for (uint64_t i = 0; i < count; i++)
+    {
+      if (!blob_get_num(d, len, &off, &num) || (num >= (ti->num_docs - doc)))
+        return false;
+      doc += num;
+      add_word(ti, word, doc);
+    }
+  }
+}
+
+/**
+ * textindex_load - Read the index of a mailbox from the header cache
+ * @param hc   Header cache
+ * @param path Mailbox's path
+ * @retval ptr Index, possibly empty
+ */
+static struct TextIndex *textindex_load(header_cache_t *hc, const char *path)
+{
+  struct TextIndex *ti = textindex_new(path, textindex_magic());
+  struct TextIndexHeader hdr = { 0 };
+  char key[32];
+
+  size_t dlen = 0;
+  void *data = mutt_hcache_fetch_raw(hc, "/text", 5, &dlen);
+  if (!data)
+    return ti;
+  bool ok = (dlen == sizeof(hdr));
+  if (ok)
+    memcpy(&hdr, data, sizeof(hdr));
+  mutt_hcache_free(hc, &data);
+
+  ok = ok && (hdr.magic == ti->hdr.magic);
+  for (unsigned int i = 0; ok && (i < hdr.segments); i++)
+  {
+    snprintf(key, sizeof(key), "/text/%u", i);
+    data = mutt_hcache_fetch_raw(hc, key, strlen(key), &dlen);
+    /* The record starts with the length of the segment */
+    unsigned int len = 0;
+    ok = data && (dlen >= sizeof(len));
+    if (ok)
+    {
+      memcpy(&len, data, sizeof(len));
+      ok = (len <= (dlen - sizeof(len))) &&
+           segment_restore(ti, (unsigned char *) data + sizeof(len), len);
+    }
+    mutt_hcache_free(hc, &data);
+  }
+
+  if (!ok)
+  {
+    mutt_debug(1, "discarding the search index of %s\n", path);
+    textindex_free(&ti);
+    ti = textindex_new(path, textindex_magic());
+    for (unsigned int i = 0; i < hdr.segments; i++)
+    {
+      snprintf(key, sizeof(key), "/text/%u", i);
+      mutt_hcache_delete(hc, key, strlen(key));
+    }
+    mutt_hcache_delete(hc, "/text", 5);
+    return ti;
+  }
+
+  ti->hdr = hdr;
+  ti->saved_docs = ti->num_docs;
+  mutt_debug(2, "search index of %s: %zu documents in %u segments\n", path,
+             ti->num_docs, hdr.segments);
+  return ti;
+}
+
+/**
+ * textindex_compact - Drop the documents of messages that have gone
+ * @param ti Index
+ *
+ * The documents are renumbered, so the whole index must be stored again.
+ */
+static void textindex_compact(struct TextIndex *ti)
+{
+  unsigned int *map = mutt_mem_malloc(MAX(ti->num_docs, 1) * sizeof(unsigned int));
+  size_t num = 0;
+
+  mutt_hash_destroy(&ti->keys);
+  ti->keys = mutt_hash_create(MAX(ti->num_docs, 1024), 0);
+  for (size_t i = 0; i < ti->num_docs; i++)
+  {
+    if (!ti->docs[i].live)
+    {
+      map[i] = UINT_MAX;
+      FREE(&ti->docs[i].key);
+      continue;
+    }
+    map[i] = num;
+    ti->docs[num] = ti->docs[i];
+    mutt_hash_insert(ti->keys, ti->docs[num].key, (void *) (intptr_t)(num + 1));
+    num++;
+  }
+  ti->num_docs = num;
+
+  /* Words that are left with no documents are skipped by segment_dump() */
+  struct HashWalkState state = { 0 };
+  struct HashElem *elem = NULL;
+  while ((elem = mutt_hash_walk(ti->words, &state)))
+  {
+    struct TextWord *w = elem->data;
+    size_t n = 0;
+    for (size_t i = 0; i < w->num; i++)
+      if (map[w->docs[i]] != UINT_MAX)
+        w->docs[n++] = map[w->docs[i]];
+    w->num = n;
+  }
+
+  for (int i = 0; i < ti->msg_count; i++)
+    if (ti->msg_docs[i] >= 0)
+      ti->msg_docs[i] = map[ti->msg_docs[i]];
+
+  FREE(&map);
+  ti->saved_docs = 0;
+}
+
+/**
+ * textindex_save - Store the new documents in the header cache
+ * @param ti Index
+ * @param hc Header cache
+ */
+static void textindex_save(struct TextIndex *ti, header_cache_t *hc)
+{
+  size_t dead = 0;
+  for (size_t i = 0; i < ti->num_docs; i++)
+    if (!ti->docs[i].live)
+      dead++;
+
+  const unsigned int old_segments = ti->hdr.segments;
+  if (((ti->hdr.segments + 1) >= TEXTINDEX_MAX_SEGMENTS) || ((dead * 2) > ti->num_docs))
+  {
+    textindex_compact(ti);
+    ti->hdr.segments = 0;
+  }
+  else if (ti->saved_docs == ti->num_docs)
+    return;
+
+  struct Buffer buf;
+  mutt_buffer_init(&buf);
+  unsigned int len = 0;
+  blob_add(&buf, &len, sizeof(len));
+  segment_dump(ti, ti->saved_docs, &buf);
+  len = (buf.dptr - buf.data) - sizeof(len);
+  memcpy(buf.data, &len, sizeof(len));
+
+  char key[32];
+  mutt_hcache_begin(hc);
+  snprintf(key, sizeof(key), "/text/%u", ti->hdr.segments);
+  mutt_hcache_store_raw(hc, key, strlen(key), buf.data, buf.dptr - buf.data);
+  for (unsigned int i = ti->hdr.segments + 1; i < old_segments; i++)
+  {
+    snprintf(key, sizeof(key), "/text/%u", i);
+    mutt_hcache_delete(hc, key, strlen(key));
+  }
+  ti->hdr.segments++;
+  ti->hdr.generation++;
+  mutt_hcache_store_raw(hc, "/text", 5, &ti->hdr, sizeof(ti->hdr));
+  mutt_hcache_commit(hc);
+
+  mutt_debug(2, "stored %zu documents of the search index, %zu bytes\n",
+             ti->num_docs - ti->saved_docs, (size_t)(buf.dptr - buf.data));
+  ti->saved_docs = ti->num_docs;
+  FREE(&buf.data);
+}
+
+/**
+ * textindex_update - Index any new or changed messages
+ * @param ti  Index
+ * @param ctx Mailbox
+ * @retval  0 Success
+ * @retval -1 The user interrupted the indexing
+ */
+static int textindex_update(struct TextIndex *ti, struct Context *ctx)
+{
+  struct Mailbox *m = ctx->mailbox;
+  char key[PATH_MAX];
+  uint64_t stamp = 0;
+  int todo = 0;
+
+  FREE(&ti->msg_docs);
+  ti->msg_count = m->msg_count;
+  ti->msg_docs = mutt_mem_malloc(MAX(m->msg_count, 1) * sizeof(int));
+
+  for (size_t i = 0; i < ti->num_docs; i++)
+    ti->docs[i].live = false;
+
+  for (int i = 0; i < m->msg_count; i++)
+  {
+    ti->msg_docs[i] = -1;
+    if (!email_key(ti, ctx, m->hdrs[i], key, sizeof(key), &stamp))
+      continue;
+
+    const intptr_t doc = (intptr_t) mutt_hash_find(ti->keys, key);
+    if ((doc > 0) && (ti->docs[doc - 1].stamp == stamp))
+    {
+      ti->msg_docs[i] = doc - 1;
+      ti->docs[doc - 1].live = true;
+    }
+    else
+      todo++;
+  }
+
+  if (todo == 0)
+    return 0;
+
+  struct Progress progress;
+  mutt_progress_init(&progress, _("Indexing messages..."), MUTT_PROGRESS_MSG, ReadInc, todo);
+
+  int done = 0;
+  for (int i = 0; i < m->msg_count; i++)
+  {
+    if (ti->msg_docs[i] >= 0)
+      continue;
+
+    if (SigInt == 1)
+      return -1;
+
+    mutt_progress_update(&progress, done++, -1);
+    struct Email *e = m->hdrs[i];
+    if (!email_key(ti, ctx, e, key, sizeof(key), &stamp))
+      continue;
+    if (index_email(ti, ctx, e, key, stamp))
+      ti->msg_docs[i] = ti->num_docs - 1;
+  }
+
+  return 0;
+}
+
+/**
+ * mutt_textindex_open - Get the index of a mailbox, indexing any new messages
+ * @param ctx Mailbox
+ * @retval ptr  Up to date index, owned by this module
+ * @retval NULL No index, or the user interrupted the indexing
+ *
+ * The index is cached until another mailbox is searched.  It's read again if
+ * another process has changed it.
+ */
+struct TextIndex *mutt_textindex_open(struct Context *ctx)
+{
+  struct Mailbox *m = ctx->mailbox;
+
+  if (!SearchIndex || !HeaderCache || !*HeaderCache)
+    return NULL;
+  if ((m->magic != MUTT_MBOX) && (m->magic != MUTT_MMDF) &&
+      (m->magic != MUTT_MAILDIR) && (m->magic != MUTT_MH))
+  {
+    return NULL;
+  }
+
+  header_cache_t *hc = mutt_hcache_open(HeaderCache, m->path, NULL);
+  if (!hc)
+    return NULL;
+
+  struct TextIndex *ti = LastIndex;
+  if (ti)
+  {
+    struct TextIndexHeader hdr = { 0 };
+    size_t dlen = 0;
+    void *data = mutt_hcache_fetch_raw(hc, "/text", 5, &dlen);
+    if (data && (dlen == sizeof(hdr)))
+      memcpy(&hdr, data, sizeof(hdr));
+    mutt_hcache_free(hc, &data);
+
+    if ((mutt_str_strcmp(ti->path, m->path) != 0) || (ti->hdr.magic != textindex_magic()) ||
+        (hdr.magic != ti->hdr.magic) || (hdr.generation != ti->hdr.generation))
+    {
+      textindex_free(&LastIndex);
+    }
+  }
+
+  if (!LastIndex)
+    LastIndex = textindex_load(hc, m->path);
+  ti = LastIndex;
+
+  const int rc = textindex_update(ti, ctx);
+  textindex_save(ti, hc);
+  mutt_hcache_close(hc);
+
+  return (rc == 0) ? ti : NULL;
+}
+
+/**
+ * mutt_textindex_lookup - Find the messages that may contain some text
+ * @param ti   Index, from mutt_textindex_open()
+ * @param text Text that's being searched for
+ * @param body The search includes the body of the message
+ * @retval ptr  Array with an entry per message: 1 if it may contain the text
+ * @retval NULL The text has no words that can be looked up
+ *
+ * Only the runs of letters and digits of the text are used, ignoring case.
+ * Messages that aren't indexed are always candidates.  The caller must free
+ * the array.
+ */
+unsigned char *mutt_textindex_lookup(struct TextIndex *ti, const char *text, bool body)
+{
+  if (!ti || !text)
+    return NULL;
+
+  const size_t bytes = (ti->num_docs + 7) / 8;
+  unsigned char *found = NULL;
+  unsigned char *piece_found = NULL;
+  char piece[TEXTINDEX_MAX_LOOKUP + 1];
+
+  for (const char *p = text; *p;)
+  {
+    size_t len = 0;
+    for (; isascii(*p) && isalnum(*p); p++)
+      if (len < TEXTINDEX_MAX_LOOKUP)
+        piece[len++] = tolower(*p);
+    if (len == 0)
+    {
+      p++;
+      continue;
+    }
+    if (len < TEXTINDEX_MIN_WORD)
+      continue;
+    piece[len] = '\0';
+
+    if (!piece_found)
+      piece_found = mutt_mem_malloc(MAX(bytes, 1));
+    memset(piece_found, 0, MAX(bytes, 1));
+
+    /* Any word that contains the piece is listed under its rarest trigram */
+    const struct Trigram *rarest = NULL;
+    for (size_t i = 0; (i + 2) < len; i++)
+    {
+      const struct Trigram *t = mutt_hash_int_find(ti->trigrams, trigram_key(piece + i));
+      if (!t)
+      {
+        rarest = NULL;
+        break;
+      }
+      if (!rarest || (t->num < rarest->num))
+        rarest = t;
+    }
+
+    for (size_t i = 0; rarest && (i < rarest->num); i++)
+    {
+      const struct TextWord *w = ti->vocab[rarest->words[i]];
+      if (!strstr(w->word, piece))
+        continue;
+      for (size_t j = 0; j < w->num; j++)
+        piece_found[w->docs[j] / 8] |= (1 << (w->docs[j] % 8));
+    }
+
+    if (found)
+    {
+      for (size_t i = 0; i < bytes; i++)
+        found[i] &= piece_found[i];
+    }
+    else
+    {
+      found = piece_found;
+      piece_found = NULL;
+    }
+  }
+  FREE(&piece_found);
+
+  if (!found)
+    return NULL;
+
+  unsigned char *cands = mutt_mem_malloc(MAX(ti->msg_count, 1));
+  for (int i = 0; i < ti->msg_count; i++)
+  {
+    const int doc = ti->msg_docs[i];
+    cands[i] = (doc < 0) || (body && !ti->docs[doc].body) ||
+               (found[doc / 8] & (1 << (doc % 8)));
+  }
+  FREE(&found);
+
+  return cands;
+}
+
+/**
+ * mutt_textindex_cleanup - Free the cached index
+ */
+void mutt_textindex_cleanup(void)
+{
+  textindex_free(&LastIndex);
+}
@@ -0,0 +1,35 @@
+/**
+ * @file
+ * Index of the words in local mailboxes, used by text searches
+ *
+ * @copyright
+ * This program is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 2 of the License, or (at your option) any later
+ * version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MUTT_TEXTINDEX_H
+#define MUTT_TEXTINDEX_H
+
+#include <stdbool.h>
+
+struct Context;
+struct TextIndex;
+
+/* These Config Variables are only used in textindex.c */
+extern bool SearchIndex;
+
+void              mutt_textindex_cleanup(void);
+unsigned char *   mutt_textindex_lookup(struct TextIndex *ti, const char *text, bool body);
+struct TextIndex *mutt_textindex_open(struct Context *ctx);
+
+#endif /* MUTT_TEXTINDEX_H */
@@ -46,6 +46,7 @@
 const char *mutt_make_version(void);
 /* #include "hcache/hcache.h" */
 const char *mutt_hcache_backend_list(void);
+const char *mutt_hcache_compress_list(void);
 
 const int SCREEN_WIDTH = 80;
 
@@ -255,6 +256,11 @@ static struct CompileOptions comp_opts[] = {
 #else
   { "openssl", 0 },
 #endif
+#ifdef USE_PCRE2
+  { "pcre2", 1 },
+#else
+  { "pcre2", 0 },
+#endif
 #ifdef CRYPT_BACKEND_CLASSIC_PGP
   { "pgp", 1 },
 #else
@@ -400,6 +406,10 @@ void print_version(void)
   const char *backends = mutt_hcache_backend_list();
   printf("\nhcache backends: %s", backends);
   FREE(&backends);
+  const char *compression = mutt_hcache_compress_list();
+  if (compression)
+    printf("\nhcache compression: %s", compression);
+  FREE(&compression);
 #endif
 
   puts("\n\nCompiler:");